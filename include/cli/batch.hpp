@@ -0,0 +1,7 @@
+#ifndef BATCH_HPP
+#define BATCH_HPP
+
+// Runs the files of the command line and gives the exit status.
+int run_batch(int argc, char** argv);
+
+#endif // BATCH_HPP
@@ -0,0 +1,8 @@
+#ifndef FUZZ_HPP
+#define FUZZ_HPP
+
+// 'scripting fuzz COUNT [--seed=INTEGER] [run arguments]' generates programs and runs each
+// one in the evaluator, the virtual machine and the JIT. Gives 1 when they disagree.
+int run_fuzz(int argc, char** argv);
+
+#endif // FUZZ_HPP
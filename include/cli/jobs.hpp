@@ -0,0 +1,25 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A 'run ... &' running on its own thread while the REPL takes more input.
+struct Job
+{
+   size_t id = 0;
+   std::string command;
+   std::atomic<bool> cancel = false;
+   std::atomic<bool> finished = false;
+   std::thread thread;
+};
+
+// Runs the 'run' command on a new thread as job 'id'.
+void start_job(std::vector<std::unique_ptr<Job>>& jobs, size_t id, std::string command);
+void reap_jobs(std::vector<std::unique_ptr<Job>>& jobs);
+void stop_jobs(std::vector<std::unique_ptr<Job>>& jobs);
+
+#endif // JOBS_HPP
@@ -0,0 +1,44 @@
+#ifndef RUN_HPP
+#define RUN_HPP
+
+#include "errors/catcher.hpp"
+#include "io/args.hpp"
+#include "optimizer/pass_manager.hpp"
+#include "parser/ast.hpp"
+#include "parser/flat_ast.hpp"
+#include "pipeline/back_end.hpp"
+#include "runtime/columnar.hpp"
+#include "runtime/value.hpp"
+#include "script/script.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// What running a program measured, for '--bench'.
+struct Execution
+{
+   bool compiled = false;
+   long compile_time = 0;
+   long time = 0;
+   size_t evaluated = 0;
+   size_t registers = 0;
+   bool jitted = false;
+   size_t regions = 0;
+   size_t native_statements = 0;
+   size_t native_code = 0;
+   bool columnar = false;
+   bool vectorized = false;
+   size_t instructions = 0;
+};
+
+bool parse_inputs(Catcher& catcher, Args& args, std::vector<ColumnarProgram::Binding>& inputs);
+std::optional<FlatProgram> compile_back_end(Catcher& catcher, Args& args, Program& program, const std::vector<ColumnarProgram::Binding>& inputs, PassManager& passes, BackEnd::Times* times = nullptr);
+bool parse_precision(Catcher& catcher, Args& args);
+ScriptOptions script_options(Args& args, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs);
+std::vector<Value> run_inputs(const std::vector<ColumnarProgram::Binding>& inputs, std::uint64_t run);
+bool execute(Catcher& catcher, Args& args, FlatView view, const std::vector<ColumnarProgram::Binding>& inputs, Execution& execution);
+// 'run FILE.q [run arguments]', also what a batch or a job runs.
+void run_file(Catcher& catcher, Args& args);
+
+#endif // RUN_HPP
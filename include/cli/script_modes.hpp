@@ -0,0 +1,21 @@
+#ifndef SCRIPT_MODES_HPP
+#define SCRIPT_MODES_HPP
+
+#include "errors/catcher.hpp"
+#include "io/args.hpp"
+#include "runtime/columnar.hpp"
+#include "runtime/value.hpp"
+#include "script/script.hpp"
+#include <string>
+#include <vector>
+
+// Ways of running a file through the script library instead of the stages one by one:
+// '--load', '--green' and '--stress'.
+bool run_load(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs);
+bool run_green(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs);
+// What a run of a script gives: its '#log' output, errors and variables. Runs the shared
+// script too when there is one.
+std::string script_fingerprint(const std::string& source, const ScriptOptions& options, const CompiledScript* shared, const std::vector<Value>& inputs);
+bool run_stress(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs);
+
+#endif // SCRIPT_MODES_HPP
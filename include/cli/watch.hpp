@@ -0,0 +1,9 @@
+#ifndef WATCH_HPP
+#define WATCH_HPP
+
+#include "errors/catcher.hpp"
+#include "io/args.hpp"
+
+void watch_file(Catcher& catcher, Args& args);
+
+#endif // WATCH_HPP
@@ -0,0 +1,20 @@
+#ifndef CANCELLATION_HPP
+#define CANCELLATION_HPP
+
+#include <atomic>
+
+// Flag of the REPL job running on this thread, nullptr when it cannot be cancelled.
+// Another thread sets it to cancel the job. The lexer, the preprocessor, the parsers and
+// the runtimes check it between units of work and stop like on an error, everything the
+// job allocated is released as it unwinds.
+//
+// Like the precision every thread has its own, threads that work on a job start with the
+// flag of the thread that started them.
+inline thread_local const std::atomic<bool>* cancel_flag = nullptr;
+
+inline bool cancelled()
+{
+   return cancel_flag && cancel_flag->load(std::memory_order_relaxed);
+}
+
+#endif // CANCELLATION_HPP
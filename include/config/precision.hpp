@@ -0,0 +1,42 @@
+#ifndef PRECISION_HPP
+#define PRECISION_HPP
+
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+enum class Precision : std::int8_t
+{ double_real, long_real };
+
+// How reals are stored in the AST, the flat AST, Value and the cache. Doubles unless the
+// build defines REAL_LONG_DOUBLE, which makes room for '--real=long' at the price of
+// 16-byte reals that are computed on the x87 unit.
+#ifdef REAL_LONG_DOUBLE
+using real_t = long double;
+#else
+using real_t = double;
+#endif
+
+constexpr bool long_reals_stored = !std::is_same_v<real_t, double>;
+
+// Precision of reals for the current run, selected with '--real=double|long'. In double
+// mode every real is parsed, converted and computed as a double, whatever real_t is.
+//
+// Every thread has its own, so scripts with different precisions can run at once.
+// Threads that work on a run start with the precision of the thread that started them.
+inline thread_local Precision real_precision = Precision::double_real;
+
+inline real_t round_real(real_t real)
+{
+   return (real_precision == Precision::double_real ? static_cast<double>(real) : real);
+}
+
+// Throws like std::stod when the lexeme is not a number or out of range.
+inline real_t parse_real(const std::string& lexeme)
+{
+   if (real_precision == Precision::double_real || !long_reals_stored)
+      return std::stod(lexeme);
+   return static_cast<real_t>(std::stold(lexeme));
+}
+
+#endif // PRECISION_HPP
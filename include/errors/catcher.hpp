@@ -1,21 +1,29 @@
 #ifndef CATCHER_HPP
 #define CATCHER_HPP
 
+#include <functional>
 #include <vector>
 
+// Called with every error message instead of printing it.
+using ErrorSink = std::function<void(const char* error)>;
+
 class Catcher
 {
 public:
    Catcher() = default;
    ~Catcher() = default;
 
+   void specify_error_sink(ErrorSink error_sink);
+
    void insert(const char* error);
    void error(const char* error);
+   void merge(Catcher& other);
    bool empty() const;
    bool display();
 
 private:
    std::vector<const char*> errors;
+   ErrorSink error_sink;
 };
 
 #endif // CATCHER_HPP
@@ -8,11 +8,24 @@ namespace err
    // REPL errors
    error invalid_run_command = "Invalid run command, expected the second argument to be a valid file.";
    error invalid_cat_command = "Invalid cat command, expected the second argument to be a valid file.";
+   error invalid_watch_command = "Invalid watch command, expected the second argument to be a valid file.";
+   error invalid_cancel_command = "Invalid cancel command, expected the number of a running job.";
+   error job_cancelled = "The job was cancelled.";
+   error background_stdin = "A job in the background cannot read the input, the REPL reads it.";
+   error invalid_batch_command = "Invalid command, expected 'run' followed by files, directories and run arguments.";
+   error invalid_batch_file = "Invalid file, expected a script or a directory of scripts.";
+   error watch_unavailable = "Watching files needs inotify, which is only available on Linux.";
+   error stress_mismatch = "A thread got a different result than the script alone, with the same engine and precision.";
+   error invalid_fuzz_command = "Invalid command, expected 'fuzz' followed by the number of programs and run arguments.";
+   error fuzz_mismatch = "A generated program gave a different result in the virtual machine or the JIT than in the evaluator.";
 
    // Argument errors
    error out_of_bounds_arg = "Tried to access out of bounds argument.";
    error arg_redefined = "Argument appears more than once in the input.";
    error invalid_run_arg = "Invalid run argument value, expected an integer.";
+   error invalid_real_arg = "Invalid '--real' value, expected 'double' or 'long'.";
+   error long_real_unavailable = "'--real=long' needs a build with REAL_LONG_DOUBLE, this one stores reals as doubles.";
+   error invalid_pass_arg = "Invalid optimization pass, expected 'fold', 'propagate', 'simplify' or 'dead'.";
 
    // File errors
    error invalid_input = "Invalid input.";
@@ -64,6 +77,39 @@ namespace err
    error expected_equals_or_semicolon = "Expected a ';' or '=' after variable declaration identifier.";
    error expected_var_body = "Expected the immutable/constant variable to have a body.";
    error auto_must_have_body = "Automatic variable must have an initial variable body.";
+
+   // Operator errors
+   error division_by_zero = "Division by zero.";
+   error integer_overflow = "Integer overflow.";
+   error invalid_shift = "Invalid shift amount, expected a value between 0 and 63.";
+   error invalid_operands = "Invalid operand types for the operator.";
+
+   // Resolver errors
+   error undefined_variable = "Tried to use a variable that was not declared.";
+   error con_shadowing = "Tried to shadow a constant variable.";
+   error immutable_assignment = "Tried to change an immutable variable, declare it with 'mut' to allow changes.";
+   error invalid_assignment_target = "Expected a variable on the left side of the assignment.";
+
+   // Evaluator errors
+   error uninitialized_variable = "Tried to use a mutable variable before assigning a value to it.";
+   error type_mismatch = "Value does not match the declared type of the variable.";
+
+   // Columnar errors
+   error columnar_unsupported = "Columnar evaluation only supports int, real and bool values, declarations with a value, and assignments and '++'/'--' as statements.";
+   error columnar_long_real = "Columnar evaluation only supports '--real=double'.";
+   error invalid_inputs_arg = "Invalid '--inputs' value, expected a comma separated list of NAME:TYPE with the types int, real or bool.";
+
+   // Record errors
+   error invalid_record_format_arg = "Invalid '--record-format' value, expected 'csv' or 'ndjson'.";
+   error cannot_create_file = "Could not create the given output file.";
+   error missing_record_column = "The CSV header does not have a column for every '--inputs' variable.";
+   error invalid_record = "Invalid record, expected a line of CSV or a JSON object with a value of the right type for every '--inputs' variable.";
+
+   // Script errors
+   error invalid_script_inputs = "Expected a value for every input of the script.";
+   error operation_budget_exceeded = "The script was stopped after executing as many operations as its limit allows.";
+   error time_budget_exceeded = "The script was stopped after running for as long as its limit allows.";
+   error memory_budget_exceeded = "The script was stopped for allocating more memory than its limit allows.";
 } // namespace err
 
 #undef error
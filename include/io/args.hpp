@@ -15,12 +15,14 @@ public:
    size_t size() const;
    bool contains(const std::string& argument) const;
    size_t get_arg(const std::string& argument) const;
+   const std::string& get_word(const std::string& argument) const;
    std::string& at(size_t index);
 
 private:
    Catcher& catcher;
    std::string& command;
    std::map<std::string, size_t> args;
+   std::map<std::string, std::string> words;
    std::map<size_t, std::string> indexes;
 };
 
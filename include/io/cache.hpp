@@ -0,0 +1,49 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include "io/args.hpp"
+#include "io/files.hpp"
+#include "parser/flat_ast.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+std::uint64_t hash_bytes(std::string_view bytes, std::uint64_t seed = 14695981039346656037ull);
+std::string cache_options(Args& args);
+
+// On-disk cache of compiled scripts, stored as a flat AST that is mapped and used
+// in place. An entry is keyed by the source, the file name, the run arguments and
+// the version, and is only used while every file the script pulled in is unchanged.
+class ScriptCache
+{
+public:
+   ScriptCache(const std::string& source, const std::string& file, const std::string& options);
+   ~ScriptCache();
+
+   ScriptCache(const ScriptCache&) = delete;
+   ScriptCache& operator=(const ScriptCache&) = delete;
+
+   bool load();
+   void store(const FlatProgram& flat, const std::unordered_set<std::string>& files, const std::string& log) const;
+
+   const FlatView& view() const;
+   std::string_view log() const;
+
+private:
+   std::uint64_t key;
+   fs::path path;
+
+   FlatView flat;
+   std::string_view logged;
+
+   void* mapping = nullptr;
+   size_t mapping_size = 0;
+   std::unique_ptr<char[]> buffer;
+
+   bool parse(const char* bytes, size_t size);
+   void unmap();
+};
+
+#endif // CACHE_HPP
@@ -3,10 +3,13 @@
 
 #include "errors/catcher.hpp"
 #include <filesystem>
+#include <vector>
 
 namespace fs = std::filesystem;
 
 bool is_file(const fs::path& path);
 std::string read_file(Catcher& catcher, const fs::path& path);
+// Every '.q' file in the directory and the ones below it, sorted.
+std::vector<fs::path> script_files(const fs::path& directory);
 
 #endif // FILES_HPP
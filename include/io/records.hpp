@@ -0,0 +1,88 @@
+#ifndef RECORDS_HPP
+#define RECORDS_HPP
+
+#include "errors/catcher.hpp"
+#include "runtime/columnar.hpp"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class RecordFormat
+{
+   csv, ndjson
+};
+
+// Hands out the input a chunk of whole lines at a time. Regular files are mapped into
+// memory where mmap is available and chunks point into the mapping, everything else
+// (pipes, '-' for the standard input) is read into the buffer of the chunk. A file that
+// cannot be opened leaves an error in the catcher.
+class RecordReader
+{
+public:
+   RecordReader(Catcher& catcher, const std::string& path);
+   ~RecordReader();
+
+   RecordReader(const RecordReader&) = delete;
+   RecordReader& operator=(const RecordReader&) = delete;
+
+   // The next line without its newline, false at the end of the input.
+   bool line(std::string& line);
+   // The next chunk of at least one line, 'buffer' must live as long as 'text' is used.
+   bool next(std::string& buffer, std::string_view& text);
+
+private:
+   const char* mapped = nullptr;
+   size_t mapped_size = 0;
+   size_t position = 0;
+   std::ifstream file;
+   std::istream* stream = nullptr;
+   std::string carry;
+
+   static constexpr size_t chunk_size = 1 << 20;
+};
+
+// Runs a compiled columnar program over CSV or NDJSON records, one record a line, and
+// writes the outputs of every record in the same format and order. Inputs are taken
+// from the CSV column or the NDJSON key with their name.
+//
+// The calling thread reads chunks of lines and writes the finished ones in order, a
+// pool of workers parses, evaluates and formats them. The first record that fails
+// stops the run, the records before it are written.
+class RecordStream
+{
+public:
+   RecordStream(Catcher& catcher, const ColumnarProgram& program, RecordFormat format, size_t jobs);
+   ~RecordStream() = default;
+
+   bool run(RecordReader& reader, std::FILE* output);
+   size_t record_count() const;
+
+private:
+   struct Chunk
+   {
+      std::string buffer;
+      std::string_view text;
+      std::string output;
+      const char* error = nullptr;
+      size_t records = 0;
+      bool done = false;
+   };
+
+   Catcher& catcher;
+   const ColumnarProgram& program;
+   RecordFormat format;
+   size_t jobs;
+   // Input of every CSV column, or -1 for columns that are not inputs.
+   std::vector<int> fields;
+   size_t records = 0;
+
+   bool read_header(RecordReader& reader);
+   void process(Chunk& chunk) const;
+   bool parse_csv(std::string_view line, std::vector<Column>& columns, size_t record, std::vector<char>& seen) const;
+   bool parse_ndjson(std::string_view line, std::vector<Column>& columns, size_t record, std::vector<char>& seen) const;
+   void format_record(std::string& output, const std::vector<Column>& outputs, size_t record) const;
+};
+
+#endif // RECORDS_HPP
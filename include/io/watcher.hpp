@@ -0,0 +1,35 @@
+#ifndef WATCHER_HPP
+#define WATCHER_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Reports saves of a set of files with inotify. The directories of the files are watched
+// instead of the files themselves, so editors that save by renaming a new file over the
+// old one are seen too. Only available on Linux, elsewhere the watcher is never valid.
+class FileWatcher
+{
+public:
+   FileWatcher();
+   ~FileWatcher();
+
+   FileWatcher(const FileWatcher&) = delete;
+   FileWatcher& operator=(const FileWatcher&) = delete;
+
+   bool valid() const;
+   // Watches exactly these files from now on, by the names they are reported with.
+   void watch(const std::unordered_set<std::string>& files);
+   // Waits until watched files are saved and returns them, or returns nothing once the
+   // file descriptor 'stop' can be read.
+   std::vector<std::string> wait(int stop);
+
+private:
+   int fd = -1;
+   // Watched files by the watch of their directory and their name in it.
+   std::unordered_map<int, std::unordered_map<std::string, std::vector<std::string>>> directories;
+   std::unordered_set<std::string> files;
+};
+
+#endif // WATCHER_HPP
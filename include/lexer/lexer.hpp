@@ -3,6 +3,11 @@
 
 #include "errors/catcher.hpp"
 #include "lexer/tokens.hpp"
+#include <functional>
+#include <vector>
+
+// Called with all tokens lexed so far after every newline, may take a prefix of them.
+using LineSink = std::function<void(std::vector<Token>& tokens)>;
 
 class Lexer
 {
@@ -10,12 +15,14 @@ public:
    Lexer(Catcher& catcher, std::string& string);
    ~Lexer() = default;
 
+   void specify_line_sink(LineSink line_sink);
    std::vector<Token>& tokenize();
 
 private:
    Catcher& catcher;
    std::string& source;
    std::vector<Token> tokens;
+   LineSink line_sink;
    size_t index = 0;
    size_t size = 0;
 
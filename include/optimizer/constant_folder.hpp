@@ -0,0 +1,40 @@
+#ifndef CONSTANT_FOLDER_HPP
+#define CONSTANT_FOLDER_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/ast.hpp"
+#include "runtime/value.hpp"
+
+// Replaces operator subtrees whose operands are all literals with their value.
+class ConstantFolder
+{
+public:
+   ConstantFolder(Catcher& catcher, Program& program);
+   ~ConstantFolder() = default;
+
+   size_t fold();
+   Stmt fold_stmt(Stmt stmt);
+
+private:
+   Catcher& catcher;
+   Program& program;
+   size_t removed = 0;
+   // Depth of subtrees that only run when a condition selects them.
+   size_t guarded = 0;
+
+   Stmt fold_ternary(TernaryExpr* expr);
+   Stmt fold_binary(BinaryExpr* expr);
+   Stmt fold_unary(UnaryExpr* expr);
+   Stmt fold_guarded(Stmt stmt);
+
+   Stmt fold(Stmt expr, const char* error, const Value& result);
+   Stmt replace(Stmt old, Stmt value);
+};
+
+size_t count_nodes(const Statement* stmt);
+// The value of a literal, returns false for everything else.
+bool literal_value(const Statement* stmt, Value& value);
+// A literal holding the value, bools become ints. Returns nullptr for null.
+Stmt make_literal(Arena& arena, const Value& value);
+
+#endif // CONSTANT_FOLDER_HPP
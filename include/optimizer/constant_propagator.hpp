@@ -0,0 +1,34 @@
+#ifndef CONSTANT_PROPAGATOR_HPP
+#define CONSTANT_PROPAGATOR_HPP
+
+#include "errors/catcher.hpp"
+#include "optimizer/constant_folder.hpp"
+#include "parser/ast.hpp"
+#include <vector>
+
+// Replaces every use of an immutable variable declared with a literal by the literal,
+// folds what becomes constant and removes the declarations. 'con' and plain variables
+// are never assigned and the resolver gives each declaration its own slot, so a
+// shadowed variable keeps its value for the uses before the shadowing one.
+class ConstantPropagator
+{
+public:
+   ConstantPropagator(Catcher& catcher, Program& program);
+   ~ConstantPropagator() = default;
+
+   size_t propagate();
+   size_t removed_count() const;
+
+private:
+   Program& program;
+   ConstantFolder folder;
+   // The literal of every slot that is constant, nullptr for the others.
+   std::vector<Stmt> constants;
+   size_t rewritten = 0;
+   size_t removed = 0;
+
+   Stmt propagate_stmt(Stmt stmt);
+   Stmt constant(const VarDeclaration* decl);
+};
+
+#endif // CONSTANT_PROPAGATOR_HPP
@@ -0,0 +1,27 @@
+#ifndef DEAD_CODE_REMOVER_HPP
+#define DEAD_CODE_REMOVER_HPP
+
+#include "parser/ast.hpp"
+#include <vector>
+
+// Removes declarations of variables that are never used or assigned, when their body
+// is nothing or a literal that converts to the declared type, so dropping them can not
+// hide an error.
+class DeadCodeRemover
+{
+public:
+   DeadCodeRemover(Program& program);
+   ~DeadCodeRemover() = default;
+
+   size_t remove();
+
+private:
+   Program& program;
+   // How many identifiers refer to every slot.
+   std::vector<size_t> uses;
+
+   void count_uses(const Statement* stmt);
+   bool removable(const VarDeclaration* decl) const;
+};
+
+#endif // DEAD_CODE_REMOVER_HPP
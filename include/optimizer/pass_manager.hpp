@@ -0,0 +1,63 @@
+#ifndef PASS_MANAGER_HPP
+#define PASS_MANAGER_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/ast.hpp"
+#include <string_view>
+#include <vector>
+
+// Runs the optimization passes over a resolved and type checked program, in a fixed
+// order. '-O1' turns on the passes of level 1, '-O2' those of level 1 and 2, and
+// every pass can also be turned on or off by name.
+class PassManager
+{
+public:
+   struct Report
+   {
+      const char* name;
+      long time;
+      // Node counts, only measured with 'measure'.
+      size_t before;
+      size_t after;
+      // What the pass counts as a change (nodes removed, uses rewritten, ...).
+      size_t changes;
+   };
+
+   PassManager(Catcher& catcher, Program& program);
+   ~PassManager() = default;
+
+   // Types of the variables bound with Resolver::define, for checking the types again.
+   void define(std::uint32_t slot, VType type);
+   void specify_level(size_t level);
+   // These return false for a name that is not a pass.
+   bool enable(std::string_view name, bool enabled);
+   bool log_after(std::string_view name);
+   void measure(bool measured);
+   // Returns false if a pass found errors.
+   bool run();
+   const std::vector<Report>& reports() const;
+
+private:
+   struct Pass
+   {
+      const char* name;
+      size_t level;
+      size_t (*run)(Catcher& catcher, Program& program);
+      // Whether the pass makes nodes that need their types checked again.
+      bool retype;
+      bool enabled = false;
+      bool logged = false;
+   };
+
+   Catcher& catcher;
+   Program& program;
+   std::vector<Pass> passes;
+   std::vector<Report> ran;
+   std::vector<VType> defined;
+   bool measured = false;
+
+   Pass* find(std::string_view name);
+   size_t count() const;
+};
+
+#endif // PASS_MANAGER_HPP
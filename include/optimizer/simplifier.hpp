@@ -0,0 +1,27 @@
+#ifndef SIMPLIFIER_HPP
+#define SIMPLIFIER_HPP
+
+#include "parser/ast.hpp"
+
+// Removes operators that give back their other operand unchanged, like 'x + 0' or
+// 'x * 1.0'. Needs the static types, an identity is only dropped when the operand
+// already has the type of the result, so nothing that converts or fails is removed.
+class Simplifier
+{
+public:
+   Simplifier(Program& program);
+   ~Simplifier() = default;
+
+   size_t simplify();
+
+private:
+   Program& program;
+   size_t removed = 0;
+
+   Stmt simplify_stmt(Stmt stmt);
+   Stmt simplify_binary(BinaryExpr* expr);
+   Stmt simplify_unary(UnaryExpr* expr);
+   Stmt replace(Stmt old, Stmt value);
+};
+
+#endif // SIMPLIFIER_HPP
@@ -0,0 +1,51 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Bump allocator for AST nodes and their strings. Nothing allocated from it is
+// ever destroyed individually, all blocks are released together with the arena.
+//
+// It is also a memory resource, so containers of a run can be allocated from it and
+// the arena reset once the run is over.
+class Arena : public std::pmr::memory_resource
+{
+public:
+   Arena() = default;
+   ~Arena() = default;
+
+   Arena(const Arena&) = delete;
+   Arena& operator=(const Arena&) = delete;
+   Arena(Arena&& other) noexcept;
+   Arena& operator=(Arena&& other) noexcept;
+
+   template <typename T, typename... Args>
+   T* make(Args&&... args)
+   {
+      return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+   }
+
+   void* allocate(size_t size, size_t alignment);
+   std::string_view copy(const std::string& string);
+   size_t block_count() const;
+   // Frees everything allocated so far. The block in use is kept for what comes next.
+   void reset();
+
+private:
+   std::vector<std::unique_ptr<char[]>> blocks;
+   char* cursor = nullptr;
+   char* end = nullptr;
+   size_t next_block_size = 4096;
+
+   static constexpr size_t max_block_size = 1 << 20;
+
+   void* do_allocate(size_t size, size_t alignment) override;
+   void do_deallocate(void* pointer, size_t size, size_t alignment) override;
+   bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif // ARENA_HPP
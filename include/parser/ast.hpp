@@ -2,7 +2,11 @@
 #define AST_HPP
 
 #include "lexer/tokens.hpp"
-#include <memory>
+#include "parser/arena.hpp"
+#include "config/precision.hpp"
+#include "runtime/vtype.hpp"
+#include <cstdint>
+#include <string_view>
 #include <vector>
 
 enum class StmtType : std::int8_t
@@ -13,20 +17,25 @@ enum class StmtType : std::int8_t
 
 struct Statement
 {
+   // Filled in by the type checker, VType::null when the type is only known at run time.
+   VType static_type = VType::null;
+
    virtual ~Statement() = default;
    virtual void print(size_t indentation) const = 0;
    virtual StmtType type() const = 0;
 };
 
-using Stmt = std::unique_ptr<Statement>;
+// Non-owning handle, nodes live in the arena of their Program.
+using Stmt = Statement*;
 
 struct VarDeclaration : public Statement
 {
    Stmt ttype;
-   std::string identifier;
+   std::string_view identifier;
    Stmt body;
+   std::uint32_t slot = 0;
 
-   VarDeclaration(Stmt& ttype, const std::string& identifier, Stmt& body);
+   VarDeclaration(Stmt ttype, std::string_view identifier, Stmt body);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -36,9 +45,9 @@ struct TypeExpr : public Statement
    bool con;
    bool mut;
    bool automatic;
-   std::string ttype;
+   std::string_view ttype;
 
-   TypeExpr(bool con, bool mut, bool automatic, const std::string& ttype);
+   TypeExpr(bool con, bool mut, bool automatic, std::string_view ttype);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -49,7 +58,7 @@ struct AssignmentExpr : public Statement
    Stmt left;
    Stmt right;
 
-   AssignmentExpr(TType op, Stmt& left, Stmt& right);
+   AssignmentExpr(TType op, Stmt left, Stmt right);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -60,7 +69,7 @@ struct TernaryExpr : public Statement
    Stmt left;
    Stmt right;
 
-   TernaryExpr(Stmt& expr, Stmt& left, Stmt& right);
+   TernaryExpr(Stmt expr, Stmt left, Stmt right);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -71,7 +80,7 @@ struct BinaryExpr : public Statement
    Stmt left;
    Stmt right;
 
-   BinaryExpr(TType op, Stmt& left, Stmt& right);
+   BinaryExpr(TType op, Stmt left, Stmt right);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -81,16 +90,19 @@ struct UnaryExpr : public Statement
    TType op;
    Stmt value;
 
-   UnaryExpr(TType op, Stmt& value);
+   UnaryExpr(TType op, Stmt value);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
 
 struct Identifier : public Statement
 {
-   std::string identifier;
+   std::string_view identifier;
+   // Filled in by the resolver.
+   std::uint32_t scope = 0;
+   std::uint32_t slot = 0;
 
-   Identifier(const std::string& identifier);
+   Identifier(std::string_view identifier);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -104,9 +116,9 @@ struct NullLiteral : public Statement
 
 struct RealLiteral : public Statement
 {
-   long double number;
+   real_t number;
 
-   RealLiteral(long double number);
+   RealLiteral(real_t number);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -122,9 +134,9 @@ struct IntegralLiteral : public Statement
 
 struct StringLiteral : public Statement
 {
-   std::string string;
+   std::string_view string;
 
-   StringLiteral(const std::string& string);
+   StringLiteral(std::string_view string);
    StmtType type() const override;
    void print(size_t indentation) const override;
 };
@@ -140,7 +152,11 @@ struct CharLiteral : public Statement
 
 struct Program
 {
+   Arena arena;
+   std::vector<Arena> adopted;
    std::vector<Stmt> statements;
+
+   void merge(Program& other);
    void print() const;
 };
 
@@ -0,0 +1,92 @@
+#ifndef FLAT_AST_HPP
+#define FLAT_AST_HPP
+
+#include "parser/ast.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-size node of the flat AST. Children are indices into FlatProgram::nodes
+// and always come before their parent, so a linear scan visits them in post-order.
+// Every node carries the static type the type checker gave it in type.
+//
+// var_decl:   first = type, children = {body, identifier}
+// type:       flags = con/mut/automatic, text = type name
+// assignment,
+// binary:     op, first = left, children.second = right
+// ternary:    first = condition, children = {left, right}
+// unary:      op, first = value
+// identifier: flags = scope, first = slot, text = name
+// string:     text = offset and length in FlatProgram::strings
+// integer:    integer
+// real:       first = index in FlatProgram::reals
+// character:  ch
+struct FlatNode
+{
+   struct Children
+   {
+      std::uint32_t second;
+      std::uint32_t third;
+   };
+
+   struct Text
+   {
+      std::uint32_t offset;
+      std::uint32_t length;
+   };
+
+   StmtType tag;
+   TType op;
+   std::uint8_t flags;
+   VType type;
+   std::uint32_t first;
+
+   union
+   {
+      Children children;
+      Text text;
+      long long integer;
+      char ch;
+   };
+};
+
+static_assert(sizeof(FlatNode) == 16);
+
+namespace flag
+{
+   constexpr std::uint8_t con       = 1 << 0;
+   constexpr std::uint8_t mut       = 1 << 1;
+   constexpr std::uint8_t automatic = 1 << 2;
+} // namespace flag
+
+// Read-only view of a flat AST, either backed by a FlatProgram or by a mapped cache file.
+struct FlatView
+{
+   std::span<const FlatNode> nodes;
+   std::span<const std::uint32_t> statements;
+   std::span<const real_t> reals;
+   std::string_view strings;
+
+   std::string_view text(const FlatNode& node) const;
+   void print() const;
+
+private:
+   void print(std::uint32_t index, size_t indentation) const;
+};
+
+struct FlatProgram
+{
+   std::vector<FlatNode> nodes;
+   std::vector<std::uint32_t> statements;
+   std::vector<real_t> reals;
+   std::string strings;
+
+   FlatView view() const;
+   void print() const;
+};
+
+FlatProgram flatten(const Program& program);
+
+#endif // FLAT_AST_HPP
@@ -0,0 +1,30 @@
+#ifndef PARALLEL_PARSER_HPP
+#define PARALLEL_PARSER_HPP
+
+#include "errors/catcher.hpp"
+#include "lexer/tokens.hpp"
+#include "parser/ast.hpp"
+#include <vector>
+
+// Splits preprocessed tokens into chunks of whole top-level statements and
+// parses the chunks on a pool of worker threads, each chunk into its own arena.
+class ParallelParser
+{
+public:
+   ParallelParser(Catcher& catcher, std::vector<Token>& tokens, size_t jobs);
+   ~ParallelParser() = default;
+
+   Program& parse();
+
+private:
+   Catcher& catcher;
+   std::vector<Token>& tokens;
+   Program program;
+   size_t jobs;
+
+   static constexpr size_t chunks_per_job = 4;
+
+   std::vector<size_t> find_chunks() const;
+};
+
+#endif // PARALLEL_PARSER_HPP
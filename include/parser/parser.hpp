@@ -5,6 +5,19 @@
 #include "lexer/tokens.hpp"
 #include "parser/ast.hpp"
 
+enum class FType : std::int8_t
+{ binary, ternary_middle, ternary_right, unary, group };
+
+// Operator waiting for its right operand on the explicit expression stack.
+struct ExprFrame
+{
+   FType type;
+   TType op;
+   int min_precedence;
+   Stmt left;
+   Stmt middle;
+};
+
 class Parser
 {
 public:
@@ -12,42 +25,34 @@ public:
    ~Parser() = default;
 
    Program& parse();
+   Program& parse_range(size_t begin, size_t end);
+   void refill();
 
 private:
    Catcher& catcher;
    std::vector<Token>& tokens;
    Program program;
+   std::vector<ExprFrame> frames;
    size_t index = 0;
 
+   static constexpr int max_precedence = 18;
+
    Stmt parse_stmt();
    Stmt parse_var_declaration();
    Stmt parse_type();
 
-   Stmt parse_compound_bitwise_expr();
-   Stmt parse_compound_shift_expr();
-   Stmt parse_compound_additive_expr();
-   Stmt parse_compound_multiplicative_expr();
-   Stmt parse_compound_exponentiation_expr();
-   Stmt parse_assignment_expr();
-   Stmt parse_ternary_expr();
-   Stmt parse_logical_or_expr();
-   Stmt parse_logical_and_expr();
-   Stmt parse_bitwise_or_expr();
-   Stmt parse_bitwise_xor_expr();
-   Stmt parse_bitwise_and_expr();
-   Stmt parse_equality_expr();
-   Stmt parse_relational_expr();
-   Stmt parse_shift_expr();
-   Stmt parse_additive_expr();
-   Stmt parse_multiplicative_expr();
-   Stmt parse_exponentiation_expr();
-   Stmt parse_unary_expr();
+   Stmt parse_expr();
+   bool reduce_frame(Stmt& operand, int& min_precedence);
+   Stmt parse_unary_expr(int& min_precedence);
    Stmt parse_increment_suffix();
    Stmt parse_primary_expr();
 
    void advance();
    bool is(TType type) const;
    bool is_type() const;
+   bool is_declaration(const Token& token) const;
+   bool is_group() const;
+   int get_operator_precedence(TType type) const;
    Token& current();
 };
 
@@ -0,0 +1,45 @@
+#ifndef BACK_END_HPP
+#define BACK_END_HPP
+
+#include "errors/catcher.hpp"
+#include "optimizer/pass_manager.hpp"
+#include "parser/ast.hpp"
+#include "parser/flat_ast.hpp"
+#include <optional>
+#include <string>
+#include <vector>
+
+// Everything after parsing that every way of running a program shares: resolving,
+// type checking, the passes and flattening. The passes are configured by the caller,
+// their reports stay in the pass manager.
+class BackEnd
+{
+public:
+   // Times of the stages in microseconds.
+   struct Times
+   {
+      long resolve = 0;
+      long check = 0;
+      long flatten = 0;
+      size_t typed = 0;
+   };
+
+   BackEnd(Catcher& catcher, Program& program, PassManager& passes);
+   ~BackEnd() = default;
+
+   // A variable the program can use without declaring it, in the slot of its order.
+   void define(const std::string& name, VType type);
+   // Displays the errors of the first failing stage and gives nothing.
+   std::optional<FlatProgram> compile();
+   const Times& times() const;
+
+private:
+   Catcher& catcher;
+   Program& program;
+   PassManager& passes;
+   std::vector<std::string> names;
+   std::vector<VType> types;
+   Times measured;
+};
+
+#endif // BACK_END_HPP
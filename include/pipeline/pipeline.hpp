@@ -0,0 +1,72 @@
+#ifndef PIPELINE_HPP
+#define PIPELINE_HPP
+
+#include "errors/catcher.hpp"
+#include "lexer/tokens.hpp"
+#include "parser/parser.hpp"
+#include "pipeline/ring_buffer.hpp"
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using TokenBatch = std::vector<Token>;
+
+// Runs the lexer, the preprocessor and the parser on separate threads. Tokens are
+// handed over in batches that end on a complete top-level statement, so that every
+// stage can work on a batch without looking at the rest of the input.
+class Pipeline
+{
+public:
+   Pipeline(Catcher& catcher, std::string& source, const std::string& file, bool skip_preprocessor, bool skip_macros);
+   ~Pipeline() = default;
+
+   void specify_max_macro_depth(size_t max_macro_depth);
+
+   Program& run();
+
+   // What the preprocessor reports once run() returned, for the cache.
+   bool is_deterministic() const;
+   const std::unordered_set<std::string>& get_included_files() const;
+   const std::string& get_log() const;
+
+private:
+   Catcher& catcher;
+   std::string& source;
+   std::string file;
+   bool skip_preprocessor;
+   bool skip_macros;
+   size_t max_macro_depth = 0;
+
+   Catcher lexer_catcher;
+   Catcher preprocessor_catcher;
+   Catcher parser_catcher;
+
+   RingBuffer<TokenBatch, 16> lexed;
+   RingBuffer<TokenBatch, 16> processed;
+
+   std::vector<Token> preprocessor_tokens;
+   std::vector<Token> parser_tokens;
+   Parser parser;
+   Program* program = nullptr;
+
+   bool deterministic = true;
+   std::unordered_set<std::string> included_files;
+   std::string log;
+
+   size_t scanned = 0;
+   size_t cut = 0;
+   size_t paren_depth = 0;
+   size_t mcond_depth = 0;
+   bool wait_semicolon = false;
+   bool wait_newline = false;
+   bool line_complete = true;
+
+   static constexpr size_t batch_size = 4096;
+
+   void segment(std::vector<Token>& tokens);
+   bool track(const Token& token);
+   void run_preprocessor();
+   void run_parser();
+};
+
+#endif // PIPELINE_HPP
@@ -0,0 +1,46 @@
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+template <typename T, size_t capacity>
+class RingBuffer
+{
+public:
+   RingBuffer() = default;
+   ~RingBuffer() = default;
+
+   void push(T&& value)
+   {
+      size_t tail = this->tail.load(std::memory_order_relaxed);
+      size_t next = (tail + 1) % capacity;
+
+      while (next == this->head.load(std::memory_order_acquire))
+         std::this_thread::yield();
+
+      this->buffer[tail] = std::move(value);
+      this->tail.store(next, std::memory_order_release);
+   }
+
+   T pop()
+   {
+      size_t head = this->head.load(std::memory_order_relaxed);
+
+      while (head == this->tail.load(std::memory_order_acquire))
+         std::this_thread::yield();
+
+      T value = std::move(this->buffer[head]);
+      this->head.store((head + 1) % capacity, std::memory_order_release);
+      return value;
+   }
+
+private:
+   std::array<T, capacity> buffer;
+   alignas(64) std::atomic<size_t> head = 0;
+   alignas(64) std::atomic<size_t> tail = 0;
+};
+
+#endif // RING_BUFFER_HPP
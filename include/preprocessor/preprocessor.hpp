@@ -3,12 +3,19 @@
 
 #include "errors/catcher.hpp"
 #include "lexer/tokens.hpp"
+#include <functional>
 #include <unordered_map>
 #include <unordered_set>
 
 enum class CType : std::int8_t
 { true_, false_, evaluated };
 
+// Called with every '#log' line, newline included, instead of printing it.
+using LogSink = std::function<void(const std::string& line)>;
+// Tokens of files as the lexer gives them, by file name, so a file imported again is not
+// read and lexed again.
+using TokenCache = std::unordered_map<std::string, std::vector<Token>>;
+
 class Preprocessor
 {
 public:
@@ -16,8 +23,15 @@ public:
    ~Preprocessor() = default;
 
    void specify_max_macro_depth(size_t max_macro_depth);
+   void specify_log_sink(LogSink log_sink);
+   void specify_token_cache(TokenCache* token_cache);
 
    void process();
+   void refill();
+
+   bool is_deterministic() const;
+   const std::unordered_set<std::string>& get_included_files() const;
+   const std::string& get_log() const;
 
 private:
    Catcher& catcher;
@@ -31,6 +45,11 @@ private:
    size_t macro_depth = 0;
    size_t max_macro_depth = 32;
 
+   bool deterministic = true;
+   std::string log_output;
+   LogSink log_sink;
+   TokenCache* token_cache = nullptr;
+
    void evaluate_token();
    void handle_macro_definition();
    void handle_using_macro();
@@ -44,6 +63,7 @@ private:
    void handle_errors();
    void handle_logging();
    void handle_asserts();
+   void check_time_macro(const std::string& macro);
 
    Token& current();
    Token& skip();
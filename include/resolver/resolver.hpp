@@ -0,0 +1,43 @@
+#ifndef RESOLVER_HPP
+#define RESOLVER_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/ast.hpp"
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Binds every identifier to the (scope, slot) of the declaration it refers to and
+// checks the mut/con rules, so the evaluator never has to look up names.
+class Resolver
+{
+public:
+   Resolver(Catcher& catcher, Program& program);
+   ~Resolver() = default;
+
+   // Binds a variable that the program uses without declaring it, like the inputs of
+   // columnar evaluation (immutable) or the variables of earlier REPL lines. Defined
+   // variables get the first slots in order.
+   std::uint32_t define(std::string_view name, bool con = false, bool mut = false);
+   std::uint32_t resolve();
+
+private:
+   struct Binding
+   {
+      std::uint32_t slot;
+      bool con;
+      bool mut;
+   };
+
+   Catcher& catcher;
+   Program& program;
+   std::vector<std::unordered_map<std::string_view, Binding>> scopes;
+   std::uint32_t slots = 0;
+
+   void resolve_stmt(Stmt stmt);
+   void resolve_var_decl(VarDeclaration* decl);
+   void resolve_assignment(Stmt target);
+   const Binding* resolve_identifier(Identifier* identifier);
+};
+
+#endif // RESOLVER_HPP
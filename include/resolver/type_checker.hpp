@@ -0,0 +1,37 @@
+#ifndef TYPE_CHECKER_HPP
+#define TYPE_CHECKER_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/ast.hpp"
+#include <vector>
+
+// Gives every node of a resolved program its static type and rejects operators and
+// stores whose operand types can never work, before anything runs.
+class TypeChecker
+{
+public:
+   TypeChecker(Catcher& catcher, Program& program);
+   ~TypeChecker() = default;
+
+   // Gives a variable bound with Resolver::define its type.
+   void define(std::uint32_t slot, VType type);
+   // Returns how many expressions got a static type.
+   size_t check();
+
+private:
+   Catcher& catcher;
+   Program& program;
+   // Type of every slot, VType::null for 'let' variables initialized with a value
+   // whose type is only known at run time.
+   std::vector<VType> slots;
+   size_t typed = 0;
+
+   VType check_stmt(Stmt stmt);
+   VType check_var_decl(VarDeclaration* decl);
+   VType check_assignment(AssignmentExpr* assignment);
+   VType check_unary(UnaryExpr* unary);
+   void check_store(VType target, VType value);
+   void report(const char* error);
+};
+
+#endif // TYPE_CHECKER_HPP
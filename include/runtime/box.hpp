@@ -0,0 +1,96 @@
+#ifndef BOX_HPP
+#define BOX_HPP
+
+#include "runtime/value.hpp"
+#include <bit>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Out-of-line payloads of boxed values, owned by the virtual machine and released
+// together with it. Strings are immutable, so boxes may share them.
+struct Heap
+{
+   std::vector<std::string> strings;
+   std::vector<long long> wides;
+   std::vector<real_t> longs;
+   // Bytes of every payload put into the heap so far.
+   size_t bytes = 0;
+};
+
+// 8-byte NaN-boxed value used by the virtual machine. Reals are stored as the bits of a
+// double, every other type lives in the 48-bit payload of a negative quiet NaN with the
+// tag in the upper 16 bits:
+//
+//   0xFFF9 null   0xFFFA int   0xFFFB char   0xFFFC bool   0xFFFD string   0xFFFE wide int
+//   0xFFFF long real
+//
+// Ints are 64-bit like everywhere else. Values in [-2^47, 2^47) are stored inline, the
+// others are kept whole in the heap as wide ints. With '--real=long' reals do not fit
+// into a double and are kept in the heap too. Strings, wide ints and long reals are
+// heap indices.
+struct Box
+{
+   static constexpr std::uint64_t null_tag = 0xFFF9;
+   static constexpr std::uint64_t int_tag = 0xFFFA;
+   static constexpr std::uint64_t char_tag = 0xFFFB;
+   static constexpr std::uint64_t bool_tag = 0xFFFC;
+   static constexpr std::uint64_t string_tag = 0xFFFD;
+   static constexpr std::uint64_t wide_tag = 0xFFFE;
+   static constexpr std::uint64_t long_tag = 0xFFFF;
+
+   static constexpr std::uint64_t payload = (std::uint64_t{1} << 48) - 1;
+   // Quiet NaN every NaN is replaced with, so no real can look like a tagged value.
+   static constexpr std::uint64_t canonical_nan = 0x7FF8000000000000;
+
+   std::uint64_t bits = null_tag << 48;
+
+   static Box tagged(std::uint64_t tag, std::uint64_t value)
+   { return {tag << 48 | (value & payload)}; }
+
+   static Box from_real(double real)
+   { return {real != real ? canonical_nan : std::bit_cast<std::uint64_t>(real)}; }
+
+   static bool fits_inline(long long integer)
+   { return static_cast<std::uint64_t>(integer + (1LL << 47)) >> 48 == 0; }
+
+   static Box from_int(long long integer, Heap& heap)
+   {
+      if (fits_inline(integer))
+         return tagged(int_tag, static_cast<std::uint64_t>(integer));
+
+      heap.wides.push_back(integer);
+      heap.bytes += sizeof(long long);
+      return tagged(wide_tag, heap.wides.size() - 1);
+   }
+
+   std::uint64_t tag() const
+   { return this->bits >> 48; }
+
+   std::uint64_t index() const
+   { return this->bits & payload; }
+
+   // Every real is below the first tag, including the NaNs arithmetic can produce.
+   bool is_real() const
+   { return this->bits < null_tag << 48; }
+
+   double real() const
+   { return std::bit_cast<double>(this->bits); }
+
+   long long inline_int() const
+   { return static_cast<long long>(this->bits << 16) >> 16; }
+
+   long long integer(const Heap& heap) const
+   { return (tag() == int_tag ? inline_int() : heap.wides[index()]); }
+
+   // Both tags are checked with a single branch.
+   static bool both_inline(Box a, Box b)
+   { return ((a.bits ^ int_tag << 48) | (b.bits ^ int_tag << 48)) >> 48 == 0; }
+};
+
+static_assert(sizeof(Box) == 8);
+
+Box box(const Value& value, Heap& heap);
+Value unbox(Box box, const Heap& heap);
+
+#endif // BOX_HPP
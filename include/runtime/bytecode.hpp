@@ -0,0 +1,63 @@
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+#include "lexer/tokens.hpp"
+#include "runtime/value.hpp"
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Operand layout of an instruction, used by the disassembler.
+enum class Layout : std::int8_t
+{ none, a, ab, abc, a_imm, a_const, a_type, jump, a_jump, region };
+
+// Every opcode with its operand layout. The '_int' and '_real' opcodes are emitted when
+// the compiler knows both operand types and skip the type dispatch of the generic ones.
+// 'native' runs a region compiled by the JIT.
+#define OPCODES(X) \
+   X(halt, none) X(move, ab) X(load, a_const) X(load_int, a_imm) X(check, a) X(convert, a_type) X(store_dynamic, ab) \
+   X(binary, abc) X(unary, ab) X(truthy, ab) X(jump, jump) X(jump_false, a_jump) X(jump_true, a_jump) \
+   X(add_int, abc) X(sub_int, abc) X(mul_int, abc) X(div_int, abc) X(mod_int, abc) X(neg_int, ab) \
+   X(eq_int, abc) X(ne_int, abc) X(lt_int, abc) X(le_int, abc) X(gt_int, abc) X(ge_int, abc) \
+   X(add_real, abc) X(sub_real, abc) X(mul_real, abc) X(div_real, abc) X(neg_real, ab) \
+   X(eq_real, abc) X(ne_real, abc) X(lt_real, abc) X(le_real, abc) X(gt_real, abc) X(ge_real, abc) \
+   X(native, region)
+
+#define X(name, layout) name,
+enum class OpCode : std::uint8_t
+{ OPCODES(X) };
+#undef X
+
+// a is the destination register unless stated otherwise, load_int keeps its
+// immediate in b (low half) and c (high half). Jumps target instruction indices.
+// native keeps the JIT region in a, the instruction after the bytecode of its
+// statements in b and their count in c.
+struct Instruction
+{
+   OpCode op;
+   TType ttype = TType::eof;  // binary, unary
+   VType vtype = VType::null; // convert
+   std::uint32_t a = 0;
+   std::uint32_t b = 0;
+   std::uint32_t c = 0;
+};
+
+static_assert(sizeof(Instruction) == 16);
+
+struct Chunk
+{
+   std::vector<Instruction> code;
+   std::vector<Value> constants;
+   // First instruction of every top-level statement.
+   std::vector<std::uint32_t> statements;
+   // Slot and name of every declaration, in order.
+   std::vector<std::pair<std::uint32_t, std::string_view>> variables;
+   std::uint32_t registers = 0;
+
+   void disassemble() const;
+};
+
+const char* opcode_to_string(OpCode op);
+
+#endif // BYTECODE_HPP
@@ -0,0 +1,126 @@
+#ifndef COLUMNAR_HPP
+#define COLUMNAR_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/flat_ast.hpp"
+#include "runtime/value.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Values of one variable for every record. Ints and bools (0 or 1) are kept in
+// integers, reals in reals.
+struct Column
+{
+   VType type = VType::null;
+   std::vector<long long> integers;
+   std::vector<double> reals;
+
+   Column() = default;
+   Column(VType type, size_t size);
+
+   size_t size() const;
+   Value at(size_t index) const;
+};
+
+// Compiles a resolved and type checked program once and runs it over columns of
+// records, a batch of records at a time. Every operator runs over the whole batch
+// with AVX2 kernels when the processor has them and with scalar loops when it does
+// not. Ternaries and '&&'/'||' evaluate both sides and keep a mask of the records
+// that take each side, errors only count for those records.
+//
+// Inputs are the variables the program uses without declaring them, bound with
+// Resolver::define and TypeChecker::define. Every declaration gives an output column
+// with the value the variable has at the end. Only int, real and bool values are
+// supported, assignments and '++'/'--' only as statements, and only with
+// '--real=double'.
+class ColumnarProgram
+{
+public:
+   struct Binding
+   {
+      std::string name;
+      VType type;
+   };
+
+   // Inputs are in the order they were defined, so input i is in slot i.
+   ColumnarProgram(Catcher& catcher, FlatView view, std::vector<Binding> inputs);
+   ~ColumnarProgram() = default;
+
+   static bool vectorized();
+
+   bool compile();
+   // Every input column must have the type of its binding and hold the given number of
+   // records. errors gets nullptr or the error of every record, the outputs of a record
+   // that failed are unspecified. Runs share nothing, so one program can run on many
+   // threads at once.
+   void run(size_t records, const std::vector<Column>& inputs, std::vector<Column>& outputs, std::vector<const char*>& errors) const;
+
+   const std::vector<Binding>& inputs() const;
+   const std::vector<Binding>& outputs() const;
+   size_t instruction_count() const;
+
+private:
+   enum class Kind : std::uint8_t
+   {
+      copy_int, copy_real, int_to_real, real_to_int, truthy_int, truthy_real,
+      int_binary, real_binary, real_compare, int_unary, real_unary, real_not,
+      mask_and, mask_and_not, select_int, select_real
+   };
+
+   struct Instruction
+   {
+      Kind kind;
+      TType op;
+      // Registers, in the int or the real file depending on the kind.
+      std::uint32_t dst;
+      std::uint32_t a;
+      std::uint32_t b;
+      std::uint32_t c;
+      // Int register with 1 for the records the instruction is evaluated for, errors
+      // of other records are ignored.
+      std::uint32_t mask;
+   };
+
+   // Static type and register of an expression. Temporaries are written once and only
+   // read by one node, so a variable can take over their register.
+   struct Operand
+   {
+      VType type;
+      std::uint32_t reg;
+      bool temporary;
+      // The register of a 'mut' variable, assignments write to it.
+      bool mutable_register;
+   };
+
+   Catcher& catcher;
+   FlatView view;
+   std::vector<Binding> input_bindings;
+   std::vector<Binding> output_bindings;
+   std::vector<Instruction> code;
+   std::uint32_t int_registers = 0;
+   std::uint32_t real_registers = 0;
+   std::vector<std::pair<std::uint32_t, long long>> int_constants;
+   std::vector<std::pair<std::uint32_t, double>> real_constants;
+   // Register of every slot, inputs first.
+   std::vector<Operand> slots;
+   std::vector<Operand> output_registers;
+
+   bool compile_stmt(std::uint32_t index);
+   // A ternary whose branches have different types is only supported when its value is
+   // stored into a variable of type 'target', then both branches are converted to it.
+   bool compile_expr(std::uint32_t index, std::uint32_t mask, Operand& result, VType target = VType::null);
+   bool compile_binary(const FlatNode& node, std::uint32_t mask, Operand& result);
+   bool binary(TType op, const Operand& left, const Operand& right, std::uint32_t mask, Operand& result);
+   bool compile_logical(const FlatNode& node, std::uint32_t mask, Operand& result);
+   bool compile_unary(const FlatNode& node, std::uint32_t mask, Operand& result);
+   bool compile_ternary(const FlatNode& node, std::uint32_t mask, Operand& result, VType target);
+   bool compile_store(std::uint32_t slot, const Operand& value);
+   Operand convert(const Operand& value, VType type, std::uint32_t mask);
+   Operand truthy(const Operand& value, std::uint32_t mask);
+   Operand make(VType type);
+   void emit(Kind kind, TType op, std::uint32_t dst, std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t mask);
+   bool unsupported();
+};
+
+#endif // COLUMNAR_HPP
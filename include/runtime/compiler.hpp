@@ -0,0 +1,66 @@
+#ifndef COMPILER_HPP
+#define COMPILER_HPP
+
+#include "parser/flat_ast.hpp"
+#include "runtime/bytecode.hpp"
+#include "runtime/jit.hpp"
+#include <vector>
+
+// Compiles a resolved flat AST into register bytecode. Registers below the slot count
+// hold the variables, the rest are temporaries reused by every statement. With a JIT,
+// runs of statements it compiles start with a 'native' instruction that skips their
+// bytecode, which is only there for when the region falls back.
+class Compiler
+{
+public:
+   Compiler(FlatView view, Jit* jit = nullptr);
+   ~Compiler() = default;
+
+   // An input bound with Resolver::define, the virtual machine gives it a value of this
+   // type before running.
+   void define(std::uint32_t slot, VType type);
+   Chunk compile();
+
+private:
+   // Register and its type when it is known at compile time, VType::null otherwise.
+   struct Operand
+   {
+      std::uint32_t reg;
+      VType type;
+   };
+
+   FlatView view;
+   Jit* jit;
+   Chunk chunk;
+   std::uint32_t slots = 0;
+   std::uint32_t next = 0;
+   // No instruction may be rewritten below this index, something jumps to it.
+   size_t label = 0;
+   size_t conditional = 0;
+
+   std::vector<VType> types;
+   std::vector<bool> dynamic;
+   std::vector<bool> initialized;
+   std::vector<bool> effects;
+
+   Operand compile_expr(std::uint32_t index);
+   Operand compile_var_decl(const FlatNode& node);
+   Operand compile_assignment(const FlatNode& node);
+   Operand compile_ternary(const FlatNode& node);
+   Operand compile_binary(const FlatNode& node);
+   Operand compile_logical(const FlatNode& node);
+   Operand compile_unary(const FlatNode& node);
+   Operand compile_increment(const FlatNode& node);
+
+   Operand read(std::uint32_t slot);
+   Operand operation(TType op, std::uint32_t dst, Operand a, Operand b);
+   void store(std::uint32_t slot, Operand value);
+   void move(std::uint32_t dst, std::uint32_t src);
+
+   std::uint32_t temporary();
+   std::uint32_t constant(const Value& value);
+   size_t emit(Instruction instruction);
+   void patch(size_t jump);
+};
+
+#endif // COMPILER_HPP
@@ -0,0 +1,63 @@
+#ifndef EVALUATOR_HPP
+#define EVALUATOR_HPP
+
+#include "errors/catcher.hpp"
+#include "parser/flat_ast.hpp"
+#include "runtime/value.hpp"
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Walks a resolved and type checked flat AST, variables are read and written through
+// their slots. Operands with a static type skip the runtime type dispatch.
+class Evaluator
+{
+public:
+   // The variables are allocated from 'memory'.
+   Evaluator(Catcher& catcher, FlatView view, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+   ~Evaluator() = default;
+
+   // Gives an input bound with Resolver::define its value, before evaluating. A variable
+   // of type null takes the type of its value.
+   void define(std::uint32_t slot, Value value, VType type = VType::null);
+   // Evaluates the rest of the program, returns the number of statements evaluated.
+   size_t evaluate();
+   // Evaluates at most 'budget' top-level statements. Returns nothing while there are more
+   // and what evaluate() returns once the last one was evaluated or one failed.
+   std::optional<size_t> resume(size_t budget);
+   // Stops a program that yielded with the error, returns what evaluate() returns when
+   // failing.
+   size_t interrupt(const char* error);
+   // Fails the program once the strings stored into variables add up to more bytes.
+   void specify_memory_limit(size_t bytes);
+   void print() const;
+   // Name and value of every declared variable, in order.
+   std::vector<std::pair<std::string, Value>> variables() const;
+   // Value of a slot after evaluating, nullptr for inputs the program never reads.
+   const Value* value(std::uint32_t slot) const;
+
+private:
+   Catcher& catcher;
+   FlatView view;
+   std::pmr::vector<Value> slots;
+   std::pmr::vector<VType> types;
+   std::pmr::vector<std::uint32_t> declarations;
+   // Next top-level statement, stays on the one that failed.
+   size_t next = 0;
+   bool failed = false;
+   size_t allocated = 0;
+   size_t memory_limit = std::numeric_limits<size_t>::max();
+
+   bool eval(std::uint32_t index, Value& result);
+   bool eval_var_decl(const FlatNode& node, Value& result);
+   bool eval_assignment(const FlatNode& node, Value& result);
+   bool eval_unary(const FlatNode& node, Value& result);
+   bool eval_logical(const FlatNode& node, Value& result);
+   bool store(std::uint32_t slot, Value& value, VType type);
+   bool fail(const char* error);
+};
+
+#endif // EVALUATOR_HPP
@@ -0,0 +1,56 @@
+#ifndef JIT_HPP
+#define JIT_HPP
+
+#include "parser/flat_ast.hpp"
+#include "runtime/box.hpp"
+#include <cstdint>
+#include <vector>
+
+// Template JIT for x86-64 Linux. A run of top-level statements that only works on int
+// and real variables is compiled into one native region. The variables live in machine
+// registers while the region runs, they are loaded from the virtual machine registers
+// when it is entered and written back when it leaves. When a variable it reads does not
+// hold what it expects (a wide int, nothing yet), the region does not run and the
+// bytecode compiled for the same statements runs instead.
+//
+// Nothing is compiled on other platforms or with '--real=long'.
+class Jit
+{
+public:
+   Jit(FlatView view);
+   ~Jit();
+   Jit(const Jit&) = delete;
+   Jit& operator=(const Jit&) = delete;
+
+   static bool available();
+
+   // Compiles the longest supported run of statements starting with statement 'first',
+   // returns how many statements the region covers or 0 when there is no region.
+   std::uint32_t compile(std::uint32_t first, std::uint32_t& region);
+   // Copies the machine code of every region into executable pages.
+   void finalize();
+
+   // Returns nullptr or the error message. Sets fallback when the region did not run.
+   const char* run(std::uint32_t region, Box* registers, Heap& heap, bool& fallback) const;
+
+   size_t region_count() const;
+   size_t statement_count() const;
+   size_t code_size() const;
+
+private:
+   struct Region
+   {
+      size_t offset;
+      // Int variables the region writes, in the order of their wide int spill slots.
+      std::vector<std::uint32_t> ints;
+   };
+
+   FlatView view;
+   std::vector<std::uint8_t> code;
+   std::vector<Region> regions;
+   size_t statements = 0;
+   std::uint8_t* memory = nullptr;
+   size_t mapped = 0;
+};
+
+#endif // JIT_HPP
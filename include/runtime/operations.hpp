@@ -0,0 +1,29 @@
+#ifndef OPERATIONS_HPP
+#define OPERATIONS_HPP
+
+#include "lexer/tokens.hpp"
+#include "runtime/value.hpp"
+
+// Operator semantics shared by the constant folder and the evaluator. Both return
+// nullptr on success or the error message, err::invalid_operands when the operator
+// is not defined for the operand types.
+const char* binary_operation(TType op, const Value& a, const Value& b, Value& result);
+const char* unary_operation(TType op, const Value& value, Value& result);
+
+const char* truthy(const Value& value, bool& result);
+
+// Typed paths for operands the type checker proved to be integers or reals.
+const char* integer_operation(TType op, long long a, long long b, Value& result);
+const char* real_operation(TType op, real_t a, real_t b, Value& result);
+
+// Static counterparts used by the type checker and the compiler. The result is the type
+// the operation produces, VType::null when it is only known at run time. Operand types
+// that are only known at run time are never an error.
+const char* binary_type(TType op, VType a, VType b, VType& result);
+const char* unary_type(TType op, VType value, VType& result);
+const char* truthy_type(VType value);
+
+// Maps a compound assignment like '+=' to its binary operator, '=' for everything else.
+TType compound_operator(TType op);
+
+#endif // OPERATIONS_HPP
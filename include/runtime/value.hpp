@@ -0,0 +1,24 @@
+#ifndef VALUE_HPP
+#define VALUE_HPP
+
+#include "config/precision.hpp"
+#include "runtime/vtype.hpp"
+#include <string>
+#include <string_view>
+#include <variant>
+
+// Runtime value, the alternatives are in the same order as VType.
+using Value = std::variant<std::monostate, long long, real_t, char, bool, std::string>;
+
+VType type_of(const Value& value);
+VType type_from_name(std::string_view name);
+const char* type_to_name(VType type);
+
+bool is_number(const Value& value);
+long long to_integer(const Value& value);
+real_t to_real(const Value& value);
+
+const char* convert(Value& value, VType type);
+std::string to_string(const Value& value);
+
+#endif // VALUE_HPP
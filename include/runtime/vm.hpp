@@ -0,0 +1,67 @@
+#ifndef VM_HPP
+#define VM_HPP
+
+#include "errors/catcher.hpp"
+#include "runtime/box.hpp"
+#include "runtime/bytecode.hpp"
+#include "runtime/jit.hpp"
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// GCC and Clang dispatch through a table of label addresses, other compilers (or
+// building with VM_NO_COMPUTED_GOTO) use a switch.
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO
+#endif
+
+class VirtualMachine
+{
+public:
+   // The JIT is needed when the chunk was compiled with one. The registers are allocated
+   // from 'memory'.
+   VirtualMachine(Catcher& catcher, const Chunk& chunk, const Jit* jit = nullptr, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+   ~VirtualMachine() = default;
+
+   // Gives an input bound with Resolver::define its value, before running.
+   void define(std::uint32_t slot, const Value& value);
+   // Instructions between two checks of the cancel flag of a job.
+   static constexpr size_t cancel_interval = 4096;
+
+   // Runs to the end from where the program stopped, returns the number of statements
+   // that were executed.
+   size_t run();
+   // Executes at most 'budget' instructions and stops before the next one, everything
+   // the program needs to go on is in the registers. Returns nothing while it has more
+   // to run and what run() returns once it halted or failed. A native instruction of the
+   // JIT runs its statements at once and counts as one.
+   std::optional<size_t> resume(size_t budget);
+   // Stops a program that yielded with the error, returns what run() returns when failing.
+   size_t interrupt(const char* error);
+   // Fails the program once the heap holds more bytes, checked where values are boxed.
+   void specify_memory_limit(size_t bytes);
+   void print() const;
+   // Name and value of every declared variable, in order.
+   std::vector<std::pair<std::string, Value>> variables() const;
+   size_t register_count() const;
+
+private:
+   Catcher& catcher;
+   const Chunk& chunk;
+   const Jit* jit;
+   Heap heap;
+   std::pmr::vector<Box> constants;
+   std::pmr::vector<Box> registers;
+   // Next instruction to execute, nullptr once the program halted or failed.
+   const Instruction* next;
+   size_t memory_limit = std::numeric_limits<size_t>::max();
+
+   template <bool budgeted>
+   size_t execute(size_t budget);
+   size_t fail(const char* error, const Instruction* ip);
+};
+
+#endif // VM_HPP
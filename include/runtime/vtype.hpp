@@ -0,0 +1,10 @@
+#ifndef VTYPE_HPP
+#define VTYPE_HPP
+
+#include <cstdint>
+
+// Type of a runtime value, also used by the type checker for static types.
+enum class VType : std::int8_t
+{ null, integer, real, character, boolean, string };
+
+#endif // VTYPE_HPP
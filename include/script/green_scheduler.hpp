@@ -0,0 +1,73 @@
+#ifndef GREEN_SCHEDULER_HPP
+#define GREEN_SCHEDULER_HPP
+
+#include "script/script.hpp"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+struct GreenTask
+{
+   std::shared_ptr<const CompiledScript> script;
+   std::vector<Value> inputs;
+   // Called with the result once the run finished, may spawn more tasks.
+   std::function<void(ScriptResult& result)> done;
+   // A turn of the task runs 'priority' quanta, 0 counts as 1.
+   size_t priority = 1;
+};
+
+// Runs any number of scripts on the thread that calls run(), a ScriptRun each. The runs
+// take turns in the order they were spawned: a turn resumes a run for its quantum of
+// steps and puts it at the back again unless it finished. A switch is a call and a move
+// of a pointer, and the state of every run is allocated from one pool that runs which
+// finished give their memory back to.
+class GreenScheduler
+{
+public:
+   struct Stats
+   {
+      std::uint64_t spawned = 0;
+      std::uint64_t completed = 0;
+      std::uint64_t failed = 0;
+      // Turns that ended without finishing their run.
+      std::uint64_t switches = 0;
+      // Most runs that were alive at once.
+      std::uint64_t peak = 0;
+   };
+
+   // Steps a run executes per turn and priority.
+   explicit GreenScheduler(size_t quantum = 64);
+   ~GreenScheduler() = default;
+
+   GreenScheduler(const GreenScheduler&) = delete;
+   GreenScheduler& operator=(const GreenScheduler&) = delete;
+
+   void spawn(GreenTask task);
+   // Gives the run at the front its turn, returns false when there is none.
+   bool step();
+   // Takes turns until every run finished, also the ones spawned meanwhile.
+   void run();
+
+   size_t active() const;
+   const Stats& stats() const;
+
+private:
+   struct Fiber
+   {
+      // The run points into the script, so it goes first.
+      std::shared_ptr<const CompiledScript> script;
+      std::unique_ptr<ScriptRun> run;
+      std::function<void(ScriptResult& result)> done;
+      size_t budget;
+   };
+
+   size_t quantum;
+   std::pmr::unsynchronized_pool_resource pool;
+   std::deque<Fiber> ready;
+   Stats counters;
+};
+
+#endif // GREEN_SCHEDULER_HPP
@@ -0,0 +1,161 @@
+#ifndef SCRIPT_HPP
+#define SCRIPT_HPP
+
+#include "config/precision.hpp"
+#include "errors/catcher.hpp"
+#include "parser/flat_ast.hpp"
+#include "preprocessor/preprocessor.hpp"
+#include "runtime/bytecode.hpp"
+#include "runtime/evaluator.hpp"
+#include "runtime/jit.hpp"
+#include "runtime/value.hpp"
+#include "runtime/vm.hpp"
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class Engine : std::int8_t
+{ evaluator, vm, jit };
+
+// A variable the script can use without declaring it, every run gives it a value.
+struct ScriptInput
+{
+   std::string name;
+   VType type;
+};
+
+// Limits of every run of a script, 0 is no limit. A run over a limit is stopped with an
+// error like a runtime error.
+struct ScriptLimits
+{
+   // Instructions in the virtual machine, top-level statements in the evaluator.
+   std::uint64_t operations = 0;
+   // Time spent running, without the time a run waits for its next turn.
+   std::chrono::microseconds time {0};
+   // Bytes of strings and heap payloads the run allocates.
+   size_t memory = 0;
+};
+
+struct ScriptOptions
+{
+   // Name of the script for '__FILE__', relative imports start from the working directory.
+   std::string file;
+   // Precision::long_real needs a build that defines REAL_LONG_DOUBLE.
+   Precision precision = Precision::double_real;
+   Engine engine = Engine::evaluator;
+   // Optimization level like '-O0/-O1/-O2'.
+   size_t optimization = 0;
+   // 0 keeps the default.
+   size_t max_macro_depth = 0;
+   bool predefined_macros = true;
+   std::vector<ScriptInput> inputs;
+   ScriptLimits limits;
+};
+
+// Where a script writes, sinks that are not given write to std::cout like the REPL.
+// '#log' output is only written while compiling.
+struct ScriptSinks
+{
+   LogSink output;
+   ErrorSink diagnostics;
+};
+
+struct ScriptResult
+{
+   bool success = false;
+   // nullptr or the error that stopped the run.
+   const char* error = nullptr;
+   size_t evaluated = 0;
+   // Name and value of every declared variable, in order.
+   std::vector<std::pair<std::string, Value>> variables;
+};
+
+// The front end and the runtimes as a library. A script is lexed, preprocessed, parsed,
+// resolved, type checked, optimized and flattened once, and compiled to bytecode when
+// it runs in the virtual machine or the JIT. Nothing in it changes after compiling and
+// every run gets its own evaluator or virtual machine, so one script can run on any
+// number of threads at once without locking.
+//
+// script.hpp is the interface for embedding, a program that embeds the language builds
+// every file in src/ but main.cpp with its own. '--stress' checks that runs on many
+// threads give what one thread gives.
+class CompiledScript
+{
+public:
+   // Returns nullptr when the script has errors, they are written to the diagnostics sink.
+   static std::shared_ptr<const CompiledScript> compile(std::string source, const ScriptOptions& options, const ScriptSinks& sinks = {});
+
+   ~CompiledScript() = default;
+   CompiledScript(const CompiledScript&) = delete;
+   CompiledScript& operator=(const CompiledScript&) = delete;
+
+   // 'inputs' has a value for every input of the options, which is converted to its type.
+   // A runtime error is written to the diagnostics sink and leaves the result without
+   // variables. The state of the run is allocated from 'memory'.
+   ScriptResult run(const std::vector<Value>& inputs = {}, const ErrorSink& diagnostics = {}, std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+
+   const ScriptOptions& options() const;
+   // '#log' output of compiling, scripts can be run without compiling them again.
+   const std::string& log() const;
+
+private:
+   friend class ScriptRun;
+
+   ScriptOptions script_options;
+   std::string log_output;
+   FlatProgram flat;
+   // The JIT and the bytecode point into the flat program, so the script never moves.
+   std::optional<Jit> jit;
+   Chunk chunk;
+
+   CompiledScript(const ScriptOptions& options);
+};
+
+// A run of a compiled script that executes a few steps at a time, so many runs can take
+// turns on one thread. Between two calls to resume() the run is only its evaluator or
+// virtual machine, nothing of it is on the stack. The script has to outlive the run.
+class ScriptRun
+{
+public:
+   static constexpr size_t unlimited = std::numeric_limits<size_t>::max();
+   // Steps between two checks of the operation and time limits.
+   static constexpr size_t check_interval = 1024;
+
+   // Converts the inputs like CompiledScript::run, a run with invalid inputs is finished
+   // right away.
+   ScriptRun(const CompiledScript& script, const std::vector<Value>& inputs = {}, ErrorSink diagnostics = {}, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+   ~ScriptRun() = default;
+
+   ScriptRun(const ScriptRun&) = delete;
+   ScriptRun& operator=(const ScriptRun&) = delete;
+
+   // Executes at most 'budget' steps, instructions in the virtual machine and top-level
+   // statements in the evaluator. Returns true once the run is finished. A run with
+   // operation or time limits executes its steps in slices of check_interval and checks
+   // the limits after each one, the memory limit is checked where memory is allocated.
+   bool resume(size_t budget = unlimited);
+   bool finished() const;
+   ScriptResult& result();
+
+private:
+   const CompiledScript& script;
+   ErrorSink diagnostics;
+   Catcher catcher;
+   ScriptResult run_result;
+   std::optional<Evaluator> evaluator;
+   std::optional<VirtualMachine> vm;
+   bool done = false;
+   std::uint64_t steps = 0;
+   std::chrono::steady_clock::duration elapsed {0};
+
+   std::optional<size_t> execute(size_t budget);
+   void finish(size_t evaluated);
+};
+
+#endif // SCRIPT_HPP
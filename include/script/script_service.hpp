@@ -0,0 +1,130 @@
+#ifndef SCRIPT_SERVICE_HPP
+#define SCRIPT_SERVICE_HPP
+
+#include "parser/arena.hpp"
+#include "script/script.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Counts latencies in buckets that are at most 1/8 of their value wide, from 1 ns up.
+class LatencyHistogram
+{
+public:
+   void record(std::uint64_t nanoseconds);
+   void merge(const LatencyHistogram& other);
+   std::uint64_t count() const;
+   // Upper end of the bucket the quantile (0 to 1) falls into, in nanoseconds.
+   std::uint64_t percentile(double quantile) const;
+
+private:
+   static constexpr size_t sub_buckets = 8;
+   static constexpr size_t bucket_count = 64 * sub_buckets;
+
+   std::array<std::uint64_t, bucket_count> buckets {};
+   std::uint64_t total = 0;
+
+   static size_t bucket(std::uint64_t nanoseconds);
+   static std::uint64_t upper_end(size_t bucket);
+};
+
+struct RunRequest
+{
+   std::shared_ptr<const CompiledScript> script;
+   std::vector<Value> inputs;
+   // Called on the worker with the result, may submit more requests.
+   std::function<void(ScriptResult& result)> done;
+};
+
+// Runs scripts on a fixed pool of worker threads. Every worker has its own deque of
+// requests: requests submitted from a worker go to its own deque, others to the deques
+// in turn. A worker takes the oldest request of its own deque and steals the newest of
+// another one when its own is empty. Every run allocates its state from an arena of the
+// worker that is reset after the run, so steady state runs barely touch the allocator.
+class ScriptService
+{
+public:
+   struct Stats
+   {
+      std::uint64_t submitted = 0;
+      std::uint64_t completed = 0;
+      std::uint64_t failed = 0;
+      std::uint64_t stolen = 0;
+      // Requests waiting for a worker.
+      std::uint64_t queued = 0;
+      // Completed runs per second since the service started.
+      double throughput = 0.0;
+      // From submitting a request until its 'done' returned.
+      LatencyHistogram latency;
+   };
+
+   // 0 workers uses one per core.
+   explicit ScriptService(size_t workers = 0);
+   // Finishes every submitted request first.
+   ~ScriptService();
+
+   ScriptService(const ScriptService&) = delete;
+   ScriptService& operator=(const ScriptService&) = delete;
+
+   void submit(RunRequest request);
+   // Waits until every submitted request is done, also the ones they submitted.
+   void wait();
+
+   size_t worker_count() const;
+   std::uint64_t queue_depth() const;
+   Stats stats() const;
+
+private:
+   using Clock = std::chrono::steady_clock;
+
+   struct Task
+   {
+      RunRequest request;
+      Clock::time_point submitted;
+   };
+
+   struct Worker
+   {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+      Arena arena;
+      std::thread thread;
+
+      // Guarded by stats_mutex, read by stats() while the worker runs.
+      mutable std::mutex stats_mutex;
+      LatencyHistogram latency;
+      std::uint64_t completed = 0;
+      std::uint64_t failed = 0;
+      std::uint64_t stolen = 0;
+   };
+
+   std::vector<std::unique_ptr<Worker>> workers;
+   Clock::time_point started;
+   std::atomic<size_t> next_worker = 0;
+   std::atomic<std::uint64_t> submitted = 0;
+   std::atomic<std::uint64_t> queued = 0;
+   std::atomic<std::uint64_t> unfinished = 0;
+
+   // Idle workers sleep here until a request comes in.
+   std::mutex idle_mutex;
+   std::condition_variable idle;
+   std::atomic<size_t> sleeping = 0;
+   bool stopping = false;
+
+   // Submitters waiting in wait().
+   std::mutex done_mutex;
+   std::condition_variable all_done;
+
+   void work(size_t index);
+   bool take(size_t index, Task& task, bool& stolen);
+};
+
+#endif // SCRIPT_SERVICE_HPP
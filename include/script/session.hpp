@@ -0,0 +1,69 @@
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include "errors/catcher.hpp"
+#include "lexer/tokens.hpp"
+#include "preprocessor/preprocessor.hpp"
+#include "runtime/value.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// What the REPL keeps between the lines typed at its prompt. One preprocessor lives as
+// long as the session, so the macros defined and the files imported by a line are still
+// there for the next one. The variables a line declares are bound like inputs in the
+// lines after it, with their type, 'con'/'mut' and value. Only the new line is lexed,
+// preprocessed, parsed, resolved, checked and evaluated, and only the variables it names
+// are bound, so a line takes as long in a long session as in a new one.
+class Session
+{
+public:
+   // Time the stages of the last line took in nanoseconds, evaluating includes flattening.
+   struct LineTimes
+   {
+      long lex = 0;
+      long preprocess = 0;
+      long parse = 0;
+      long resolve = 0;
+      long check = 0;
+      long evaluate = 0;
+
+      long total() const;
+   };
+
+   explicit Session(Catcher& catcher);
+   ~Session() = default;
+
+   Session(const Session&) = delete;
+   Session& operator=(const Session&) = delete;
+
+   // Runs a line and prints the variables it declared. A line with an error changes no
+   // variable, the macros it defined before the error are kept.
+   bool run(std::string line);
+
+   const LineTimes& times() const;
+   size_t variable_count() const;
+
+private:
+   struct Variable
+   {
+      VType type;
+      bool con;
+      bool mut;
+      Value value;
+   };
+
+   Catcher& catcher;
+   std::vector<Token> tokens;
+   Preprocessor preprocessor;
+   // Names of the variables, the views into it stay valid as long as the session.
+   std::unordered_set<std::string> symbols;
+   std::unordered_map<std::string_view, Variable> variables;
+   LineTimes line_times;
+
+   std::string_view intern(std::string_view name);
+};
+
+#endif // SESSION_HPP
@@ -0,0 +1,163 @@
+#include "cli/batch.hpp"
+#include "cli/run.hpp"
+#include "errors/errors.hpp"
+#include "script/script.hpp"
+#include "io/files.hpp"
+#include "io/args.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// A file run from the command line. Its output is kept until the files before it are printed.
+struct BatchFile
+{
+   std::string path;
+   std::string output;
+   std::string errors;
+   bool success = false;
+   bool done = false;
+
+   explicit BatchFile(std::string path)
+      : path(std::move(path)) {}
+};
+
+static bool run_batch_file(BatchFile& file, const Args& args, ScriptOptions options)
+{
+   options.file = file.path;
+   auto report = [&](const char* error) { file.errors += file.path + ": " + error + "\n"; };
+
+   Catcher catcher;
+   catcher.specify_error_sink(report);
+   auto source = read_file(catcher, file.path);
+
+   if (catcher.display())
+      return false;
+
+   auto script = CompiledScript::compile(source, options, {[&](const std::string& line) { file.output += line; }, report});
+   if (!script)
+      return false;
+
+   auto result = script->run({}, report);
+   if (!result.success)
+      return false;
+
+   if (args.get_arg("--log-variables"))
+   {
+      file.output += "\nVariables of '" + file.path + "':\n";
+      for (const auto& [name, value] : result.variables)
+         file.output += "[" + name + "] = " + to_string(value) + "\n";
+   }
+   return true;
+}
+
+// 'scripting run FILE... [-jN] [run arguments]' runs every file, and every script in a
+// directory, on N threads. Output and errors of every file are printed in the order of
+// the arguments, the exit status is 1 when a file failed.
+int run_batch(int argc, char** argv)
+{
+   Catcher catcher;
+
+   if (argc < 3 || std::string(argv[1]) != "run")
+   {
+      catcher.error(err::invalid_batch_command);
+      return 2;
+   }
+
+   std::vector<BatchFile> files;
+   std::string command = "run";
+   size_t jobs = 0;
+
+   for (int i = 2; i < argc; ++i)
+   {
+      std::string arg = argv[i];
+
+      if (arg.starts_with("-j"))
+      {
+         try
+         {
+            jobs = std::stoul(arg.size() > 2 ? arg.substr(2) : (i + 1 < argc ? argv[++i] : ""));
+         }
+         catch (...)
+         {
+            catcher.error(err::invalid_run_arg);
+            return 2;
+         }
+      }
+      else if (arg.starts_with("-"))
+         command += " " + arg;
+      else if (fs::is_directory(arg))
+      {
+         for (const auto& path : script_files(arg))
+            files.emplace_back(path.string());
+      }
+      else if (is_file(arg))
+         files.emplace_back(arg);
+      else
+      {
+         catcher.error(err::invalid_batch_file);
+         return 2;
+      }
+   }
+
+   Args args (catcher, command);
+   if (catcher.display() || !parse_precision(catcher, args))
+      return 2;
+
+   auto options = script_options(args, "", {});
+   if (jobs == 0)
+      jobs = std::max(1u, std::thread::hardware_concurrency());
+
+   // Files are claimed one at a time, so a slow one never holds up the others.
+   std::atomic<size_t> next = 0;
+   std::mutex mutex;
+   std::condition_variable finished;
+
+   auto work = [&]()
+   {
+      for (size_t i = next++; i < files.size(); i = next++)
+      {
+         bool success = run_batch_file(files[i], args, options);
+
+         std::lock_guard lock (mutex);
+         files[i].success = success;
+         files[i].done = true;
+         finished.notify_all();
+      }
+   };
+
+   auto start = std::chrono::high_resolution_clock::now();
+   std::vector<std::thread> workers;
+   for (size_t i = 0; i < std::min(jobs, files.size()); ++i)
+      workers.emplace_back(work);
+
+   size_t failed = 0;
+
+   for (auto& file : files)
+   {
+      {
+         std::unique_lock lock (mutex);
+         finished.wait(lock, [&]() { return file.done; });
+      }
+
+      std::fwrite(file.output.data(), 1, file.output.size(), stdout);
+      std::fflush(stdout);
+      std::fwrite(file.errors.data(), 1, file.errors.size(), stderr);
+      failed += !file.success;
+      file = BatchFile(std::move(file.path));
+   }
+
+   for (auto& worker : workers)
+      worker.join();
+   auto end = std::chrono::high_resolution_clock::now();
+
+   if (args.get_arg("--bench"))
+   {
+      double seconds = std::chrono::duration<double>(end - start).count();
+      fprintf(stderr, "%zu files (%zu failed) on %zu threads in %.1f ms, %.0f files/s\n", files.size(), failed, std::min(jobs, files.size()),
+              seconds * 1e3, seconds > 0.0 ? files.size() / seconds : 0.0);
+   }
+   return (failed ? 1 : 0);
+}
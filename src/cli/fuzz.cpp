@@ -0,0 +1,290 @@
+#include "cli/fuzz.hpp"
+#include "cli/run.hpp"
+#include "cli/script_modes.hpp"
+#include "config/precision.hpp"
+#include "errors/errors.hpp"
+#include "io/args.hpp"
+#include "script/script.hpp"
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+   enum class Kind
+   { int_kind, real_kind, bool_kind };
+
+   // Random programs of declarations over int and real variables, the statements the JIT
+   // compiles. Every program starts with the values that the JIT handles apart from the
+   // rest: ints that do not fit in 32 bits, the smallest int and NaN. Operators that need
+   // ints only get ints, so most programs pass the type checker. A program only depends
+   // on its seed.
+   class ProgramGenerator
+   {
+   public:
+      ProgramGenerator(std::uint64_t seed)
+         : random(seed) {}
+
+      std::string generate(size_t statements)
+      {
+         std::string source =
+            "real big = 100000000000000000000.0;\n"
+            "real inf = big * big * big * big * big * big * big * big * big * big * big * big * big * big * big * big;\n"
+            "real nan = inf - inf;\n"
+            "int min = -9223372036854775807 - 1;\n"
+            "int max = 9223372036854775807;\n";
+
+         this->variables = {{"big", Kind::real_kind, false, true}, {"inf", Kind::real_kind, false, true}, {"nan", Kind::real_kind, false, true},
+                            {"min", Kind::int_kind, false, true}, {"max", Kind::int_kind, false, true}};
+
+         for (size_t i = 0; i < statements; ++i)
+         {
+            static constexpr Kind kinds[] = {Kind::int_kind, Kind::int_kind, Kind::int_kind, Kind::real_kind, Kind::real_kind, Kind::bool_kind};
+            static constexpr const char* types[] = {"int", "real", "bool"};
+            auto kind = kinds[pick(std::size(kinds))];
+            std::string type = (chance(10) ? "let" : types[static_cast<size_t>(kind)]);
+            std::string name = "v" + std::to_string(i);
+            bool mut = chance(60);
+
+            // A variable without a value yet makes the JIT fall back to the bytecode, it is
+            // only read once something may have assigned it.
+            if (mut && type != "let" && chance(5))
+            {
+               source += "mut " + type + " " + name + ";\n";
+               this->variables.push_back({name, kind, mut, false});
+               continue;
+            }
+
+            // Ints from reals, NaN and the reals out of range among them.
+            auto value = (kind == Kind::int_kind && type != "let" && chance(3) ? Kind::real_kind : kind);
+            source += (mut ? "mut " : "") + type + " " + name + " = " + expression(value, 0) + ";\n";
+            this->variables.push_back({name, kind, mut, true});
+         }
+         return source;
+      }
+
+   private:
+      struct Variable
+      {
+         std::string name;
+         Kind kind;
+         bool mut;
+         bool assigned;
+      };
+
+      static constexpr size_t preluded = 5;
+
+      std::mt19937_64 random;
+      std::vector<Variable> variables;
+
+      size_t pick(size_t count)
+      {
+         return this->random() % count;
+      }
+
+      bool chance(size_t percent)
+      {
+         return pick(100) < percent;
+      }
+
+      // A variable of the kind to read or to assign, or nullptr when there is none. The
+      // edge values of the prelude are read now and then, most of them overflow.
+      Variable* variable(Kind kind, bool mut)
+      {
+         std::vector<Variable*> found;
+         bool prelude = chance(10);
+
+         for (size_t i = 0; i < this->variables.size(); ++i)
+         {
+            auto& variable = this->variables[i];
+            if (variable.kind == kind && (mut ? variable.mut : variable.assigned) && (prelude || i >= preluded))
+               found.push_back(&variable);
+         }
+         return (found.empty() ? nullptr : found[pick(found.size())]);
+      }
+
+      std::string literal(Kind kind)
+      {
+         static constexpr const char* ints[] = {"0", "1", "2", "3", "7", "-1", "63", "64", "100", "2147483648", "4611686018427387904", "9223372036854775807", "(-9223372036854775807 - 1)"};
+         static constexpr const char* reals[] = {"0.0", "0.1", "1.5", "-3.5", "2.25", "100000000000000000000.0"};
+
+         if (kind == Kind::real_kind)
+            return reals[pick(std::size(reals))];
+         if (kind == Kind::bool_kind)
+            return (chance(50) ? "(1 < 2)" : "(2 < 1)");
+         if (chance(70))
+            return std::to_string(static_cast<long long>(pick(101)) - 50);
+         return ints[pick(std::size(ints))];
+      }
+
+      Kind number()
+      {
+         return (chance(50) ? Kind::int_kind : Kind::real_kind);
+      }
+
+      std::string expression(Kind kind, size_t depth)
+      {
+         static constexpr const char* arithmetic[] = {"+", "-", "*", "+", "-", "*", "/", "%", "**"};
+         static constexpr const char* bitwise[] = {"<<", ">>", "&", "|", "^"};
+         static constexpr const char* comparison[] = {"<", "<=", ">", ">=", "==", "!="};
+         static constexpr const char* assignment[] = {"=", "+=", "-=", "*=", "/=", "%=", "**="};
+         static constexpr const char* bitwise_assignment[] = {"<<=", ">>=", "&=", "|=", "^="};
+
+         size_t choice = pick(100);
+
+         if (depth > 3 || choice < 30)
+         {
+            const auto* read = variable(kind, false);
+            return (read && chance(60) ? read->name : literal(kind));
+         }
+
+         if (choice < 40)
+            return "(" + expression(number(), depth + 1) + " ? " + expression(kind, depth + 1) + " : " + expression(kind, depth + 1) + ")";
+
+         if (kind == Kind::bool_kind)
+         {
+            if (choice < 75)
+               return "(" + expression(number(), depth + 1) + " " + comparison[pick(std::size(comparison))] + " " + expression(number(), depth + 1) + ")";
+            if (choice < 90)
+               return "(" + expression(Kind::bool_kind, depth + 1) + (chance(50) ? " && " : " || ") + expression(Kind::bool_kind, depth + 1) + ")";
+            return "!(" + expression(number(), depth + 1) + ")";
+         }
+
+         // Reals also take ints, ints only take ints.
+         auto operand = [&]() { return expression(kind == Kind::real_kind ? number() : Kind::int_kind, depth + 1); };
+
+         // Powers, shifts and divisions mostly get amounts that do not overflow or divide by zero.
+         auto amount = [&](size_t limit, size_t from) { return (chance(80) ? std::to_string(from + pick(limit - from)) : operand()); };
+         auto right = [&](const std::string& op)
+         {
+            if (op == "**" || op == "**=")
+               return amount(4, 0);
+            if (op == "<<" || op == ">>" || op == "<<=" || op == ">>=")
+               return amount(8, 0);
+            if (op == "/" || op == "%" || op == "/=" || op == "%=")
+               return amount(10, 1);
+            return operand();
+         };
+
+         if (choice < 60)
+         {
+            std::string op = arithmetic[pick(std::size(arithmetic))];
+            return "(" + operand() + " " + op + " " + right(op) + ")";
+         }
+         if (choice < 68 && kind == Kind::int_kind)
+         {
+            std::string op = bitwise[pick(std::size(bitwise))];
+            return "(" + operand() + " " + op + " " + right(op) + ")";
+         }
+         if (choice < 76)
+            return (kind == Kind::int_kind && chance(30) ? "~(" : (chance(50) ? "-(" : "+(")) + operand() + ")";
+
+         auto* target = variable(kind, true);
+         if (!target)
+            return literal(kind);
+
+         if (choice < 92 || !target->assigned)
+         {
+            bool bits = (target->assigned && kind == Kind::int_kind && chance(20));
+            std::string op = (bits ? bitwise_assignment[pick(std::size(bitwise_assignment))] : assignment[pick(target->assigned ? std::size(assignment) : 1)]);
+            auto value = right(op);
+            target->assigned = true;
+            return "(" + target->name + " " + op + " " + value + ")";
+         }
+         return (chance(50) ? "++" : "--") + target->name;
+      }
+   };
+} // namespace
+
+int run_fuzz(int argc, char** argv)
+{
+   constexpr size_t statements = 16;
+   Catcher catcher;
+   std::string command = "run";
+   size_t programs = 0;
+   bool counted = false;
+
+   for (int i = 2; i < argc; ++i)
+   {
+      std::string arg = argv[i];
+
+      if (arg.starts_with("-"))
+      {
+         command += " " + arg;
+         continue;
+      }
+
+      try
+      {
+         if (counted || arg.find_first_not_of("0123456789") != arg.npos)
+            throw std::invalid_argument(arg);
+         programs = std::stoul(arg);
+         counted = true;
+      }
+      catch (...)
+      {
+         catcher.error(err::invalid_fuzz_command);
+         return 2;
+      }
+   }
+
+   if (!counted)
+   {
+      catcher.error(err::invalid_fuzz_command);
+      return 2;
+   }
+
+   Args args (catcher, command);
+   if (catcher.display() || !parse_precision(catcher, args))
+      return 2;
+
+   auto options = script_options(args, "", {});
+   std::uint64_t seed = args.get_arg("--seed");
+   size_t finished = 0;
+   size_t mismatches = 0;
+
+   auto start = std::chrono::high_resolution_clock::now();
+   for (size_t i = 0; i < programs; ++i)
+   {
+      // Program i is the first program of seed + i, so 'fuzz 1' gives it back alone.
+      auto source = ProgramGenerator(seed + i).generate(statements);
+      std::string expected;
+
+      for (auto engine : {Engine::evaluator, Engine::vm, Engine::jit})
+      {
+         options.engine = engine;
+         auto text = script_fingerprint(source, options, nullptr, {});
+
+         if (engine == Engine::evaluator)
+         {
+            expected = text;
+            finished += (text.find("error: ") == text.npos);
+            continue;
+         }
+
+         if (text != expected)
+         {
+            fprintf(stderr, "Seed %llu:\n%s\nEvaluator:\n%s\n%s:\n%s\n", static_cast<unsigned long long>(seed + i), source.c_str(), expected.c_str(),
+                    engine == Engine::vm ? "Virtual machine" : "JIT", text.c_str());
+            ++mismatches;
+            break;
+         }
+      }
+   }
+   auto end = std::chrono::high_resolution_clock::now();
+
+   printf("%-16s %zu programs from seed %llu, %zu without errors, in %ld ms\n", "Fuzz:", programs, static_cast<unsigned long long>(seed), finished,
+          std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+   printf("%-16s %zu\n", "Mismatches:", mismatches);
+
+   if (mismatches)
+   {
+      catcher.error(err::fuzz_mismatch);
+      return 1;
+   }
+   return 0;
+}
@@ -0,0 +1,66 @@
+#include "cli/jobs.hpp"
+#include "cli/run.hpp"
+#include "config/cancellation.hpp"
+#include "errors/catcher.hpp"
+#include "errors/errors.hpp"
+#include "io/args.hpp"
+#include <cstring>
+
+void start_job(std::vector<std::unique_ptr<Job>>& jobs, size_t id, std::string command)
+{
+   auto& job = *jobs.emplace_back(std::make_unique<Job>());
+   job.id = id;
+   job.command = std::move(command);
+
+   job.thread = std::thread([&job]()
+   {
+      cancel_flag = &job.cancel;
+      Catcher catcher;
+
+      // A cancelled job is reported once it is reaped.
+      catcher.specify_error_sink([](const char* error)
+      {
+         if (std::strcmp(error, err::job_cancelled) != 0)
+            Catcher().error(error);
+      });
+
+      std::string command = job.command;
+      Args args (catcher, command);
+
+      if (!catcher.display())
+         run_file(catcher, args);
+      job.finished = true;
+   });
+
+   printf("[%zu] %s\n", job.id, job.command.c_str());
+}
+
+// Joins the jobs that finished and reports them, like a shell does before its prompt.
+void reap_jobs(std::vector<std::unique_ptr<Job>>& jobs)
+{
+   for (auto it = jobs.begin(); it != jobs.end();)
+   {
+      auto& job = **it;
+
+      if (!job.finished)
+      {
+         ++it;
+         continue;
+      }
+
+      job.thread.join();
+      printf("[%zu] %-10s %s\n", job.id, job.cancel ? "Cancelled" : "Done", job.command.c_str());
+      it = jobs.erase(it);
+   }
+}
+
+// Cancels every job and waits for them, their memory is released before quitting.
+void stop_jobs(std::vector<std::unique_ptr<Job>>& jobs)
+{
+   for (auto& job : jobs)
+      job->cancel = true;
+
+   for (auto& job : jobs)
+      job->thread.join();
+   jobs.clear();
+}
@@ -0,0 +1,594 @@
+#include "cli/run.hpp"
+#include "cli/script_modes.hpp"
+#include "config/precision.hpp"
+#include "errors/errors.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "parser/parallel_parser.hpp"
+#include "preprocessor/preprocessor.hpp"
+#include "pipeline/pipeline.hpp"
+#include "runtime/evaluator.hpp"
+#include "runtime/compiler.hpp"
+#include "runtime/vm.hpp"
+#include "runtime/jit.hpp"
+#include "io/files.hpp"
+#include "io/cache.hpp"
+#include "io/records.hpp"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <iostream>
+
+// Parses '--inputs=NAME:TYPE,...', the variables '--columns' and '--records' bind
+// to input columns.
+bool parse_inputs(Catcher& catcher, Args& args, std::vector<ColumnarProgram::Binding>& inputs)
+{
+   std::stringstream stream (args.get_word("--inputs"));
+   std::string input;
+
+   while (std::getline(stream, input, ','))
+   {
+      auto colon = input.find(':');
+      auto type = (colon == input.npos ? VType::null : type_from_name(input.substr(colon + 1)));
+
+      if (colon == 0 || (type != VType::integer && type != VType::real && type != VType::boolean))
+      {
+         catcher.error(err::invalid_inputs_arg);
+         return false;
+      }
+      inputs.push_back({input.substr(0, colon), type});
+   }
+   return true;
+}
+
+// The level of '-O0/-O1/-O2', the highest one wins.
+static size_t optimization_level(Args& args)
+{
+   size_t level = 0;
+   for (size_t i = 0; i <= 2; ++i)
+   {
+      if (args.get_arg("-O" + std::to_string(i)))
+         level = i;
+   }
+   return level;
+}
+
+// Applies '-O0/-O1/-O2', then '--enable' and '--disable', each a comma separated list of
+// pass names, and '--log-pass'.
+static bool configure_passes(Catcher& catcher, Args& args, PassManager& passes)
+{
+   passes.specify_level(optimization_level(args));
+   passes.measure(args.get_arg("--bench"));
+
+   for (std::string arg : {"--enable", "--disable", "--log-pass"})
+   {
+      std::stringstream stream (args.get_word(arg));
+      std::string name;
+
+      while (std::getline(stream, name, ','))
+      {
+         bool known = (arg == "--log-pass" ? passes.log_after(name) : passes.enable(name, arg == "--enable"));
+
+         if (!known)
+         {
+            catcher.error(err::invalid_pass_arg);
+            return false;
+         }
+      }
+   }
+   return true;
+}
+
+// Resolves, type checks, optimizes with the passes of the arguments and flattens the
+// program. Errors are displayed and give nothing.
+std::optional<FlatProgram> compile_back_end(Catcher& catcher, Args& args, Program& program, const std::vector<ColumnarProgram::Binding>& inputs, PassManager& passes, BackEnd::Times* times)
+{
+   if (!configure_passes(catcher, args, passes))
+   {
+      catcher.display();
+      return std::nullopt;
+   }
+
+   BackEnd back_end (catcher, program, passes);
+   for (const auto& input : inputs)
+      back_end.define(input.name, input.type);
+   auto flat = back_end.compile();
+
+   if (times)
+      *times = back_end.times();
+   return flat;
+}
+
+// Sets the precision of this thread to the one of '--real'.
+bool parse_precision(Catcher& catcher, Args& args)
+{
+   real_precision = Precision::double_real;
+   if (args.contains("--real"))
+   {
+      if (args.get_word("--real") == "long" && !long_reals_stored)
+      {
+         catcher.error(err::long_real_unavailable);
+         return false;
+      }
+      else if (args.get_word("--real") == "long")
+         real_precision = Precision::long_real;
+      else if (args.get_word("--real") != "double")
+      {
+         catcher.error(err::invalid_real_arg);
+         return false;
+      }
+   }
+   return true;
+}
+
+// Options of a script compiled for '--load', '--green' and the command line.
+ScriptOptions script_options(Args& args, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs)
+{
+   ScriptOptions options;
+   options.file = file;
+   options.precision = real_precision;
+   options.engine = (args.get_arg("--jit") ? Engine::jit : args.get_arg("--vm") ? Engine::vm : Engine::evaluator);
+   options.max_macro_depth = args.get_arg("--macro-depth");
+   options.predefined_macros = !args.get_arg("--no-predefined-macros");
+   options.optimization = optimization_level(args);
+
+   for (const auto& input : inputs)
+      options.inputs.push_back({input.name, input.type});
+
+   options.limits.operations = args.get_arg("--max-operations");
+   options.limits.time = std::chrono::microseconds(args.get_arg("--max-time"));
+   options.limits.memory = args.get_arg("--max-memory");
+   return options;
+}
+
+// Run i gets the inputs '--columns' gives record i.
+std::vector<Value> run_inputs(const std::vector<ColumnarProgram::Binding>& inputs, std::uint64_t run)
+{
+   std::vector<Value> values;
+
+   for (const auto& input : inputs)
+   {
+      if (input.type == VType::real)
+         values.emplace_back(static_cast<real_t>(run / 2.0));
+      else if (input.type == VType::boolean)
+         values.emplace_back(run % 2 == 1);
+      else
+         values.emplace_back(static_cast<long long>(run));
+   }
+   return values;
+}
+
+static void print_passes(const PassManager& passes)
+{
+   for (const auto& report : passes.reports())
+   {
+      auto label = "Pass " + std::string(report.name) + ":";
+      printf("%-16s %ld μs (%zu changes, %zu -> %zu nodes)\n", label.c_str(), report.time, report.changes, report.before, report.after);
+   }
+}
+
+static long passes_time(const PassManager& passes)
+{
+   long time = 0;
+
+   for (const auto& report : passes.reports())
+      time += report.time;
+   return time;
+}
+
+// Runs the program over the records of '--records', or over '--columns' generated records.
+static bool execute_columnar(Catcher& catcher, Args& args, FlatView view, const std::vector<ColumnarProgram::Binding>& inputs, Execution& execution)
+{
+   ColumnarProgram program (catcher, view, inputs);
+   auto start_com = std::chrono::high_resolution_clock::now();
+   bool compiled = program.compile();
+   auto end_com = std::chrono::high_resolution_clock::now();
+
+   if (!compiled)
+   {
+      catcher.display();
+      return false;
+   }
+
+   execution.compiled = true;
+   execution.compile_time = std::chrono::duration_cast<std::chrono::microseconds>(end_com - start_com).count();
+   execution.columnar = true;
+   execution.vectorized = ColumnarProgram::vectorized();
+   execution.instructions = program.instruction_count();
+
+   if (args.contains("--records"))
+   {
+      const auto& path = args.get_word("--records");
+      auto format = (path.ends_with(".csv") ? RecordFormat::csv : RecordFormat::ndjson);
+
+      if (args.contains("--record-format"))
+      {
+         if (args.get_word("--record-format") == "csv")
+            format = RecordFormat::csv;
+         else if (args.get_word("--record-format") == "ndjson")
+            format = RecordFormat::ndjson;
+         else
+         {
+            catcher.error(err::invalid_record_format_arg);
+            return false;
+         }
+      }
+
+      RecordReader reader (catcher, path);
+      if (catcher.display())
+         return false;
+
+      std::FILE* output = stdout;
+      if (args.contains("--output") && !(output = std::fopen(args.get_word("--output").c_str(), "w")))
+      {
+         catcher.error(err::cannot_create_file);
+         return false;
+      }
+
+      RecordStream stream (catcher, program, format, args.get_arg("--record-jobs"));
+      auto start = std::chrono::high_resolution_clock::now();
+      bool streamed = stream.run(reader, output);
+      auto end = std::chrono::high_resolution_clock::now();
+      execution.time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+      execution.evaluated = stream.record_count();
+
+      if (output != stdout)
+         std::fclose(output);
+      return streamed;
+   }
+
+   // Record i has i in int inputs, i / 2 in real inputs and i % 2 in bool inputs.
+   size_t records = args.get_arg("--columns");
+   std::vector<Column> columns;
+
+   for (const auto& input : inputs)
+   {
+      auto& column = columns.emplace_back(input.type, records);
+
+      for (size_t i = 0; i < records; ++i)
+      {
+         if (input.type == VType::real)
+            column.reals[i] = i / 2.0;
+         else
+            column.integers[i] = (input.type == VType::boolean ? i % 2 : i);
+      }
+   }
+
+   std::vector<Column> outputs;
+   std::vector<const char*> errors;
+   auto start = std::chrono::high_resolution_clock::now();
+   program.run(records, columns, outputs, errors);
+   auto end = std::chrono::high_resolution_clock::now();
+   execution.time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+   execution.evaluated = records;
+
+   auto failed = std::find_if(errors.begin(), errors.end(), [](const char* error) { return error; });
+   if (failed != errors.end())
+   {
+      catcher.error(*failed);
+      return false;
+   }
+
+   if (args.get_arg("--log-variables"))
+   {
+      for (size_t i = 0; i < records; ++i)
+      {
+         std::cout << "\nVariables of record " << i << ":\n";
+
+         for (size_t j = 0; j < outputs.size(); ++j)
+            std::cout << "[" << program.outputs()[j].name << "] = " << to_string(outputs[j].at(i)) << "\n";
+      }
+   }
+   return true;
+}
+
+// Runs a resolved and type checked program with the evaluator, or compiles it to bytecode first with
+// '--vm'. '--jit' also compiles what it can to machine code. '--columns' and '--records' run it over
+// columns of records instead.
+bool execute(Catcher& catcher, Args& args, FlatView view, const std::vector<ColumnarProgram::Binding>& inputs, Execution& execution)
+{
+   if (args.contains("--columns") || args.contains("--records"))
+      return execute_columnar(catcher, args, view, inputs, execution);
+
+   if (args.get_arg("--vm") || args.get_arg("--jit"))
+   {
+      std::optional<Jit> jit;
+      if (args.get_arg("--jit"))
+         jit.emplace(view);
+
+      auto start_com = std::chrono::high_resolution_clock::now();
+      auto chunk = Compiler(view, jit ? &*jit : nullptr).compile();
+      auto end_com = std::chrono::high_resolution_clock::now();
+      execution.compiled = true;
+      execution.compile_time = std::chrono::duration_cast<std::chrono::microseconds>(end_com - start_com).count();
+
+      if (jit)
+      {
+         execution.jitted = true;
+         execution.regions = jit->region_count();
+         execution.native_statements = jit->statement_count();
+         execution.native_code = jit->code_size();
+      }
+
+      if (args.get_arg("--log-bytecode"))
+      {
+         std::cout << "\nBytecode after compiling:\n";
+         chunk.disassemble();
+      }
+
+      VirtualMachine vm (catcher, chunk, jit ? &*jit : nullptr);
+      auto start = std::chrono::high_resolution_clock::now();
+      execution.evaluated = vm.run();
+      auto end = std::chrono::high_resolution_clock::now();
+      execution.time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+      execution.registers = vm.register_count();
+
+      if (catcher.display())
+         return false;
+
+      if (args.get_arg("--log-variables"))
+      {
+         std::cout << "\nVariables after evaluation:\n";
+         vm.print();
+      }
+      return true;
+   }
+
+   Evaluator evaluator (catcher, view);
+   auto start = std::chrono::high_resolution_clock::now();
+   execution.evaluated = evaluator.evaluate();
+   auto end = std::chrono::high_resolution_clock::now();
+   execution.time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+   if (catcher.display())
+      return false;
+
+   if (args.get_arg("--log-variables"))
+   {
+      std::cout << "\nVariables after evaluation:\n";
+      evaluator.print();
+   }
+   return true;
+}
+
+static void print_execution(const Execution& execution)
+{
+   if (execution.compiled)
+      printf("%-16s %ld μs\n", "Compiling time:", execution.compile_time);
+
+   if (execution.columnar)
+   {
+      double per_second = (execution.time ? execution.evaluated * 1e6 / execution.time : 0.0);
+      printf("%-16s %zu instructions, %s kernels\n", "Columnar:", execution.instructions, execution.vectorized ? "AVX2" : "scalar");
+      printf("%-16s %ld μs (%zu records, %.0f records/s)\n", "Evaluation time:", execution.time, execution.evaluated, per_second);
+      return;
+   }
+
+   if (execution.compiled)
+      printf("%-16s %zu x %zu bytes (%zu bytes as Value)\n", "Registers:", execution.registers, sizeof(Box), sizeof(Value));
+
+   if (execution.jitted)
+      printf("%-16s %zu regions, %zu statements, %zu bytes of machine code\n", "JIT:", execution.regions, execution.native_statements, execution.native_code);
+
+   double per_second = (execution.time ? execution.evaluated * 1e6 / execution.time : 0.0);
+   printf("%-16s %ld μs (%zu statements, %.0f statements/s)\n", "Evaluation time:", execution.time, execution.evaluated, per_second);
+}
+
+// Runs a file with the arguments of a 'run' command.
+void run_file(Catcher& catcher, Args& args)
+{
+   std::string input;
+   std::string file_name;
+
+   if (is_file(args.at(1)))
+   {
+      file_name = args.at(1);
+      input = read_file(catcher, file_name);
+
+      if (catcher.display())
+         return;
+   }
+   else
+   {
+      catcher.error(err::invalid_run_command);
+      return;
+   }
+
+   if (!parse_precision(catcher, args))
+      return;
+
+   std::vector<ColumnarProgram::Binding> inputs;
+   if ((args.contains("--columns") || args.contains("--records") || args.contains("--load") || args.contains("--green") || args.contains("--stress")) && !parse_inputs(catcher, args, inputs))
+      return;
+
+   if (args.contains("--stress"))
+   {
+      run_stress(catcher, args, input, file_name, inputs);
+      return;
+   }
+
+   if (args.contains("--load"))
+   {
+      run_load(catcher, args, input, file_name, inputs);
+      return;
+   }
+
+   if (args.contains("--green"))
+   {
+      run_green(catcher, args, input, file_name, inputs);
+      return;
+   }
+
+   std::optional<ScriptCache> cache;
+   if (args.get_arg("--cache"))
+   {
+      auto start = std::chrono::high_resolution_clock::now();
+      cache.emplace(input, file_name, cache_options(args));
+      bool hit = cache->load();
+      auto end = std::chrono::high_resolution_clock::now();
+
+      if (hit)
+      {
+         std::cout << cache->log();
+
+         if (args.get_arg("--log-parser"))
+         {
+            std::cout << "\nAST tree after parsing:\n";
+            cache->view().print();
+         }
+
+         Execution execution;
+         if (!execute(catcher, args, cache->view(), inputs, execution))
+            return;
+
+         if (args.get_arg("--bench"))
+         {
+            auto total = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+            printf("Benchmark:\n");
+            printf("%-16s %ld μs\n", "Cache load time:", total);
+            print_execution(execution);
+            printf("%-16s %ld μs\n", "Total:", total + execution.compile_time + execution.time);
+         }
+         return;
+      }
+   }
+
+   if (args.get_arg("--pipeline"))
+   {
+      Pipeline pipeline (catcher, input, file_name, args.get_arg("--skip-preprocessor"), args.get_arg("--no-predefined-macros"));
+
+      if (args.contains("--macro-depth"))
+         pipeline.specify_max_macro_depth(args.get_arg("--macro-depth"));
+
+      auto start = std::chrono::high_resolution_clock::now();
+      auto& program = pipeline.run();
+      auto end = std::chrono::high_resolution_clock::now();
+
+      if (catcher.display())
+         return;
+
+      if (args.get_arg("--log-parser"))
+      {
+         std::cout << "\nAST tree after parsing:\n";
+         program.print();
+      }
+
+      PassManager passes (catcher, program);
+      auto flat = compile_back_end(catcher, args, program, inputs, passes);
+
+      if (!flat)
+         return;
+
+      if (cache && pipeline.is_deterministic())
+         cache->store(*flat, pipeline.get_included_files(), pipeline.get_log());
+
+      Execution execution;
+      if (!execute(catcher, args, flat->view(), inputs, execution))
+         return;
+
+      if (args.get_arg("--bench"))
+      {
+         auto total = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+         printf("Benchmark:\n");
+         printf("%-16s %ld μs\n", "Pipeline time:", total);
+         print_passes(passes);
+         print_execution(execution);
+      }
+      return;
+   }
+
+   Lexer lexer (catcher, input);
+   auto start_lex = std::chrono::high_resolution_clock::now();
+   auto& tokens = lexer.tokenize();
+   auto end_lex = std::chrono::high_resolution_clock::now();
+
+   if (catcher.display())
+      return;
+
+   if (args.get_arg("--log-lexer"))
+   {
+      std::cout << "\nTokens after lexing:\n";
+      for (const auto& token : tokens)
+         printf("%-13s - \"%s\"\n", token_to_string(token.type), token.lexeme.c_str());
+   }
+
+   std::chrono::time_point<std::chrono::high_resolution_clock> start_pre, end_pre;
+   Preprocessor preprocessor (catcher, tokens, file_name, args.get_arg("--no-predefined-macros"));
+
+   if (!args.get_arg("--skip-preprocessor"))
+   {
+      if (args.contains("--macro-depth"))
+         preprocessor.specify_max_macro_depth(args.get_arg("--macro-depth"));
+
+      start_pre = std::chrono::high_resolution_clock::now();
+      preprocessor.process();
+      end_pre = std::chrono::high_resolution_clock::now();
+
+      if (catcher.display())
+         return;
+   }
+
+   if (args.get_arg("--log-preprocessor"))
+   {
+      std::cout << "\nTokens after preprocessing:\n";
+      for (const auto& token : tokens)
+         printf("%-13s - \"%s\"\n", token_to_string(token.type), token.lexeme.c_str());
+   }
+
+   Parser parser (catcher, tokens);
+   ParallelParser parallel_parser (catcher, tokens, args.get_arg("--parse-jobs"));
+   auto start_par = std::chrono::high_resolution_clock::now();
+   auto& program = (args.contains("--parse-jobs") ? parallel_parser.parse() : parser.parse());
+   auto end_par = std::chrono::high_resolution_clock::now();
+
+   if (catcher.display())
+      return;
+
+   if (args.get_arg("--log-parser") && !args.get_arg("--flat-ast"))
+   {
+      std::cout << "\nAST tree after parsing:\n";
+      program.print();
+   }
+
+   PassManager passes (catcher, program);
+   BackEnd::Times times;
+   auto flat = compile_back_end(catcher, args, program, inputs, passes, &times);
+
+   if (!flat)
+      return;
+
+   if (cache && preprocessor.is_deterministic())
+      cache->store(*flat, preprocessor.get_included_files(), preprocessor.get_log());
+
+   // The flat AST only exists after the passes, it is what gets evaluated.
+   if (args.get_arg("--log-parser") && args.get_arg("--flat-ast"))
+   {
+      std::cout << "\nFlat AST tree after the passes:\n";
+      flat->print();
+   }
+
+   Execution execution;
+   if (!execute(catcher, args, flat->view(), inputs, execution))
+      return;
+
+   if (args.get_arg("--bench"))
+   {
+      auto lex = std::chrono::duration_cast<std::chrono::microseconds>(end_lex - start_lex).count();
+      auto pre = std::chrono::duration_cast<std::chrono::microseconds>(end_pre - start_pre).count();
+      auto par = std::chrono::duration_cast<std::chrono::microseconds>(end_par - start_par).count();
+
+      printf("Benchmark:\n");
+      printf("%-16s %ld μs\n", "Lexing time:", lex);
+      printf("%-16s %ld μs\n", "Processing time:", pre);
+      printf("%-16s %ld μs\n", "Parsing time:", par);
+      printf("%-16s %ld μs\n", "Resolving time:", times.resolve);
+      printf("%-16s %ld μs (%zu typed nodes)\n", "Checking time:", times.check, times.typed);
+      print_passes(passes);
+      printf("%-16s %ld μs\n", "Flattening time:", times.flatten);
+      print_execution(execution);
+      printf("%-16s %ld μs\n", "Total:", lex + pre + par + times.resolve + times.check + passes_time(passes) + times.flatten + execution.compile_time + execution.time);
+   }
+}
@@ -0,0 +1,199 @@
+#include "cli/script_modes.hpp"
+#include "cli/run.hpp"
+#include "config/precision.hpp"
+#include "errors/errors.hpp"
+#include "script/script.hpp"
+#include "script/script_service.hpp"
+#include "script/green_scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+// Runs the script '--load' times through a ScriptService at every concurrency level, keeping
+// that many runs in flight: a run that finishes submits the next one.
+bool run_load(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs)
+{
+   auto script = CompiledScript::compile(source, script_options(args, file, inputs));
+   if (!script)
+      return false;
+
+   std::uint64_t runs = args.get_arg("--load");
+   size_t workers = args.get_arg("--load-workers");
+   if (workers == 0)
+      workers = std::max(1u, std::thread::hardware_concurrency());
+   printf("Load of %llu runs on %zu workers:\n", static_cast<unsigned long long>(runs), workers);
+
+   for (std::uint64_t concurrency : {1, 4, 16, 64, 256})
+   {
+      ScriptService service (workers);
+      std::atomic<std::uint64_t> issued = std::min(concurrency, runs);
+      std::atomic<const char*> failure = nullptr;
+      std::function<void(ScriptResult&)> done;
+
+      done = [&](ScriptResult& result)
+      {
+         const char* expected = nullptr;
+         if (result.error)
+            failure.compare_exchange_strong(expected, result.error);
+
+         auto run = issued++;
+         if (run < runs)
+            service.submit({script, run_inputs(inputs, run), done});
+      };
+
+      auto start = std::chrono::high_resolution_clock::now();
+      for (std::uint64_t run = 0; run < std::min(concurrency, runs); ++run)
+         service.submit({script, run_inputs(inputs, run), done});
+      service.wait();
+      auto end = std::chrono::high_resolution_clock::now();
+
+      if (failure)
+      {
+         catcher.error(failure);
+         return false;
+      }
+
+      auto stats = service.stats();
+      double seconds = std::chrono::duration<double>(end - start).count();
+      auto label = "Concurrency " + std::to_string(concurrency) + ":";
+
+      printf("%-16s p50 %.1f μs, p99 %.1f μs, %.0f runs/s, %llu stolen\n", label.c_str(), stats.latency.percentile(0.5) / 1e3, stats.latency.percentile(0.99) / 1e3,
+             seconds > 0.0 ? runs / seconds : 0.0, static_cast<unsigned long long>(stats.stolen));
+   }
+   return true;
+}
+
+// Starts '--green' runs of the script on this thread at once and lets them take turns of
+// '--green-quantum' steps until all of them finished.
+bool run_green(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs)
+{
+   auto script = CompiledScript::compile(source, script_options(args, file, inputs));
+   if (!script)
+      return false;
+
+   std::uint64_t runs = args.get_arg("--green");
+   GreenScheduler scheduler (args.contains("--green-quantum") ? args.get_arg("--green-quantum") : 64);
+   const char* failure = nullptr;
+
+   auto done = [&](ScriptResult& result)
+   {
+      if (result.error && !failure)
+         failure = result.error;
+   };
+
+   auto start = std::chrono::high_resolution_clock::now();
+   for (std::uint64_t run = 0; run < runs; ++run)
+      scheduler.spawn({script, run_inputs(inputs, run), done});
+   auto spawned = std::chrono::high_resolution_clock::now();
+   scheduler.run();
+   auto end = std::chrono::high_resolution_clock::now();
+
+   if (failure)
+   {
+      catcher.error(failure);
+      return false;
+   }
+
+   const auto& stats = scheduler.stats();
+   double seconds = std::chrono::duration<double>(end - spawned).count();
+   double turns = static_cast<double>(stats.switches + stats.completed);
+
+   printf("%-16s %llu runs alive at once\n", "Green runs:", static_cast<unsigned long long>(stats.peak));
+   printf("%-16s %ld μs\n", "Spawn time:", std::chrono::duration_cast<std::chrono::microseconds>(spawned - start).count());
+   printf("%-16s %ld μs\n", "Run time:", std::chrono::duration_cast<std::chrono::microseconds>(end - spawned).count());
+   printf("%-16s %llu (%.0f ns per turn)\n", "Switches:", static_cast<unsigned long long>(stats.switches), turns > 0.0 ? seconds * 1e9 / turns : 0.0);
+   printf("%-16s %.0f runs/s\n", "Throughput:", seconds > 0.0 ? runs / seconds : 0.0);
+   return true;
+}
+
+std::string script_fingerprint(const std::string& source, const ScriptOptions& options, const CompiledScript* shared, const std::vector<Value>& inputs)
+{
+   std::string text;
+   ScriptSinks sinks {[&](const std::string& line) { text += line; }, [&](const char* error) { text += "error: " + std::string(error) + "\n"; }};
+
+   auto script = CompiledScript::compile(source, options, sinks);
+   if (!script)
+      return text;
+
+   // Runs of the shared script, compiled on another thread, have to give the same.
+   for (const auto* compiled : {script.get(), shared})
+   {
+      if (!compiled)
+         continue;
+
+      auto result = compiled->run(inputs, sinks.diagnostics);
+      real_precision = options.precision;
+
+      for (const auto& [name, value] : result.variables)
+         text += "[" + name + "] = " + to_string(value) + "\n";
+   }
+   return text;
+}
+
+// Compiles and runs the script on '--stress' threads at once, with every engine at both
+// precisions, and checks that every thread gets what one thread alone gets.
+bool run_stress(Catcher& catcher, Args& args, const std::string& source, const std::string& file, const std::vector<ColumnarProgram::Binding>& inputs)
+{
+   constexpr size_t rounds = 8;
+   auto base = script_options(args, file, inputs);
+   auto values = run_inputs(inputs, 0);
+   auto precision = real_precision;
+
+   std::vector<ScriptOptions> configurations;
+   std::vector<std::shared_ptr<const CompiledScript>> scripts;
+   std::vector<std::string> expected;
+
+   for (auto engine : {Engine::evaluator, Engine::vm, Engine::jit})
+   {
+      for (auto real : {Precision::double_real, Precision::long_real})
+      {
+         if (real == Precision::long_real && !long_reals_stored)
+            continue;
+
+         auto options = base;
+         options.engine = engine;
+         options.precision = real;
+
+         configurations.push_back(options);
+         scripts.push_back(CompiledScript::compile(source, options, {[](const std::string&) {}, [](const char*) {}}));
+         expected.push_back(script_fingerprint(source, options, scripts.back().get(), values));
+      }
+   }
+
+   size_t threads = args.get_arg("--stress");
+   std::atomic<size_t> mismatches = 0;
+   std::vector<std::thread> workers;
+
+   auto start = std::chrono::high_resolution_clock::now();
+   for (size_t i = 0; i < threads; ++i)
+   {
+      workers.emplace_back([&, i]()
+      {
+         // Threads start at different configurations, so all of them are used at once.
+         for (size_t round = 0; round < rounds * configurations.size(); ++round)
+         {
+            size_t index = (i + round) % configurations.size();
+            auto text = script_fingerprint(source, configurations[index], scripts[index].get(), values);
+            mismatches += (text != expected[index]);
+         }
+      });
+   }
+
+   for (auto& worker : workers)
+      worker.join();
+   auto end = std::chrono::high_resolution_clock::now();
+   real_precision = precision;
+
+   size_t compiles = threads * rounds * configurations.size();
+   printf("%-16s %zu threads, %zu configurations, %zu compiles and %zu runs in %ld ms\n", "Stress:", threads, configurations.size(), compiles, compiles * 2,
+          std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count());
+   printf("%-16s %zu\n", "Mismatches:", mismatches.load());
+
+   if (mismatches)
+   {
+      catcher.error(err::stress_mismatch);
+      return false;
+   }
+   return true;
+}
@@ -0,0 +1,171 @@
+#include "cli/watch.hpp"
+#include "cli/run.hpp"
+#include "errors/errors.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "parser/parallel_parser.hpp"
+#include "preprocessor/preprocessor.hpp"
+#include "io/files.hpp"
+#include "io/watcher.hpp"
+#include <chrono>
+#include <iostream>
+
+// What a watched file keeps from one run to the next.
+struct WatchState
+{
+   TokenCache tokens;
+   // Tokens after preprocessing of the last run that got past the preprocessor.
+   std::vector<Token> processed;
+   bool ran = false;
+   std::unordered_set<std::string> files;
+};
+
+static bool same_tokens(const std::vector<Token>& first, const std::vector<Token>& second)
+{
+   return std::equal(first.begin(), first.end(), second.begin(), second.end(), [](const Token& a, const Token& b) { return a.type == b.type && a.lexeme == b.lexeme; });
+}
+
+// Runs a watched file again. Only files that were saved are read and lexed again, and a
+// program that is the same after preprocessing is not parsed and run again.
+static void watch_run(Catcher& catcher, Args& args, const std::string& file_name, const std::vector<ColumnarProgram::Binding>& inputs, WatchState& state)
+{
+   auto& cache = state.tokens;
+
+   if (!cache.contains(file_name))
+   {
+      std::string input = read_file(catcher, file_name);
+
+      if (catcher.display())
+         return;
+
+      Lexer lexer (catcher, input);
+      auto& lexed = lexer.tokenize();
+
+      if (catcher.display())
+         return;
+      cache.insert({file_name, lexed});
+   }
+
+   auto tokens = cache.at(file_name);
+   Preprocessor preprocessor (catcher, tokens, file_name, args.get_arg("--no-predefined-macros"));
+
+   if (!args.get_arg("--skip-preprocessor"))
+   {
+      if (args.contains("--macro-depth"))
+         preprocessor.specify_max_macro_depth(args.get_arg("--macro-depth"));
+
+      preprocessor.specify_token_cache(&cache);
+      preprocessor.process();
+   }
+
+   // Imports that failed are still watched, saving them fixes the run.
+   auto files = preprocessor.get_included_files();
+   files.insert(file_name);
+
+   if (catcher.display())
+   {
+      state.files.insert(files.begin(), files.end());
+      return;
+   }
+   state.files = std::move(files);
+
+   // Files that are no longer imported are not watched, so their tokens could go stale.
+   std::erase_if(cache, [&](const auto& entry) { return !state.files.contains(entry.first); });
+
+   if (state.ran && same_tokens(tokens, state.processed))
+   {
+      printf("Unchanged after preprocessing, not run again.\n");
+      return;
+   }
+   state.processed = tokens;
+   state.ran = false;
+
+   Parser parser (catcher, tokens);
+   ParallelParser parallel_parser (catcher, tokens, args.get_arg("--parse-jobs"));
+   auto& program = (args.contains("--parse-jobs") ? parallel_parser.parse() : parser.parse());
+
+   if (catcher.display())
+      return;
+
+   PassManager passes (catcher, program);
+   auto flat = compile_back_end(catcher, args, program, inputs, passes);
+
+   if (!flat)
+      return;
+
+   Execution execution;
+   state.ran = execute(catcher, args, flat->view(), inputs, execution);
+}
+
+// Time of the last save of the files, or now when none of them can be read.
+static std::chrono::system_clock::time_point saved_at(const std::vector<std::string>& files)
+{
+   auto now = std::chrono::system_clock::now();
+   auto saved = std::chrono::system_clock::time_point::min();
+
+   for (const auto& file : files)
+   {
+      std::error_code error;
+      auto time = fs::last_write_time(file, error);
+
+      if (!error)
+         saved = std::max(saved, std::chrono::time_point_cast<std::chrono::system_clock::duration>(std::chrono::file_clock::to_sys(time)));
+   }
+   return (saved == std::chrono::system_clock::time_point::min() ? now : std::min(saved, now));
+}
+
+// 'watch FILE.q [run arguments]' runs the file, and again every time it or a file it
+// imports is saved, until a line is entered.
+void watch_file(Catcher& catcher, Args& args)
+{
+   if (!is_file(args.at(1)))
+   {
+      catcher.error(err::invalid_watch_command);
+      return;
+   }
+   std::string file_name = args.at(1);
+
+   FileWatcher watcher;
+   if (!watcher.valid())
+   {
+      catcher.error(err::watch_unavailable);
+      return;
+   }
+
+   if (!parse_precision(catcher, args))
+      return;
+
+   std::vector<ColumnarProgram::Binding> inputs;
+   if ((args.contains("--columns") || args.contains("--records")) && !parse_inputs(catcher, args, inputs))
+      return;
+
+   WatchState state;
+   watch_run(catcher, args, file_name, inputs, state);
+   printf("Watching %zu files, press Enter to stop.\n", state.files.size());
+
+   while (true)
+   {
+      watcher.watch(state.files);
+      auto saved = watcher.wait(fileno(stdin));
+
+      if (saved.empty())
+         break;
+
+      auto save = saved_at(saved);
+      size_t cached = state.tokens.size();
+      for (const auto& file : saved)
+         cached -= state.tokens.erase(file);
+
+      std::string names;
+      for (const auto& file : saved)
+         names += (names.empty() ? "'" : ", '") + file + "'";
+      printf("\nSaved %s:\n", names.c_str());
+      watch_run(catcher, args, file_name, inputs, state);
+
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - save).count();
+      printf("Saved to result in %.1f ms, %zu of %zu files lexed again.\n", latency / 1e3, state.tokens.size() - cached, state.tokens.size());
+   }
+
+   std::string line;
+   std::getline(std::cin, line);
+}
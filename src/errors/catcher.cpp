@@ -1,6 +1,11 @@
 #include "errors/catcher.hpp"
 #include <iostream>
 
+void Catcher::specify_error_sink(ErrorSink error_sink)
+{
+   this->error_sink = std::move(error_sink);
+}
+
 void Catcher::insert(const char* error)
 {
    this->errors.push_back(error);
@@ -12,6 +17,12 @@ void Catcher::error(const char* error)
    display();
 }
 
+void Catcher::merge(Catcher& other)
+{
+   this->errors.insert(this->errors.end(), other.errors.begin(), other.errors.end());
+   other.errors.clear();
+}
+
 bool Catcher::empty() const
 {
    return this->errors.empty();
@@ -22,7 +33,16 @@ bool Catcher::display()
    const auto count = this->errors.size();
    if (!count)
       return false;
-   
+
+   if (this->error_sink)
+   {
+      for (const auto& error : this->errors)
+         this->error_sink(error);
+
+      this->errors.clear();
+      return true;
+   }
+
    #if defined(__linux__) || defined(__APPLE__)
    std::cout << "\n\033[38;2;255;0;0m";
    std::cout << count << " error" << (count == 1 ? char{} : 's') << " occurred:";
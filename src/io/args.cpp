@@ -4,6 +4,12 @@
 
 inline static std::string decoy = "";
 
+// Arguments that take a word instead of an integer.
+static bool takes_word(const std::string& argument)
+{
+   return argument == "--real" || argument == "--enable" || argument == "--disable" || argument == "--log-pass" || argument == "--inputs" || argument == "--records" || argument == "--record-format" || argument == "--output";
+}
+
 Args::Args(Catcher& catcher, std::string& command)
    : catcher(catcher), command(command)
 {
@@ -24,6 +30,12 @@ Args::Args(Catcher& catcher, std::string& command)
 
       if (pos == arg.npos)
          this->args.insert({arg, 1});
+      else if (takes_word(arg.substr(0, pos)))
+      {
+         this->words.insert({arg.substr(0, pos), arg.substr(pos + 1)});
+         arg = arg.substr(0, pos);
+         this->args.insert({arg, 1});
+      }
       else
       {
          try
@@ -40,7 +52,7 @@ Args::Args(Catcher& catcher, std::string& command)
       this->indexes.insert({index++, arg});
 
       // Wow...
-      if (first && arg != "quit" && arg != "run" && arg != "help" && arg != "version" && arg != "cat")
+      if (first && arg != "quit" && arg != "run" && arg != "help" && arg != "version" && arg != "cat" && arg != "jobs" && arg != "cancel" && arg != "bench" && arg != "watch")
          break;
       first = false;
    }
@@ -68,6 +80,13 @@ size_t Args::get_arg(const std::string& argument) const
    return this->args.at(argument);
 }
 
+const std::string& Args::get_word(const std::string& argument) const
+{
+   if (this->words.find(argument) == this->words.end())
+      return decoy;
+   return this->words.at(argument);
+}
+
 std::string& Args::at(size_t index)
 {
    if (this->indexes.find(index) == this->indexes.end())
@@ -0,0 +1,368 @@
+#include "io/cache.hpp"
+#include "config/precision.hpp"
+#include "config/version.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct CacheHeader
+{
+   std::uint32_t magic;
+   std::uint32_t format;
+   std::uint64_t key;
+   std::uint64_t version;
+   std::uint64_t node_count;
+   std::uint64_t statement_count;
+   std::uint64_t real_count;
+   std::uint64_t string_size;
+   std::uint64_t log_size;
+   std::uint64_t file_size;
+};
+
+constexpr std::uint32_t cache_magic  = 0x31435351; // "QSC1"
+// Reals are stored as real_t, builds with REAL_LONG_DOUBLE have a format of their own.
+constexpr std::uint32_t cache_format = (long_reals_stored ? 5 : 4);
+
+static size_t align(size_t offset)
+{
+   return (offset + 15) & ~size_t{15};
+}
+
+std::uint64_t hash_bytes(std::string_view bytes, std::uint64_t seed)
+{
+   std::uint64_t hash = seed;
+
+   for (unsigned char byte : bytes)
+   {
+      hash ^= byte;
+      hash *= 1099511628211ull;
+   }
+   return hash;
+}
+
+// Entries are programs that get run, so they live in a directory only the user can
+// write: '$XDG_CACHE_HOME' or '~/.cache'. Empty when there is none.
+static fs::path cache_directory()
+{
+   #if defined(__linux__) || defined(__APPLE__)
+   const char* xdg = std::getenv("XDG_CACHE_HOME");
+   const char* home = std::getenv("HOME");
+
+   if (xdg && fs::path(xdg).is_absolute())
+      return fs::path(xdg) / "scripting_language";
+   if (home && fs::path(home).is_absolute())
+      return fs::path(home) / ".cache" / "scripting_language";
+   return {};
+   #else
+   return fs::temp_directory_path() / "scripting_language_cache";
+   #endif
+}
+
+#if defined(__linux__) || defined(__APPLE__)
+// Owned by the user and not writable by anyone else.
+static bool trusted(const struct stat& status)
+{
+   return status.st_uid == geteuid() && (status.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+static bool trusted_directory(const fs::path& directory)
+{
+   struct stat status;
+   return lstat(directory.c_str(), &status) == 0 && S_ISDIR(status.st_mode) && trusted(status);
+}
+#endif
+
+std::string cache_options(Args& args)
+{
+   std::string options;
+
+   for (size_t i = 2; i < args.size(); ++i)
+   {
+      const auto& arg = args.at(i);
+
+      if (arg.rfind("--log-", 0) == 0 || arg == "--bench" || arg == "--cache")
+         continue;
+      if (!args.get_word(arg).empty())
+         options += arg + "=" + args.get_word(arg) + ";";
+      else
+         options += arg + "=" + std::to_string(args.get_arg(arg)) + ";";
+   }
+   return options;
+}
+
+ScriptCache::ScriptCache(const std::string& source, const std::string& file, const std::string& options)
+{
+   this->key = hash_bytes(version::string);
+   this->key = hash_bytes(file, this->key);
+   this->key = hash_bytes(options, this->key);
+   this->key = hash_bytes(source, this->key);
+
+   std::ostringstream name;
+   name << std::hex << std::setw(16) << std::setfill('0') << this->key << ".qc";
+
+   auto directory = cache_directory();
+   if (!directory.empty())
+      this->path = directory / name.str();
+}
+
+ScriptCache::~ScriptCache()
+{
+   unmap();
+}
+
+bool ScriptCache::load()
+{
+   if (this->path.empty())
+      return false;
+
+   #if defined(__linux__) || defined(__APPLE__)
+   if (!trusted_directory(this->path.parent_path()))
+      return false;
+
+   int fd = open(this->path.c_str(), O_RDONLY | O_NOFOLLOW);
+   if (fd < 0)
+      return false;
+
+   // Entries someone else could have written are not run.
+   struct stat status;
+   if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || !trusted(status) || static_cast<size_t>(status.st_size) < sizeof(CacheHeader))
+   {
+      close(fd);
+      return false;
+   }
+   size_t size = status.st_size;
+
+   void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+
+   if (data == MAP_FAILED)
+      return false;
+
+   this->mapping = data;
+   this->mapping_size = size;
+   const char* bytes = static_cast<const char*>(data);
+   #else
+   std::error_code error;
+   size_t size = fs::file_size(this->path, error);
+
+   if (error || size < sizeof(CacheHeader))
+      return false;
+
+   std::ifstream file (this->path, std::ios::binary);
+   this->buffer.reset(new char[size]);
+
+   if (!file.read(this->buffer.get(), size))
+      return false;
+   const char* bytes = this->buffer.get();
+   #endif
+
+   if (parse(bytes, size))
+      return true;
+
+   unmap();
+   return false;
+}
+
+bool ScriptCache::parse(const char* bytes, size_t size)
+{
+   CacheHeader header;
+   std::memcpy(&header, bytes, sizeof(header));
+
+   if (header.magic != cache_magic || header.format != cache_format || header.key != this->key || header.version != version::version)
+      return false;
+
+   // Every count is bounded by the size first, so the offsets below cannot overflow.
+   if (header.real_count > size / sizeof(real_t) || header.node_count > size / sizeof(FlatNode) || header.statement_count > size / sizeof(std::uint32_t) ||
+       header.string_size > size || header.log_size > size || header.file_size > size)
+      return false;
+
+   size_t reals = align(sizeof(CacheHeader));
+   size_t nodes = align(reals + header.real_count * sizeof(real_t));
+   size_t statements = align(nodes + header.node_count * sizeof(FlatNode));
+   size_t strings = align(statements + header.statement_count * sizeof(std::uint32_t));
+   size_t log = strings + header.string_size;
+   size_t files = log + header.log_size;
+
+   if (files + header.file_size != size)
+      return false;
+
+   // Every file the script imported must still hash to the recorded value.
+   for (size_t offset = files; offset < size;)
+   {
+      std::uint64_t hash, length;
+      if (size - offset < sizeof(hash) + sizeof(length))
+         return false;
+
+      std::memcpy(&hash, bytes + offset, sizeof(hash));
+      std::memcpy(&length, bytes + offset + sizeof(hash), sizeof(length));
+      offset += sizeof(hash) + sizeof(length);
+
+      if (length > size - offset)
+         return false;
+
+      std::string file (bytes + offset, length);
+      offset += length;
+
+      Catcher catcher;
+      if (!is_file(file) || hash_bytes(read_file(catcher, file)) != hash || !catcher.empty())
+         return false;
+   }
+
+   this->flat.reals = {reinterpret_cast<const real_t*>(bytes + reals), header.real_count};
+   this->flat.nodes = {reinterpret_cast<const FlatNode*>(bytes + nodes), header.node_count};
+   this->flat.statements = {reinterpret_cast<const std::uint32_t*>(bytes + statements), header.statement_count};
+   this->flat.strings = {bytes + strings, header.string_size};
+   this->logged = {bytes + log, header.log_size};
+
+   // Children always precede their parent, which also rules out cycles.
+   for (std::uint32_t i = 0; i < this->flat.nodes.size(); ++i)
+   {
+      const auto& node = this->flat.nodes[i];
+      bool valid = true;
+
+      switch (node.tag)
+      {
+      case StmtType::var_decl:
+         valid = node.first < i && node.children.second < i && node.children.third < i;
+         valid = valid && this->flat.nodes[node.children.third].tag == StmtType::identifier;
+         break;
+      case StmtType::ternary:
+         valid = node.first < i && node.children.second < i && node.children.third < i;
+         break;
+      case StmtType::assignment:
+      case StmtType::binary:
+         valid = node.first < i && node.children.second < i;
+         break;
+      case StmtType::unary:
+         valid = node.first < i;
+         break;
+      case StmtType::type:
+      case StmtType::identifier:
+      case StmtType::string:
+         valid = size_t{node.text.offset} + node.text.length <= header.string_size;
+         break;
+      case StmtType::real:
+         valid = node.first < header.real_count;
+         break;
+      case StmtType::null:
+      case StmtType::integer:
+      case StmtType::character:
+         break;
+      default:
+         valid = false;
+      }
+
+      if (!valid || node.type < VType::null || node.type > VType::string)
+         return false;
+   }
+
+   for (auto statement : this->flat.statements)
+      if (statement >= this->flat.nodes.size())
+         return false;
+   return true;
+}
+
+void ScriptCache::store(const FlatProgram& flat, const std::unordered_set<std::string>& files, const std::string& log) const
+{
+   std::string imports;
+   for (const auto& file : files)
+   {
+      Catcher catcher;
+      std::uint64_t hash = hash_bytes(read_file(catcher, file));
+      std::uint64_t length = file.size();
+
+      if (!catcher.empty())
+         return;
+
+      imports.append(reinterpret_cast<const char*>(&hash), sizeof(hash));
+      imports.append(reinterpret_cast<const char*>(&length), sizeof(length));
+      imports.append(file);
+   }
+
+   CacheHeader header {cache_magic, cache_format, this->key, version::version, flat.nodes.size(), flat.statements.size(), flat.reals.size(), flat.strings.size(), log.size(), imports.size()};
+
+   std::string data (align(sizeof(header)), '\0');
+   std::memcpy(data.data(), &header, sizeof(header));
+
+   data.append(reinterpret_cast<const char*>(flat.reals.data()), flat.reals.size() * sizeof(real_t));
+   data.resize(align(data.size()), '\0');
+   data.append(reinterpret_cast<const char*>(flat.nodes.data()), flat.nodes.size() * sizeof(FlatNode));
+   data.resize(align(data.size()), '\0');
+   data.append(reinterpret_cast<const char*>(flat.statements.data()), flat.statements.size() * sizeof(std::uint32_t));
+   data.resize(align(data.size()), '\0');
+   data += flat.strings;
+   data += log;
+   data += imports;
+
+   if (this->path.empty())
+      return;
+
+   // Written next to the entry and renamed, so concurrent runs never see half a file.
+   std::error_code error;
+   auto directory = this->path.parent_path();
+   auto temporary = this->path;
+   temporary += "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + ".tmp";
+
+   #if defined(__linux__) || defined(__APPLE__)
+   fs::create_directories(directory.parent_path(), error);
+   mkdir(directory.c_str(), 0700);
+
+   if (!trusted_directory(directory))
+      return;
+
+   int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+   if (fd < 0)
+      return;
+
+   bool written = (write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size()));
+   close(fd);
+
+   if (!written)
+   {
+      fs::remove(temporary, error);
+      return;
+   }
+   #else
+   fs::create_directories(directory, error);
+
+   std::ofstream file (temporary, std::ios::binary);
+   if (!file.write(data.data(), data.size()))
+      return;
+   file.close();
+   #endif
+
+   fs::rename(temporary, this->path, error);
+   if (error)
+      fs::remove(temporary, error);
+}
+
+const FlatView& ScriptCache::view() const
+{
+   return this->flat;
+}
+
+std::string_view ScriptCache::log() const
+{
+   return this->logged;
+}
+
+void ScriptCache::unmap()
+{
+   #if defined(__linux__) || defined(__APPLE__)
+   if (this->mapping)
+      munmap(this->mapping, this->mapping_size);
+   #endif
+   this->mapping = nullptr;
+   this->mapping_size = 0;
+   this->buffer.reset();
+}
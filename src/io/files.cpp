@@ -1,5 +1,6 @@
 #include "errors/errors.hpp"
 #include "io/files.hpp"
+#include <algorithm>
 #include <fstream>
 
 bool is_file(const fs::path& path)
@@ -26,3 +27,17 @@ std::string read_file(Catcher& catcher, const fs::path& path)
    file.close();
    return result;
 }
+
+std::vector<fs::path> script_files(const fs::path& directory)
+{
+   std::vector<fs::path> files;
+
+   for (const auto& entry : fs::recursive_directory_iterator(directory))
+   {
+      if (entry.is_regular_file() && entry.path().extension() == ".q")
+         files.push_back(entry.path());
+   }
+
+   std::sort(files.begin(), files.end());
+   return files;
+}
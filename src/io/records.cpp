@@ -0,0 +1,618 @@
+#include "io/records.hpp"
+#include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define RECORDS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+   std::string_view trim(std::string_view text)
+   {
+      while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+         text.remove_prefix(1);
+      while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+         text.remove_suffix(1);
+      return text;
+   }
+
+   // Ints and reals must be numbers with nothing around them, bools 'true', 'false', 1 or 0.
+   bool parse_value(std::string_view text, Column& column, size_t record)
+   {
+      const char* end = text.data() + text.size();
+
+      switch (column.type)
+      {
+      case VType::integer:
+      {
+         auto [last, error] = std::from_chars(text.data(), end, column.integers[record]);
+         return error == std::errc() && last == end;
+      }
+      case VType::real:
+      {
+         auto [last, error] = std::from_chars(text.data(), end, column.reals[record]);
+         return error == std::errc() && last == end;
+      }
+      case VType::boolean:
+         if (text == "true" || text == "1")
+            column.integers[record] = 1;
+         else if (text == "false" || text == "0")
+            column.integers[record] = 0;
+         else
+            return false;
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   // Skips the string starting at 'position' and returns its contents with the escapes
+   // left in, keys are matched as written.
+   bool json_string(std::string_view line, size_t& position, std::string_view& contents)
+   {
+      size_t start = ++position;
+
+      for (; position < line.size(); ++position)
+      {
+         if (line[position] == '\\')
+            ++position;
+         else if (line[position] == '"')
+         {
+            contents = line.substr(start, position++ - start);
+            return true;
+         }
+      }
+      return false;
+   }
+
+   // Skips a value that is not an input, nested objects and arrays included.
+   bool json_skip(std::string_view line, size_t& position)
+   {
+      size_t depth = 0;
+      std::string_view contents;
+
+      while (position < line.size())
+      {
+         char c = line[position];
+
+         if (c == '"')
+         {
+            if (!json_string(line, position, contents))
+               return false;
+         }
+         else if (c == '{' || c == '[')
+         {
+            ++depth;
+            ++position;
+         }
+         else if (c == '}' || c == ']')
+         {
+            if (depth == 0)
+               return true;
+            --depth;
+            ++position;
+         }
+         else if (c == ',' && depth == 0)
+            return true;
+         else
+            ++position;
+      }
+      return depth == 0;
+   }
+
+   void skip_spaces(std::string_view line, size_t& position)
+   {
+      while (position < line.size() && (line[position] == ' ' || line[position] == '\t' || line[position] == '\r'))
+         ++position;
+   }
+
+   void append_number(std::string& output, auto number)
+   {
+      char buffer[32];
+      auto [last, error] = std::to_chars(buffer, buffer + sizeof(buffer), number);
+      output.append(buffer, last);
+   }
+} // namespace
+
+RecordReader::RecordReader(Catcher& catcher, const std::string& path)
+{
+   if (path == "-")
+   {
+      this->stream = &std::cin;
+      return;
+   }
+
+   #ifdef RECORDS_MMAP
+   int descriptor = open(path.c_str(), O_RDONLY);
+   struct stat info;
+
+   if (descriptor >= 0 && fstat(descriptor, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+   {
+      void* pages = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+      if (pages != MAP_FAILED)
+      {
+         madvise(pages, info.st_size, MADV_SEQUENTIAL);
+         this->mapped = static_cast<const char*>(pages);
+         this->mapped_size = info.st_size;
+      }
+   }
+   if (descriptor >= 0)
+      close(descriptor);
+
+   if (this->mapped)
+      return;
+   #endif
+
+   this->file.open(path, std::ios::binary);
+
+   if (!this->file.is_open())
+      catcher.insert(err::cannot_open_file);
+   this->stream = &this->file;
+}
+
+RecordReader::~RecordReader()
+{
+   #ifdef RECORDS_MMAP
+   if (this->mapped)
+      munmap(const_cast<char*>(this->mapped), this->mapped_size);
+   #endif
+}
+
+bool RecordReader::line(std::string& line)
+{
+   if (this->mapped)
+   {
+      if (this->position >= this->mapped_size)
+         return false;
+
+      const char* start = this->mapped + this->position;
+      const char* newline = static_cast<const char*>(std::memchr(start, '\n', this->mapped_size - this->position));
+      size_t length = (newline ? newline - start : this->mapped_size - this->position);
+      line.assign(start, length);
+      this->position += length + 1;
+      return true;
+   }
+
+   if (!this->carry.empty())
+   {
+      auto newline = this->carry.find('\n');
+
+      if (newline != this->carry.npos)
+      {
+         line = this->carry.substr(0, newline);
+         this->carry.erase(0, newline + 1);
+         return true;
+      }
+   }
+
+   std::string rest;
+   bool read = static_cast<bool>(std::getline(*this->stream, rest));
+
+   if (!read && this->carry.empty())
+      return false;
+   line = std::move(this->carry) + rest;
+   this->carry.clear();
+   return true;
+}
+
+bool RecordReader::next(std::string& buffer, std::string_view& text)
+{
+   if (this->mapped)
+   {
+      if (this->position >= this->mapped_size)
+         return false;
+
+      size_t end = std::min(this->position + chunk_size, this->mapped_size);
+      if (end < this->mapped_size)
+      {
+         const char* newline = static_cast<const char*>(std::memchr(this->mapped + end - 1, '\n', this->mapped_size - end + 1));
+         end = (newline ? newline - this->mapped + 1 : this->mapped_size);
+      }
+
+      text = std::string_view(this->mapped + this->position, end - this->position);
+      this->position = end;
+      return true;
+   }
+
+   // Reads until the chunk is full and ends with a line, or the input ends. What comes
+   // after the last newline is carried over to the next chunk.
+   buffer = std::move(this->carry);
+   this->carry.clear();
+
+   while (this->stream->good())
+   {
+      size_t size = buffer.size();
+      buffer.resize(size + chunk_size);
+      this->stream->read(buffer.data() + size, chunk_size);
+      buffer.resize(size + this->stream->gcount());
+
+      auto newline = buffer.rfind('\n');
+      if (newline != buffer.npos)
+      {
+         this->carry.assign(buffer, newline + 1);
+         buffer.resize(newline + 1);
+         break;
+      }
+   }
+
+   text = buffer;
+   return !buffer.empty();
+}
+
+RecordStream::RecordStream(Catcher& catcher, const ColumnarProgram& program, RecordFormat format, size_t jobs)
+   : catcher(catcher), program(program), format(format), jobs(jobs)
+{
+   if (this->jobs == 0)
+      this->jobs = std::max(1u, std::thread::hardware_concurrency());
+}
+
+bool RecordStream::run(RecordReader& reader, std::FILE* output)
+{
+   if (this->format == RecordFormat::csv)
+   {
+      if (!read_header(reader))
+         return false;
+
+      std::string header;
+      for (const auto& binding : this->program.outputs())
+         header += (header.empty() ? "" : ",") + binding.name;
+      header += '\n';
+      std::fwrite(header.data(), 1, header.size(), output);
+   }
+
+   // Chunks are written in the order they were read. At most 'limit' of them are read
+   // but not written yet, so a slow chunk does not let the rest of the input pile up.
+   std::deque<std::unique_ptr<Chunk>> window;
+   std::deque<Chunk*> pending;
+   std::mutex mutex;
+   std::condition_variable work_ready;
+   std::condition_variable chunk_done;
+   bool stopping = false;
+   size_t limit = this->jobs * 4;
+   auto precision = real_precision;
+
+   auto work = [&]()
+   {
+      real_precision = precision;
+      std::unique_lock lock (mutex);
+
+      while (true)
+      {
+         work_ready.wait(lock, [&]() { return stopping || !pending.empty(); });
+
+         if (pending.empty())
+            return;
+
+         Chunk* chunk = pending.front();
+         pending.pop_front();
+         lock.unlock();
+         process(*chunk);
+         lock.lock();
+         chunk->done = true;
+         chunk_done.notify_one();
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (size_t i = 0; i < this->jobs; ++i)
+      workers.emplace_back(work);
+
+   const char* error = nullptr;
+   bool more = true;
+   std::unique_lock lock (mutex);
+
+   while (!error && (more || !window.empty()))
+   {
+      if (!window.empty() && window.front()->done)
+      {
+         auto chunk = std::move(window.front());
+         window.pop_front();
+         lock.unlock();
+
+         std::fwrite(chunk->output.data(), 1, chunk->output.size(), output);
+         this->records += chunk->records;
+         error = (chunk->error ? chunk->error : cancelled() ? err::job_cancelled : nullptr);
+
+         lock.lock();
+         continue;
+      }
+
+      if (more && window.size() < limit)
+      {
+         lock.unlock();
+         auto chunk = std::make_unique<Chunk>();
+         more = reader.next(chunk->buffer, chunk->text);
+         lock.lock();
+
+         if (more)
+         {
+            pending.push_back(chunk.get());
+            window.push_back(std::move(chunk));
+            work_ready.notify_one();
+         }
+         continue;
+      }
+
+      chunk_done.wait(lock, [&]() { return window.front()->done; });
+   }
+
+   // Chunks after a failed one are dropped, the ones being processed are waited for.
+   stopping = true;
+   pending.clear();
+   lock.unlock();
+   work_ready.notify_all();
+
+   for (auto& worker : workers)
+      worker.join();
+
+   std::fflush(output);
+
+   if (error)
+   {
+      this->catcher.error(error);
+      return false;
+   }
+   return true;
+}
+
+size_t RecordStream::record_count() const
+{
+   return this->records;
+}
+
+bool RecordStream::read_header(RecordReader& reader)
+{
+   std::string header;
+   const auto& inputs = this->program.inputs();
+   std::vector<char> found (inputs.size());
+
+   if (reader.line(header))
+   {
+      std::string_view rest = header;
+
+      while (true)
+      {
+         auto comma = rest.find(',');
+         auto name = trim(rest.substr(0, comma));
+
+         if (name.size() >= 2 && name.front() == '"' && name.back() == '"')
+            name = name.substr(1, name.size() - 2);
+
+         auto input = std::find_if(inputs.begin(), inputs.end(), [&](const auto& binding) { return binding.name == name; });
+         bool used = (input != inputs.end() && !found[input - inputs.begin()]);
+
+         this->fields.push_back(used ? input - inputs.begin() : -1);
+         if (used)
+            found[input - inputs.begin()] = true;
+
+         if (comma == rest.npos)
+            break;
+         rest.remove_prefix(comma + 1);
+      }
+   }
+
+   if (std::find(found.begin(), found.end(), false) != found.end())
+   {
+      this->catcher.error(err::missing_record_column);
+      return false;
+   }
+   return true;
+}
+
+void RecordStream::process(Chunk& chunk) const
+{
+   std::vector<std::string_view> lines;
+   std::string_view rest = chunk.text;
+
+   while (!rest.empty())
+   {
+      auto newline = rest.find('\n');
+      auto line = rest.substr(0, newline);
+
+      // Blank lines are not records.
+      if (!trim(line).empty())
+         lines.push_back(line);
+
+      rest.remove_prefix(newline == rest.npos ? rest.size() : newline + 1);
+   }
+
+   const auto& bindings = this->program.inputs();
+   std::vector<Column> inputs;
+   for (const auto& binding : bindings)
+      inputs.emplace_back(binding.type, lines.size());
+
+   // Records that do not parse are still evaluated with zeros, the parse error wins.
+   std::vector<const char*> invalid (lines.size(), nullptr);
+   std::vector<char> seen (bindings.size());
+
+   for (size_t i = 0; i < lines.size(); ++i)
+   {
+      std::fill(seen.begin(), seen.end(), false);
+      bool parsed = (this->format == RecordFormat::csv ? parse_csv(lines[i], inputs, i, seen) : parse_ndjson(lines[i], inputs, i, seen));
+
+      if (!parsed || std::find(seen.begin(), seen.end(), false) != seen.end())
+         invalid[i] = err::invalid_record;
+   }
+
+   std::vector<Column> outputs;
+   std::vector<const char*> errors;
+   this->program.run(lines.size(), inputs, outputs, errors);
+
+   chunk.output.reserve(lines.size() * (outputs.size() * 8 + 2));
+
+   for (size_t i = 0; i < lines.size(); ++i)
+   {
+      if (invalid[i] || errors[i])
+      {
+         chunk.error = (invalid[i] ? invalid[i] : errors[i]);
+         break;
+      }
+
+      format_record(chunk.output, outputs, i);
+      ++chunk.records;
+   }
+}
+
+bool RecordStream::parse_csv(std::string_view line, std::vector<Column>& columns, size_t record, std::vector<char>& seen) const
+{
+   size_t position = 0;
+
+   for (size_t field = 0; position <= line.size(); ++field)
+   {
+      std::string_view value;
+      std::string unquoted;
+      size_t start = position;
+
+      while (position < line.size() && (line[position] == ' ' || line[position] == '\t'))
+         ++position;
+
+      if (position < line.size() && line[position] == '"')
+      {
+         // A quoted field, '""' inside it is a quote.
+         for (++position; position < line.size(); ++position)
+         {
+            if (line[position] == '"' && position + 1 < line.size() && line[position + 1] == '"')
+               unquoted += line[position++];
+            else if (line[position] == '"')
+               break;
+            else
+               unquoted += line[position];
+         }
+
+         if (position++ >= line.size())
+            return false;
+
+         value = unquoted;
+         auto comma = line.find(',', position);
+         if (!trim(line.substr(position, comma - position)).empty())
+            return false;
+         position = (comma == line.npos ? line.size() : comma);
+      }
+      else
+      {
+         position = std::min(line.find(',', start), line.size());
+         value = trim(line.substr(start, position - start));
+      }
+      ++position;
+
+      if (field < this->fields.size() && this->fields[field] >= 0)
+      {
+         size_t input = this->fields[field];
+
+         if (!parse_value(value, columns[input], record))
+            return false;
+         seen[input] = true;
+      }
+   }
+   return true;
+}
+
+bool RecordStream::parse_ndjson(std::string_view line, std::vector<Column>& columns, size_t record, std::vector<char>& seen) const
+{
+   const auto& inputs = this->program.inputs();
+   size_t position = 0;
+
+   skip_spaces(line, position);
+   if (position >= line.size() || line[position++] != '{')
+      return false;
+
+   skip_spaces(line, position);
+   if (position < line.size() && line[position] == '}')
+      return trim(line.substr(position + 1)).empty();
+
+   while (true)
+   {
+      std::string_view key;
+
+      skip_spaces(line, position);
+      if (position >= line.size() || line[position] != '"' || !json_string(line, position, key))
+         return false;
+
+      skip_spaces(line, position);
+      if (position >= line.size() || line[position++] != ':')
+         return false;
+
+      skip_spaces(line, position);
+      auto input = std::find_if(inputs.begin(), inputs.end(), [&](const auto& binding) { return binding.name == key; });
+
+      if (input == inputs.end())
+      {
+         if (!json_skip(line, position))
+            return false;
+      }
+      else
+      {
+         size_t start = position;
+         while (position < line.size() && line[position] != ',' && line[position] != '}')
+            ++position;
+
+         size_t index = input - inputs.begin();
+         if (!parse_value(trim(line.substr(start, position - start)), columns[index], record))
+            return false;
+         seen[index] = true;
+      }
+
+      if (position >= line.size())
+         return false;
+      if (line[position++] == '}')
+         return trim(line.substr(position)).empty();
+   }
+}
+
+void RecordStream::format_record(std::string& output, const std::vector<Column>& outputs, size_t record) const
+{
+   bool json = (this->format == RecordFormat::ndjson);
+   const auto& bindings = this->program.outputs();
+
+   if (json)
+      output += '{';
+
+   for (size_t i = 0; i < outputs.size(); ++i)
+   {
+      if (i)
+         output += ',';
+
+      if (json)
+      {
+         output += '"';
+         output += bindings[i].name;
+         output += "\":";
+      }
+
+      const auto& column = outputs[i];
+      switch (column.type)
+      {
+      case VType::boolean:
+         output += (column.integers[record] ? "true" : "false");
+         break;
+      case VType::real:
+         // JSON has no infinities or NaNs.
+         if (json && !std::isfinite(column.reals[record]))
+            output += "null";
+         else
+            append_number(output, column.reals[record]);
+         break;
+      default:
+         append_number(output, column.integers[record]);
+         break;
+      }
+   }
+   output += (json ? "}\n" : "\n");
+}
@@ -0,0 +1,109 @@
+#include "io/watcher.hpp"
+#include "io/files.hpp"
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher()
+{
+   #if defined(__linux__)
+   this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+   #endif
+}
+
+FileWatcher::~FileWatcher()
+{
+   #if defined(__linux__)
+   if (this->fd >= 0)
+      close(this->fd);
+   #endif
+}
+
+bool FileWatcher::valid() const
+{
+   return this->fd >= 0;
+}
+
+void FileWatcher::watch(const std::unordered_set<std::string>& files)
+{
+   #if defined(__linux__)
+   if (!valid() || files == this->files)
+      return;
+
+   // Adding the watch of a directory that is already watched gives its descriptor back.
+   std::unordered_map<int, std::unordered_map<std::string, std::vector<std::string>>> directories;
+
+   for (const auto& file : files)
+   {
+      fs::path path (file);
+      auto directory = (path.has_parent_path() ? path.parent_path().string() : std::string("."));
+      int watch = inotify_add_watch(this->fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+      if (watch >= 0)
+         directories[watch][path.filename().string()].push_back(file);
+   }
+
+   for (const auto& [watch, names] : this->directories)
+   {
+      if (directories.find(watch) == directories.end())
+         inotify_rm_watch(this->fd, watch);
+   }
+
+   this->directories = std::move(directories);
+   this->files = files;
+   #else
+   (void)files;
+   #endif
+}
+
+std::vector<std::string> FileWatcher::wait(int stop)
+{
+   std::vector<std::string> saved;
+
+   #if defined(__linux__)
+   if (!valid())
+      return saved;
+
+   alignas(inotify_event) char buffer[4096];
+   std::unordered_set<std::string> seen;
+
+   while (saved.empty())
+   {
+      pollfd fds[] = {{this->fd, POLLIN, 0}, {stop, POLLIN, 0}};
+
+      if (poll(fds, 2, -1) < 0 || fds[1].revents)
+         return saved;
+
+      // Every event that is already there is read, a save often comes with more than one.
+      ssize_t size;
+      while ((size = read(this->fd, buffer, sizeof(buffer))) > 0)
+      {
+         for (char* at = buffer; at < buffer + size; )
+         {
+            auto event = reinterpret_cast<const inotify_event*>(at);
+            at += sizeof(inotify_event) + event->len;
+
+            auto directory = this->directories.find(event->wd);
+            if (directory == this->directories.end() || !event->len)
+               continue;
+
+            auto names = directory->second.find(event->name);
+            if (names == directory->second.end())
+               continue;
+
+            for (const auto& file : names->second)
+            {
+               if (seen.insert(file).second)
+                  saved.push_back(file);
+            }
+         }
+      }
+   }
+   #else
+   (void)stop;
+   #endif
+   return saved;
+}
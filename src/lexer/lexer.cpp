@@ -1,12 +1,18 @@
 #include "lexer/lexer.hpp"
 #include "errors/errors.hpp"
 #include "lexer/keywords.hpp"
+#include "config/cancellation.hpp"
 
 using namespace std::string_literals;
 
 Lexer::Lexer(Catcher& catcher, std::string& source)
    : catcher(catcher), source(source), size(source.size()) {}
 
+void Lexer::specify_line_sink(LineSink line_sink)
+{
+   this->line_sink = std::move(line_sink);
+}
+
 std::vector<Token>& Lexer::tokenize()
 {
    for (; this->index < this->size; ++this->index)
@@ -14,7 +20,18 @@ std::vector<Token>& Lexer::tokenize()
       char ch = this->source.at(this->index);
 
       if (ch == '\n')
+      {
          push_token(TType::newline, "\n"s);
+
+         if (this->line_sink)
+            this->line_sink(this->tokens);
+
+         if (cancelled())
+         {
+            this->catcher.insert(err::job_cancelled);
+            return tokens;
+         }
+      }
       else if (isspace(ch))
          continue;
       else if (ch == '/' && peek() == '/')
@@ -1,27 +1,49 @@
 #include "config/version.hpp"
 #include "errors/catcher.hpp"
 #include "errors/errors.hpp"
-#include "lexer/lexer.hpp"
-#include "parser/parser.hpp"
-#include "preprocessor/preprocessor.hpp"
+#include "script/session.hpp"
 #include "io/files.hpp"
 #include "io/args.hpp"
+#include "cli/run.hpp"
+#include "cli/watch.hpp"
+#include "cli/batch.hpp"
+#include "cli/fuzz.hpp"
+#include "cli/jobs.hpp"
+#include <algorithm>
+#include <memory>
+#include <string>
 #include <iostream>
 
-int main()
+int main(int argc, char** argv)
 {
+   if (argc > 1 && std::string(argv[1]) == "fuzz")
+      return run_fuzz(argc, argv);
+   if (argc > 1)
+      return run_batch(argc, argv);
+
    #if defined(__linux__) || defined(__APPLE__)
    std::cout << "\033[38;2;0;0;255mREPL for an interpreted scripting language.\033[0m\n";
    #else
    std::cout << "REPL for an interpreted scripting language.\n";
    #endif
    Catcher catcher;
+   std::vector<std::unique_ptr<Job>> jobs;
+   size_t next_job = 1;
+   Session session (catcher);
+   bool bench = false;
 
    while (true)
    {
+      reap_jobs(jobs);
       std::cout << "> ";
       std::string input;
-      std::getline(std::cin, input);
+
+      // Quit at the end of the input, '--records=-' reads it to the end.
+      if (!std::getline(std::cin, input))
+      {
+         stop_jobs(jobs);
+         return 0;
+      }
 
       Args args (catcher, input);
 
@@ -33,6 +55,8 @@ int main()
 
       if (args.size() == 1 && args.at(0) == "quit")
       {
+         stop_jobs(jobs);
+
          #if defined(__linux__) || defined(__APPLE__)
          std::cout << "\033[38;2;0;0;255mQuitting...\033[0m\n";
          #else
@@ -54,11 +78,16 @@ int main()
          std::cout << "\033[38;2;0;0;255m";
          #endif
 
-         std::cout << "help       - show help.\n";
-         std::cout << "quit       - quit the REPL.\n";
-         std::cout << "version    - show the version.\n";
-         std::cout << "run FILE.q - run a file.\n";
-         std::cout << "cat FILE.q - display the contents of a file.\n";
+         std::cout << "help         - show help.\n";
+         std::cout << "quit         - quit the REPL.\n";
+         std::cout << "version      - show the version.\n";
+         std::cout << "run FILE.q   - run a file.\n";
+         std::cout << "cat FILE.q   - display the contents of a file.\n";
+         std::cout << "run ... &    - run a file in the background.\n";
+         std::cout << "jobs         - list the jobs running in the background.\n";
+         std::cout << "cancel N     - cancel job N.\n";
+         std::cout << "watch FILE.q - run a file again every time it or a file it imports is saved.\n";
+         std::cout << "bench        - show the time every stage of a line of code takes, or stop.\n";
          std::cout << "\nOther input will be treated as code and executed.\n";
          std::cout << "For syntax and language features check out the README.md file.\n";
 
@@ -90,108 +119,65 @@ int main()
          std::cout << "\nFile '" << file_name << "':\n" << input << "\n";
          #endif
       }
-      else if (args.size() >= 2 && args.at(0) == "run")
+      else if (args.size() == 1 && args.at(0) == "bench")
       {
-         std::string file_name;
+         // '--bench' for the code typed at the prompt.
+         bench = !bench;
+      }
+      else if (args.size() == 1 && args.at(0) == "jobs")
+      {
+         reap_jobs(jobs);
 
-         if (is_file(args.at(1)))
-         {
-            file_name = args.at(1);
-            input = read_file(catcher, file_name);
+         for (const auto& job : jobs)
+            printf("[%zu] %-10s %s\n", job->id, job->cancel ? "Cancelling" : "Running", job->command.c_str());
+      }
+      else if (args.size() == 2 && args.at(0) == "cancel")
+      {
+         auto job = std::find_if(jobs.begin(), jobs.end(), [&](const auto& job) { return std::to_string(job->id) == args.at(1); });
 
-            if (catcher.display())
-               continue;
-         }
-         else
+         if (job == jobs.end() || (*job)->finished)
          {
-            catcher.error(err::invalid_run_command);
+            catcher.error(err::invalid_cancel_command);
             continue;
          }
+         (*job)->cancel = true;
+      }
+      else if (args.size() >= 2 && args.at(0) == "run")
+      {
+         // A trailing '&' runs the file on its own thread, the REPL goes on right away.
+         auto end = input.find_last_not_of(" \t");
 
-         Lexer lexer (catcher, input);
-         auto start_lex = std::chrono::high_resolution_clock::now();
-         auto& tokens = lexer.tokenize();
-         auto end_lex = std::chrono::high_resolution_clock::now();
-
-         if (catcher.display())
-            continue;
-
-         if (args.get_arg("--log-lexer"))
-         {
-            std::cout << "\nTokens after lexing:\n";
-            for (const auto& token : tokens)
-               printf("%-13s - \"%s\"\n", token_to_string(token.type), token.lexeme.c_str());
-         }
-
-         std::chrono::time_point<std::chrono::high_resolution_clock> start_pre, end_pre;
-         if (!args.get_arg("--skip-preprocessor"))
+         if (args.contains("&") && input[end] == '&')
          {
-            Preprocessor preprocessor (catcher, tokens, file_name, args.get_arg("--no-predefined-macros"));
-
-            if (args.contains("--macro-depth"))
-               preprocessor.specify_max_macro_depth(args.get_arg("--macro-depth"));
-
-            start_pre = std::chrono::high_resolution_clock::now();
-            preprocessor.process();
-            end_pre = std::chrono::high_resolution_clock::now();
-
-            if (catcher.display())
+            if (args.get_word("--records") == "-")
+            {
+               catcher.error(err::background_stdin);
                continue;
-         }
+            }
 
-         if (args.get_arg("--log-preprocessor"))
-         {
-            std::cout << "\nTokens after preprocessing:\n";
-            for (const auto& token : tokens)
-               printf("%-13s - \"%s\"\n", token_to_string(token.type), token.lexeme.c_str());
-         }
-
-         Parser parser (catcher, tokens);
-         auto start_par = std::chrono::high_resolution_clock::now();
-         auto& program = parser.parse();
-         auto end_par = std::chrono::high_resolution_clock::now();
-
-         if (catcher.display())
+            input.erase(input.find_last_not_of(" \t", end - 1) + 1);
+            start_job(jobs, next_job++, input);
             continue;
-
-         if (args.get_arg("--log-parser"))
-         {
-            std::cout << "\nAST tree after parsing:\n";
-            program.print();
          }
 
-         if (args.get_arg("--bench"))
-         {
-            auto lex = std::chrono::duration_cast<std::chrono::microseconds>(end_lex - start_lex).count();
-            auto pre = std::chrono::duration_cast<std::chrono::microseconds>(end_pre - start_pre).count();
-            auto par = std::chrono::duration_cast<std::chrono::microseconds>(end_par - start_par).count();
-
-            printf("Benchmark:\n");
-            printf("%-16s %ld μs\n", "Lexing time:", lex);
-            printf("%-16s %ld μs\n", "Processing time:", pre);
-            printf("%-16s %ld μs\n", "Parsing time:", par);
-            printf("%-16s %ld μs\n", "Total:", lex + pre + par);
-         }
+         run_file(catcher, args);
       }
+      else if (args.size() >= 2 && args.at(0) == "watch")
+         watch_file(catcher, args);
       else
       {
-         Lexer lexer (catcher, input);
-         auto& tokens = lexer.tokenize();
-
-         if (catcher.display())
+         if (!session.run(input) || !bench)
             continue;
 
-         Preprocessor preprocessor (catcher, tokens, "", false);
-         preprocessor.process();
-
-         if (catcher.display())
-            continue;
-         
-         Parser parser (catcher, tokens);
-         auto& program = parser.parse();
-
-         if (catcher.display())
-            continue;
+         const auto& times = session.times();
+         printf("Benchmark:\n");
+         printf("%-16s %.3f μs\n", "Lexing time:", times.lex / 1e3);
+         printf("%-16s %.3f μs\n", "Processing time:", times.preprocess / 1e3);
+         printf("%-16s %.3f μs\n", "Parsing time:", times.parse / 1e3);
+         printf("%-16s %.3f μs\n", "Resolving time:", times.resolve / 1e3);
+         printf("%-16s %.3f μs\n", "Checking time:", times.check / 1e3);
+         printf("%-16s %.3f μs (%zu variables)\n", "Evaluation time:", times.evaluate / 1e3, session.variable_count());
+         printf("%-16s %.3f μs\n", "Total:", times.total() / 1e3);
       }
    }
-}
\ No newline at end of file
+}
@@ -0,0 +1,185 @@
+#include "optimizer/constant_folder.hpp"
+#include "errors/errors.hpp"
+#include "runtime/operations.hpp"
+#include <string>
+
+ConstantFolder::ConstantFolder(Catcher& catcher, Program& program)
+   : catcher(catcher), program(program) {}
+
+size_t ConstantFolder::fold()
+{
+   for (auto& stmt : this->program.statements)
+      stmt = fold_stmt(stmt);
+   return this->removed;
+}
+
+Stmt ConstantFolder::fold_stmt(Stmt stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+   {
+      auto* s = static_cast<VarDeclaration*>(stmt);
+      s->body = fold_stmt(s->body);
+      return stmt;
+   }
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<AssignmentExpr*>(stmt);
+      s->right = fold_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::ternary:
+      return fold_ternary(static_cast<TernaryExpr*>(stmt));
+   case StmtType::binary:
+      return fold_binary(static_cast<BinaryExpr*>(stmt));
+   case StmtType::unary:
+      return fold_unary(static_cast<UnaryExpr*>(stmt));
+   default:
+      return stmt;
+   }
+}
+
+Stmt ConstantFolder::fold_ternary(TernaryExpr* expr)
+{
+   expr->expr = fold_stmt(expr->expr);
+
+   Value condition;
+   bool result = false;
+
+   // Only the branch a literal condition selects is sure to run.
+   if (!literal_value(expr->expr, condition) || truthy(condition, result))
+   {
+      expr->left = fold_guarded(expr->left);
+      expr->right = fold_guarded(expr->right);
+      return expr;
+   }
+   return replace(expr, result ? fold_stmt(expr->left) : fold_stmt(expr->right));
+}
+
+Stmt ConstantFolder::fold_binary(BinaryExpr* expr)
+{
+   expr->left = fold_stmt(expr->left);
+
+   Value a, b, result;
+   bool left_literal = literal_value(expr->left, a);
+
+   // The right side of '&&' and '||' only runs when a literal left side selects it.
+   if (expr->op == TType::logical_and || expr->op == TType::logical_or)
+   {
+      bool value = false;
+
+      if (left_literal && !truthy(a, value) && value == (expr->op == TType::logical_and))
+         expr->right = fold_stmt(expr->right);
+      else
+         expr->right = fold_guarded(expr->right);
+   }
+   else
+      expr->right = fold_stmt(expr->right);
+
+   if (!left_literal || !literal_value(expr->right, b))
+      return expr;
+   return fold(expr, binary_operation(expr->op, a, b, result), result);
+}
+
+Stmt ConstantFolder::fold_unary(UnaryExpr* expr)
+{
+   expr->value = fold_stmt(expr->value);
+
+   Value value, result;
+
+   if (!literal_value(expr->value, value))
+      return expr;
+   return fold(expr, unary_operation(expr->op, value, result), result);
+}
+
+// Errors in code that may not run are left for the runtime, it only reports them when
+// the code runs.
+Stmt ConstantFolder::fold_guarded(Stmt stmt)
+{
+   ++this->guarded;
+   stmt = fold_stmt(stmt);
+   --this->guarded;
+   return stmt;
+}
+
+Stmt ConstantFolder::fold(Stmt expr, const char* error, const Value& result)
+{
+   // Operators that are not defined for the operand types are left for the
+   // evaluator, everything else would fail the same way at run time. Like the run,
+   // only the first error is reported, so folding again never reports one twice.
+   if (error)
+   {
+      if (error != err::invalid_operands && !this->guarded && this->catcher.empty())
+         this->catcher.insert(error);
+      return expr;
+   }
+
+   auto value = make_literal(this->program.arena, result);
+
+   if (!value)
+      return expr;
+   return replace(expr, value);
+}
+
+Stmt ConstantFolder::replace(Stmt old, Stmt value)
+{
+   this->removed += count_nodes(old) - count_nodes(value);
+   return value;
+}
+
+size_t count_nodes(const Statement* stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+   {
+      auto* s = static_cast<const VarDeclaration*>(stmt);
+      return 1 + count_nodes(s->ttype) + count_nodes(s->body);
+   }
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<const AssignmentExpr*>(stmt);
+      return 1 + count_nodes(s->left) + count_nodes(s->right);
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<const TernaryExpr*>(stmt);
+      return 1 + count_nodes(s->expr) + count_nodes(s->left) + count_nodes(s->right);
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<const BinaryExpr*>(stmt);
+      return 1 + count_nodes(s->left) + count_nodes(s->right);
+   }
+   case StmtType::unary:
+      return 1 + count_nodes(static_cast<const UnaryExpr*>(stmt)->value);
+   default:
+      return 1;
+   }
+}
+
+bool literal_value(const Statement* stmt, Value& value)
+{
+   switch (stmt->type())
+   {
+   case StmtType::integer: value = static_cast<const IntegralLiteral*>(stmt)->number; return true;
+   case StmtType::real: value = static_cast<const RealLiteral*>(stmt)->number; return true;
+   case StmtType::character: value = static_cast<const CharLiteral*>(stmt)->ch; return true;
+   case StmtType::string: value = std::string(static_cast<const StringLiteral*>(stmt)->string); return true;
+   default: return false;
+   }
+}
+
+Stmt make_literal(Arena& arena, const Value& value)
+{
+   switch (type_of(value))
+   {
+   case VType::integer: return arena.make<IntegralLiteral>(std::get<long long>(value));
+   case VType::real: return arena.make<RealLiteral>(std::get<real_t>(value));
+   case VType::character: return arena.make<CharLiteral>(std::get<char>(value));
+   case VType::boolean: return arena.make<IntegralLiteral>(std::get<bool>(value));
+   case VType::string: return arena.make<StringLiteral>(arena.copy(std::get<std::string>(value)));
+   default: return nullptr;
+   }
+}
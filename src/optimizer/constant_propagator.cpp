@@ -0,0 +1,116 @@
+#include "optimizer/constant_propagator.hpp"
+
+ConstantPropagator::ConstantPropagator(Catcher& catcher, Program& program)
+   : program(program), folder(catcher, program) {}
+
+size_t ConstantPropagator::propagate()
+{
+   std::vector<Stmt> kept;
+   kept.reserve(this->program.statements.size());
+
+   for (auto stmt : this->program.statements)
+   {
+      auto before = this->rewritten;
+      stmt = propagate_stmt(stmt);
+
+      if (this->rewritten != before)
+         stmt = this->folder.fold_stmt(stmt);
+
+      if (stmt->type() == StmtType::var_decl)
+      {
+         auto* decl = static_cast<VarDeclaration*>(stmt);
+
+         if (auto value = constant(decl))
+         {
+            if (decl->slot >= this->constants.size())
+               this->constants.resize(decl->slot + 1, nullptr);
+            this->constants[decl->slot] = value;
+            ++this->removed;
+            continue;
+         }
+      }
+      kept.push_back(stmt);
+   }
+
+   this->program.statements = std::move(kept);
+   return this->rewritten;
+}
+
+size_t ConstantPropagator::removed_count() const
+{
+   return this->removed;
+}
+
+Stmt ConstantPropagator::propagate_stmt(Stmt stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+   {
+      auto* s = static_cast<VarDeclaration*>(stmt);
+      s->body = propagate_stmt(s->body);
+      return stmt;
+   }
+   case StmtType::assignment:
+   {
+      // The target is mutable, so it is never constant.
+      auto* s = static_cast<AssignmentExpr*>(stmt);
+      s->right = propagate_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<TernaryExpr*>(stmt);
+      s->expr = propagate_stmt(s->expr);
+      s->left = propagate_stmt(s->left);
+      s->right = propagate_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<BinaryExpr*>(stmt);
+      s->left = propagate_stmt(s->left);
+      s->right = propagate_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::unary:
+   {
+      auto* s = static_cast<UnaryExpr*>(stmt);
+      s->value = propagate_stmt(s->value);
+      return stmt;
+   }
+   case StmtType::identifier:
+   {
+      auto slot = static_cast<Identifier*>(stmt)->slot;
+
+      if (slot >= this->constants.size() || !this->constants[slot])
+         return stmt;
+
+      // Literals are never changed after parsing, so all uses can share one.
+      ++this->rewritten;
+      return this->constants[slot];
+   }
+   default:
+      return stmt;
+   }
+}
+
+Stmt ConstantPropagator::constant(const VarDeclaration* decl)
+{
+   const auto* type = static_cast<const TypeExpr*>(decl->ttype);
+   Value value;
+
+   if (type->mut || !literal_value(decl->body, value))
+      return nullptr;
+
+   // Bools have no literal, and a value that does not convert is an error that is left
+   // for the type checker or the run.
+   auto declared = (type->automatic ? type_of(value) : type_from_name(type->ttype));
+
+   if (declared == type_of(value))
+      return decl->body;
+
+   if (declared == VType::boolean || convert(value, declared))
+      return nullptr;
+   return make_literal(this->program.arena, value);
+}
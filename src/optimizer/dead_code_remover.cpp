@@ -0,0 +1,86 @@
+#include "optimizer/dead_code_remover.hpp"
+#include "optimizer/constant_folder.hpp"
+#include "runtime/value.hpp"
+
+DeadCodeRemover::DeadCodeRemover(Program& program)
+   : program(program) {}
+
+size_t DeadCodeRemover::remove()
+{
+   for (auto stmt : this->program.statements)
+      count_uses(stmt);
+
+   std::vector<Stmt> kept;
+   kept.reserve(this->program.statements.size());
+
+   for (auto stmt : this->program.statements)
+   {
+      if (stmt->type() != StmtType::var_decl || !removable(static_cast<VarDeclaration*>(stmt)))
+         kept.push_back(stmt);
+   }
+
+   size_t removed = this->program.statements.size() - kept.size();
+   this->program.statements = std::move(kept);
+   return removed;
+}
+
+void DeadCodeRemover::count_uses(const Statement* stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+      count_uses(static_cast<const VarDeclaration*>(stmt)->body);
+      break;
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<const AssignmentExpr*>(stmt);
+      count_uses(s->left);
+      count_uses(s->right);
+      break;
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<const TernaryExpr*>(stmt);
+      count_uses(s->expr);
+      count_uses(s->left);
+      count_uses(s->right);
+      break;
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<const BinaryExpr*>(stmt);
+      count_uses(s->left);
+      count_uses(s->right);
+      break;
+   }
+   case StmtType::unary:
+      count_uses(static_cast<const UnaryExpr*>(stmt)->value);
+      break;
+   case StmtType::identifier:
+   {
+      auto slot = static_cast<const Identifier*>(stmt)->slot;
+
+      if (slot >= this->uses.size())
+         this->uses.resize(slot + 1, 0);
+      ++this->uses[slot];
+      break;
+   }
+   default:
+      break;
+   }
+}
+
+bool DeadCodeRemover::removable(const VarDeclaration* decl) const
+{
+   if (decl->slot < this->uses.size() && this->uses[decl->slot])
+      return false;
+   if (decl->body->type() == StmtType::null)
+      return true;
+
+   const auto* type = static_cast<const TypeExpr*>(decl->ttype);
+   Value value;
+
+   if (!literal_value(decl->body, value))
+      return false;
+   return type->automatic || !convert(value, type_from_name(type->ttype));
+}
@@ -0,0 +1,144 @@
+#include "optimizer/pass_manager.hpp"
+#include "optimizer/constant_folder.hpp"
+#include "optimizer/constant_propagator.hpp"
+#include "optimizer/simplifier.hpp"
+#include "optimizer/dead_code_remover.hpp"
+#include "resolver/type_checker.hpp"
+#include <chrono>
+#include <iostream>
+
+static size_t fold(Catcher& catcher, Program& program)
+{
+   return ConstantFolder(catcher, program).fold();
+}
+
+static size_t propagate(Catcher& catcher, Program& program)
+{
+   return ConstantPropagator(catcher, program).propagate();
+}
+
+static size_t simplify(Catcher&, Program& program)
+{
+   return Simplifier(program).simplify();
+}
+
+static size_t remove_dead(Catcher&, Program& program)
+{
+   return DeadCodeRemover(program).remove();
+}
+
+PassManager::PassManager(Catcher& catcher, Program& program)
+   : catcher(catcher), program(program)
+{
+   this->passes = {
+      {"fold", 1, fold, true},
+      {"propagate", 1, propagate, true},
+      {"simplify", 2, simplify, false},
+      {"dead", 2, remove_dead, false},
+   };
+}
+
+void PassManager::define(std::uint32_t slot, VType type)
+{
+   if (slot >= this->defined.size())
+      this->defined.resize(slot + 1, VType::null);
+   this->defined[slot] = type;
+}
+
+void PassManager::specify_level(size_t level)
+{
+   for (auto& pass : this->passes)
+      pass.enabled = (pass.level <= level);
+}
+
+bool PassManager::enable(std::string_view name, bool enabled)
+{
+   auto* pass = find(name);
+
+   if (!pass)
+      return false;
+   pass->enabled = enabled;
+   return true;
+}
+
+bool PassManager::log_after(std::string_view name)
+{
+   auto* pass = find(name);
+
+   if (!pass)
+      return false;
+   pass->logged = true;
+   return true;
+}
+
+void PassManager::measure(bool measured)
+{
+   this->measured = measured;
+}
+
+bool PassManager::run()
+{
+   for (auto& pass : this->passes)
+   {
+      if (!pass.enabled)
+         continue;
+
+      Report report {pass.name, 0, 0, 0, 0};
+
+      if (this->measured)
+         report.before = count();
+
+      auto start = std::chrono::high_resolution_clock::now();
+      report.changes = pass.run(this->catcher, this->program);
+
+      // New literals have no static type yet and folding can change the type of an
+      // expression (bools become ints), so the types are checked again.
+      if (pass.retype && report.changes && this->catcher.empty())
+      {
+         TypeChecker checker (this->catcher, this->program);
+
+         for (std::uint32_t slot = 0; slot < this->defined.size(); ++slot)
+            checker.define(slot, this->defined[slot]);
+         checker.check();
+      }
+      auto end = std::chrono::high_resolution_clock::now();
+
+      report.time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+      report.after = (this->measured ? count() : 0);
+      this->ran.push_back(report);
+
+      if (!this->catcher.empty())
+         return false;
+
+      if (pass.logged)
+      {
+         std::cout << "\nAST tree after pass '" << pass.name << "':\n";
+         this->program.print();
+      }
+   }
+   return true;
+}
+
+const std::vector<PassManager::Report>& PassManager::reports() const
+{
+   return this->ran;
+}
+
+PassManager::Pass* PassManager::find(std::string_view name)
+{
+   for (auto& pass : this->passes)
+   {
+      if (pass.name == name)
+         return &pass;
+   }
+   return nullptr;
+}
+
+size_t PassManager::count() const
+{
+   size_t nodes = 0;
+
+   for (auto stmt : this->program.statements)
+      nodes += count_nodes(stmt);
+   return nodes;
+}
@@ -0,0 +1,144 @@
+#include "optimizer/simplifier.hpp"
+#include "optimizer/constant_folder.hpp"
+#include <cmath>
+
+// Whether the node is an int literal, or also a real literal with 'real', equal to
+// the number. A zero real literal must not be negative.
+static bool is_number(const Statement* stmt, long long number, bool real)
+{
+   if (stmt->type() == StmtType::integer)
+      return static_cast<const IntegralLiteral*>(stmt)->number == number;
+   if (stmt->type() != StmtType::real || !real)
+      return false;
+
+   auto value = static_cast<const RealLiteral*>(stmt)->number;
+   return value == number && !std::signbit(value);
+}
+
+Simplifier::Simplifier(Program& program)
+   : program(program) {}
+
+size_t Simplifier::simplify()
+{
+   for (auto& stmt : this->program.statements)
+      stmt = simplify_stmt(stmt);
+   return this->removed;
+}
+
+Stmt Simplifier::simplify_stmt(Stmt stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+   {
+      auto* s = static_cast<VarDeclaration*>(stmt);
+      s->body = simplify_stmt(s->body);
+      return stmt;
+   }
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<AssignmentExpr*>(stmt);
+      s->right = simplify_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<TernaryExpr*>(stmt);
+      s->expr = simplify_stmt(s->expr);
+      s->left = simplify_stmt(s->left);
+      s->right = simplify_stmt(s->right);
+      return stmt;
+   }
+   case StmtType::binary:
+      return simplify_binary(static_cast<BinaryExpr*>(stmt));
+   case StmtType::unary:
+      return simplify_unary(static_cast<UnaryExpr*>(stmt));
+   default:
+      return stmt;
+   }
+}
+
+Stmt Simplifier::simplify_binary(BinaryExpr* expr)
+{
+   expr->left = simplify_stmt(expr->left);
+   expr->right = simplify_stmt(expr->right);
+
+   auto type = expr->static_type;
+   bool real = (type == VType::real);
+
+   if (type != VType::integer && !real)
+      return expr;
+
+   // 'x + 0.0' is not here, it turns -0.0 into 0.0.
+   bool left = (expr->left->static_type == type);
+   bool right = (expr->right->static_type == type);
+
+   switch (expr->op)
+   {
+   case TType::star:
+      if (left && is_number(expr->right, 1, real))
+         return replace(expr, expr->left);
+      if (right && is_number(expr->left, 1, real))
+         return replace(expr, expr->right);
+      return expr;
+   case TType::slash:
+      return (left && is_number(expr->right, 1, real) ? replace(expr, expr->left) : expr);
+   case TType::minus:
+      return (left && is_number(expr->right, 0, real) ? replace(expr, expr->left) : expr);
+   case TType::plus:
+   case TType::bitwise_or:
+   case TType::bitwise_xor:
+      if (real)
+         return expr;
+      if (left && is_number(expr->right, 0, false))
+         return replace(expr, expr->left);
+      if (right && is_number(expr->left, 0, false))
+         return replace(expr, expr->right);
+      return expr;
+   case TType::bitwise_and:
+      if (real)
+         return expr;
+      if (left && is_number(expr->right, -1, false))
+         return replace(expr, expr->left);
+      if (right && is_number(expr->left, -1, false))
+         return replace(expr, expr->right);
+      return expr;
+   case TType::shift_left:
+   case TType::shift_right:
+      return (!real && left && is_number(expr->right, 0, false) ? replace(expr, expr->left) : expr);
+   default:
+      return expr;
+   }
+}
+
+Stmt Simplifier::simplify_unary(UnaryExpr* expr)
+{
+   expr->value = simplify_stmt(expr->value);
+
+   auto type = expr->static_type;
+   auto* value = expr->value;
+
+   if ((type != VType::integer && type != VType::real) || value->static_type != type)
+      return expr;
+
+   if (expr->op == TType::plus)
+      return replace(expr, value);
+
+   // '~~x' for ints and '--x' for reals, negating the lowest int is an error.
+   if (value->type() != StmtType::unary || static_cast<UnaryExpr*>(value)->op != expr->op)
+      return expr;
+
+   auto* inner = static_cast<UnaryExpr*>(value)->value;
+
+   if (inner->static_type != type)
+      return expr;
+   if ((expr->op == TType::bitwise_not && type == VType::integer) || (expr->op == TType::minus && type == VType::real))
+      return replace(expr, inner);
+   return expr;
+}
+
+Stmt Simplifier::replace(Stmt old, Stmt value)
+{
+   this->removed += count_nodes(old) - count_nodes(value);
+   return value;
+}
@@ -0,0 +1,84 @@
+#include "parser/arena.hpp"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+
+Arena::Arena(Arena&& other) noexcept
+{
+   *this = std::move(other);
+}
+
+Arena& Arena::operator=(Arena&& other) noexcept
+{
+   this->blocks = std::move(other.blocks);
+   this->cursor = std::exchange(other.cursor, nullptr);
+   this->end = std::exchange(other.end, nullptr);
+   this->next_block_size = std::exchange(other.next_block_size, 4096);
+   return *this;
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+   auto address = reinterpret_cast<std::uintptr_t>(this->cursor);
+   size_t padding = (alignment - address % alignment) % alignment;
+
+   if (!this->cursor || padding + size > static_cast<size_t>(this->end - this->cursor))
+   {
+      size_t block_size = std::max(this->next_block_size, size + alignment);
+      this->blocks.emplace_back(new char[block_size]);
+
+      this->cursor = this->blocks.back().get();
+      this->end = this->cursor + block_size;
+      this->next_block_size = std::min(this->next_block_size * 2, max_block_size);
+
+      address = reinterpret_cast<std::uintptr_t>(this->cursor);
+      padding = (alignment - address % alignment) % alignment;
+   }
+
+   char* result = this->cursor + padding;
+   this->cursor = result + size;
+   return result;
+}
+
+std::string_view Arena::copy(const std::string& string)
+{
+   if (string.empty())
+      return {};
+
+   char* data = static_cast<char*>(allocate(string.size(), 1));
+   std::memcpy(data, string.data(), string.size());
+   return {data, string.size()};
+}
+
+size_t Arena::block_count() const
+{
+   return this->blocks.size();
+}
+
+void Arena::reset()
+{
+   if (this->blocks.empty())
+      return;
+
+   // Only the block in use, the last one, is kept.
+   auto last = std::move(this->blocks.back());
+   size_t size = this->end - last.get();
+
+   this->blocks.clear();
+   this->cursor = last.get();
+   this->end = this->cursor + size;
+   this->blocks.push_back(std::move(last));
+}
+
+void* Arena::do_allocate(size_t size, size_t alignment)
+{
+   return allocate(size, alignment);
+}
+
+void Arena::do_deallocate(void*, size_t, size_t) {}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+   return this == &other;
+}
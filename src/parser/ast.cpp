@@ -1,8 +1,8 @@
 #include "parser/ast.hpp"
 #include <iostream>
 
-VarDeclaration::VarDeclaration(Stmt& ttype, const std::string& identifier, Stmt& body)
-   : ttype(std::move(ttype)), identifier(identifier), body(std::move(body)) {}
+VarDeclaration::VarDeclaration(Stmt ttype, std::string_view identifier, Stmt body)
+   : ttype(ttype), identifier(identifier), body(body) {}
 
 StmtType VarDeclaration::type() const
 {
@@ -17,7 +17,7 @@ void VarDeclaration::print(size_t indentation) const
    this->body->print(indentation + 2);
 }
 
-TypeExpr::TypeExpr(bool con, bool mut, bool automatic, const std::string& ttype)
+TypeExpr::TypeExpr(bool con, bool mut, bool automatic, std::string_view ttype)
    : con(con), mut(mut), automatic(automatic), ttype(ttype) {}
 
 StmtType TypeExpr::type() const
@@ -31,8 +31,8 @@ void TypeExpr::print(size_t indentation) const
    std::cout << (this->con ? "con " : "") << (this->automatic ? "var" : this->ttype) << "\n";
 }
 
-AssignmentExpr::AssignmentExpr(TType op, Stmt& left, Stmt& right)
-   : op(op), left(std::move(left)), right(std::move(right)) {}
+AssignmentExpr::AssignmentExpr(TType op, Stmt left, Stmt right)
+   : op(op), left(left), right(right) {}
 
 StmtType AssignmentExpr::type() const
 {
@@ -47,8 +47,8 @@ void AssignmentExpr::print(size_t indentation) const
    this->right->print(indentation + 2);
 }
 
-TernaryExpr::TernaryExpr(Stmt& expr, Stmt& left, Stmt& right)
-   : expr(std::move(expr)), left(std::move(left)), right(std::move(right)) {}
+TernaryExpr::TernaryExpr(Stmt expr, Stmt left, Stmt right)
+   : expr(expr), left(left), right(right) {}
 
 StmtType TernaryExpr::type() const
 {
@@ -65,8 +65,8 @@ void TernaryExpr::print(size_t indentation) const
    this->right->print(indentation + 2);
 }
 
-BinaryExpr::BinaryExpr(TType op, Stmt& left, Stmt& right)
-   : op(op), left(std::move(left)), right(std::move(right)) {}
+BinaryExpr::BinaryExpr(TType op, Stmt left, Stmt right)
+   : op(op), left(left), right(right) {}
 
 StmtType BinaryExpr::type() const
 {
@@ -81,8 +81,8 @@ void BinaryExpr::print(size_t indentation) const
    this->right->print(indentation + 2);
 }
 
-UnaryExpr::UnaryExpr(TType op, Stmt& value)
-   : op(op), value(std::move(value)) {}
+UnaryExpr::UnaryExpr(TType op, Stmt value)
+   : op(op), value(value) {}
 
 StmtType UnaryExpr::type() const
 {
@@ -106,7 +106,7 @@ void NullLiteral::print(size_t indentation) const
    std::cout << std::string(indentation, ' ') << "Null\n";
 }
 
-Identifier::Identifier(const std::string& identifier)
+Identifier::Identifier(std::string_view identifier)
    : identifier(identifier) {}
 
 StmtType Identifier::type() const
@@ -119,7 +119,7 @@ void Identifier::print(size_t indentation) const
    std::cout << std::string(indentation, ' ') << "[" << identifier << "]\n";
 }
 
-RealLiteral::RealLiteral(long double number)
+RealLiteral::RealLiteral(real_t number)
    : number(number) {}
 
 StmtType RealLiteral::type() const
@@ -145,7 +145,7 @@ void IntegralLiteral::print(size_t indentation) const
    std::cout << std::string(indentation + 1, ' ') << this->number << "\n";
 }
 
-StringLiteral::StringLiteral(const std::string& string)
+StringLiteral::StringLiteral(std::string_view string)
    : string(string) {}
 
 StmtType StringLiteral::type() const
@@ -171,6 +171,18 @@ void CharLiteral::print(size_t indentation) const
    std::cout << std::string(indentation, ' ') << "'" << this->ch << "'\n";
 }
 
+void Program::merge(Program& other)
+{
+   this->statements.insert(this->statements.end(), other.statements.begin(), other.statements.end());
+   this->adopted.push_back(std::move(other.arena));
+
+   for (auto& arena : other.adopted)
+      this->adopted.push_back(std::move(arena));
+
+   other.statements.clear();
+   other.adopted.clear();
+}
+
 void Program::print() const
 {
    for (const auto& stmt : this->statements)
@@ -0,0 +1,177 @@
+#include "parser/flat_ast.hpp"
+#include <iostream>
+
+static std::uint32_t push_text(FlatProgram& flat, StmtType tag, std::string_view string, VType type, std::uint8_t flags = 0, std::uint32_t first = 0)
+{
+   FlatNode node {tag, TType::eof, flags, type, first, {}};
+   node.text = {static_cast<std::uint32_t>(flat.strings.size()), static_cast<std::uint32_t>(string.size())};
+   flat.strings.append(string);
+   flat.nodes.push_back(node);
+   return static_cast<std::uint32_t>(flat.nodes.size() - 1);
+}
+
+static std::uint32_t flatten_stmt(FlatProgram& flat, const Statement* stmt)
+{
+   FlatNode node {stmt->type(), TType::eof, 0, stmt->static_type, 0, {}};
+
+   switch (node.tag)
+   {
+   case StmtType::var_decl:
+   {
+      auto* s = static_cast<const VarDeclaration*>(stmt);
+      node.first = flatten_stmt(flat, s->ttype);
+      node.children.second = flatten_stmt(flat, s->body);
+      node.children.third = push_text(flat, StmtType::identifier, s->identifier, s->static_type, 0, s->slot);
+      break;
+   }
+   case StmtType::type:
+   {
+      auto* s = static_cast<const TypeExpr*>(stmt);
+      auto index = push_text(flat, StmtType::type, s->ttype, s->static_type);
+      flat.nodes[index].flags = (s->con ? flag::con : 0) | (s->mut ? flag::mut : 0) | (s->automatic ? flag::automatic : 0);
+      return index;
+   }
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<const AssignmentExpr*>(stmt);
+      node.op = s->op;
+      node.first = flatten_stmt(flat, s->left);
+      node.children.second = flatten_stmt(flat, s->right);
+      break;
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<const TernaryExpr*>(stmt);
+      node.first = flatten_stmt(flat, s->expr);
+      node.children.second = flatten_stmt(flat, s->left);
+      node.children.third = flatten_stmt(flat, s->right);
+      break;
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<const BinaryExpr*>(stmt);
+      node.op = s->op;
+      node.first = flatten_stmt(flat, s->left);
+      node.children.second = flatten_stmt(flat, s->right);
+      break;
+   }
+   case StmtType::unary:
+   {
+      auto* s = static_cast<const UnaryExpr*>(stmt);
+      node.op = s->op;
+      node.first = flatten_stmt(flat, s->value);
+      break;
+   }
+   case StmtType::null:
+      break;
+   case StmtType::identifier:
+   {
+      auto* s = static_cast<const Identifier*>(stmt);
+      return push_text(flat, StmtType::identifier, s->identifier, s->static_type, static_cast<std::uint8_t>(s->scope), s->slot);
+   }
+   case StmtType::real:
+      node.first = static_cast<std::uint32_t>(flat.reals.size());
+      flat.reals.push_back(static_cast<const RealLiteral*>(stmt)->number);
+      break;
+   case StmtType::integer:
+      node.integer = static_cast<const IntegralLiteral*>(stmt)->number;
+      break;
+   case StmtType::string:
+      return push_text(flat, StmtType::string, static_cast<const StringLiteral*>(stmt)->string, stmt->static_type);
+   case StmtType::character:
+      node.ch = static_cast<const CharLiteral*>(stmt)->ch;
+      break;
+   }
+
+   flat.nodes.push_back(node);
+   return static_cast<std::uint32_t>(flat.nodes.size() - 1);
+}
+
+FlatProgram flatten(const Program& program)
+{
+   FlatProgram flat;
+   flat.statements.reserve(program.statements.size());
+
+   for (const auto& stmt : program.statements)
+      flat.statements.push_back(flatten_stmt(flat, stmt));
+   return flat;
+}
+
+FlatView FlatProgram::view() const
+{
+   return {this->nodes, this->statements, this->reals, this->strings};
+}
+
+void FlatProgram::print() const
+{
+   view().print();
+}
+
+std::string_view FlatView::text(const FlatNode& node) const
+{
+   return this->strings.substr(node.text.offset, node.text.length);
+}
+
+void FlatView::print() const
+{
+   for (auto index : this->statements)
+      print(index, 0);
+}
+
+void FlatView::print(std::uint32_t index, size_t indentation) const
+{
+   const auto& node = this->nodes[index];
+   const std::string indent (indentation, ' ');
+
+   switch (node.tag)
+   {
+   case StmtType::var_decl:
+      std::cout << indent << "Variable Declaration:\n";
+      print(node.first, indentation + 2);
+      std::cout << indent << "Identifier: [" << text(this->nodes[node.children.third]) << "]\n";
+      print(node.children.second, indentation + 2);
+      break;
+   case StmtType::type:
+      std::cout << indent << ' ' << (node.flags & flag::mut ? "mut " : "") << (node.flags & flag::con ? "con " : "");
+      std::cout << (node.flags & flag::automatic ? "var" : text(node)) << "\n";
+      break;
+   case StmtType::assignment:
+   case StmtType::binary:
+      std::cout << indent << (node.tag == StmtType::binary ? "Binary" : "Assignment") << " Expression:\n";
+      print(node.first, indentation + 2);
+      std::cout << indent << "Operator: " << token_to_string(node.op) << "\n";
+      print(node.children.second, indentation + 2);
+      break;
+   case StmtType::ternary:
+      std::cout << indent << "Ternary Expression:\n";
+      print(node.first, indentation + 2);
+      std::cout << indent << "Operator: question\n";
+      print(node.children.second, indentation + 2);
+      std::cout << indent << "Operator: colon\n";
+      print(node.children.third, indentation + 2);
+      break;
+   case StmtType::unary:
+      std::cout << indent << "Unary Expression:\n";
+      std::cout << indent << "Operator: " << token_to_string(node.op) << "\n";
+      print(node.first, indentation + 2);
+      break;
+   case StmtType::null:
+      std::cout << indent << "Null\n";
+      break;
+   case StmtType::identifier:
+      std::cout << indent << "[" << text(node) << "]\n";
+      break;
+   case StmtType::real:
+      std::cout << indent << ' ' << this->reals[node.first] << "\n";
+      break;
+   case StmtType::integer:
+      std::cout << indent << ' ' << node.integer << "\n";
+      break;
+   case StmtType::string:
+      std::cout << indent << "\"" << text(node) << "\"\n";
+      break;
+   case StmtType::character:
+      std::cout << indent << "'" << node.ch << "'\n";
+      break;
+   }
+}
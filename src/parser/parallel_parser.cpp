@@ -0,0 +1,95 @@
+#include "parser/parallel_parser.hpp"
+#include "parser/parser.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+ParallelParser::ParallelParser(Catcher& catcher, std::vector<Token>& tokens, size_t jobs)
+   : catcher(catcher), tokens(tokens), jobs(jobs)
+{
+   if (this->jobs == 0)
+      this->jobs = std::max(1u, std::thread::hardware_concurrency());
+}
+
+Program& ParallelParser::parse()
+{
+   auto bounds = find_chunks();
+   size_t chunk_count = bounds.size() - 1;
+
+   std::vector<Program> programs (chunk_count);
+   std::vector<Catcher> catchers (chunk_count);
+   std::atomic<size_t> next = 0;
+   std::atomic<size_t> first_error = chunk_count;
+   auto precision = real_precision;
+   auto cancel = cancel_flag;
+
+   auto work = [&]()
+   {
+      real_precision = precision;
+      cancel_flag = cancel;
+
+      for (size_t chunk = next++; chunk < chunk_count; chunk = next++)
+      {
+         // Chunks after a failed one are never reported, so they are not parsed either.
+         if (chunk > first_error.load(std::memory_order_relaxed))
+            continue;
+
+         Parser parser (catchers.at(chunk), this->tokens);
+         programs.at(chunk).merge(parser.parse_range(bounds.at(chunk), bounds.at(chunk + 1)));
+
+         if (!catchers.at(chunk).empty())
+         {
+            size_t current = first_error.load();
+            while (chunk < current && !first_error.compare_exchange_weak(current, chunk))
+               ;
+         }
+      }
+   };
+
+   std::vector<std::thread> workers;
+   for (size_t i = 1; i < std::min(this->jobs, chunk_count); ++i)
+      workers.emplace_back(work);
+
+   work();
+   for (auto& worker : workers)
+      worker.join();
+
+   for (size_t chunk = 0; chunk < chunk_count; ++chunk)
+   {
+      this->program.merge(programs.at(chunk));
+
+      if (!catchers.at(chunk).empty())
+      {
+         this->catcher.merge(catchers.at(chunk));
+         break;
+      }
+   }
+   return this->program;
+}
+
+std::vector<size_t> ParallelParser::find_chunks() const
+{
+   // A statement ends with a ';' outside of parentheses. A ';' directly after it
+   // belongs to the same statement, as in 'int a = int b = 1;;'.
+   size_t chunk_count = this->jobs * chunks_per_job;
+   size_t target = this->tokens.size() / chunk_count + 1;
+   size_t depth = 0;
+
+   std::vector<size_t> bounds {0};
+
+   for (size_t i = 0; i + 1 < this->tokens.size(); ++i)
+   {
+      TType type = this->tokens[i].type;
+
+      if (type == TType::l_paren)
+         ++depth;
+      else if (type == TType::r_paren && depth > 0)
+         --depth;
+      else if (type == TType::semicolon && depth == 0 && this->tokens[i + 1].type != TType::semicolon && i + 1 - bounds.back() >= target)
+         bounds.push_back(i + 1);
+   }
+   bounds.push_back(this->tokens.size());
+   return bounds;
+}
@@ -1,5 +1,7 @@
 #include "parser/parser.hpp"
 #include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
 
 using namespace std::string_literals;
 
@@ -10,7 +12,10 @@ Program& Parser::parse()
 {
    while (!is(TType::eof))
    {
-      this->program.statements.push_back(std::move(parse_stmt()));
+      if (cancelled())
+         this->catcher.insert(err::job_cancelled);
+      else
+         this->program.statements.push_back(parse_stmt());
 
       if (!catcher.empty())
          return this->program;
@@ -18,6 +23,28 @@ Program& Parser::parse()
    return this->program;
 }
 
+Program& Parser::parse_range(size_t begin, size_t end)
+{
+   this->index = begin;
+
+   while (this->index < end && !is(TType::eof))
+   {
+      if (cancelled())
+         this->catcher.insert(err::job_cancelled);
+      else
+         this->program.statements.push_back(parse_stmt());
+
+      if (!catcher.empty())
+         return this->program;
+   }
+   return this->program;
+}
+
+void Parser::refill()
+{
+   this->index = 0;
+}
+
 Stmt Parser::parse_stmt()
 {
    return parse_var_declaration();
@@ -42,7 +69,7 @@ Stmt Parser::parse_var_declaration()
    {
       advance();
 
-      auto* t = static_cast<TypeExpr*>(ttype.get());
+      auto* t = static_cast<TypeExpr*>(ttype);
 
       if (!t->mut)
       {
@@ -56,14 +83,14 @@ Stmt Parser::parse_var_declaration()
          return ttype;
       }
 
-      auto* i = static_cast<Identifier*>(ident.get());
-      Stmt body = std::make_unique<NullLiteral>();
-      return std::make_unique<VarDeclaration>(ttype, i->identifier, body);
+      auto* i = static_cast<Identifier*>(ident);
+      Stmt body = this->program.arena.make<NullLiteral>();
+      return this->program.arena.make<VarDeclaration>(ttype, i->identifier, body);
    }
    else if (is(TType::equals))
    {
       advance();
-      auto* i = static_cast<Identifier*>(ident.get());
+      auto* i = static_cast<Identifier*>(ident);
       auto body = parse_var_declaration();
 
       if (!is(TType::semicolon))
@@ -72,7 +99,7 @@ Stmt Parser::parse_var_declaration()
          return ttype;
       }
       advance();
-      return std::make_unique<VarDeclaration>(ttype, i->identifier, body);
+      return this->program.arena.make<VarDeclaration>(ttype, i->identifier, body);
    }
    else
    {
@@ -83,13 +110,13 @@ Stmt Parser::parse_var_declaration()
 
 Stmt Parser::parse_type()
 {
-   if (current().lexeme != "mut"s && current().lexeme != "con"s && current().lexeme != "let"s && !is_type())
-      return parse_compound_bitwise_expr();
+   if (!is_declaration(current()))
+      return parse_expr();
    
    bool con = false;
    bool mut = false;
    bool automatic = false;
-   std::string ttype = "";
+   std::string_view ttype;
 
    if (current().lexeme == "mut"s)
    {
@@ -108,304 +135,118 @@ Stmt Parser::parse_type()
    }
    else if (is_type())
    {
-      ttype = current().lexeme;
+      ttype = this->program.arena.copy(current().lexeme);
    }
    else
    {
       this->catcher.insert(err::expected_type);
    }
    advance();
-   return std::make_unique<TypeExpr>(con, mut, automatic, std::move(ttype));
-}
-
-Stmt Parser::parse_compound_bitwise_expr()
-{
-   auto left = parse_compound_shift_expr();
-
-   while (is(TType::bitwise_and_equals) || is(TType::bitwise_xor_equals) || is(TType::bitwise_or_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_compound_shift_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_compound_shift_expr()
-{
-   auto left = parse_compound_additive_expr();
-
-   while (is(TType::shift_left_equals) || is(TType::shift_right_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_compound_additive_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_compound_additive_expr()
-{
-   auto left = parse_compound_multiplicative_expr();
-
-   while (is(TType::plus_equals) || is(TType::minus_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_compound_multiplicative_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_compound_multiplicative_expr()
-{
-   auto left = parse_compound_exponentiation_expr();
-
-   while (is(TType::star_equals) || is(TType::slash_equals) || is(TType::percent_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_compound_exponentiation_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
-   }
-   return left;
+   return this->program.arena.make<TypeExpr>(con, mut, automatic, ttype);
 }
 
-Stmt Parser::parse_compound_exponentiation_expr()
+Stmt Parser::parse_expr()
 {
-   auto left = parse_assignment_expr();
+   const size_t base = this->frames.size();
+   int min_precedence = 1;
 
-   while (is(TType::star_star_equals))
+   while (true)
    {
-      TType op = current().type;
-      advance();
+      auto operand = parse_unary_expr(min_precedence);
 
-      auto right = parse_assignment_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_assignment_expr()
-{
-   auto left = parse_ternary_expr();
+      if (!operand)
+         continue;
 
-   while (is(TType::equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_ternary_expr();
-      left = std::make_unique<AssignmentExpr>(op, left, right);
+      while (true)
+      {
+         TType op = current().type;
+         int precedence = get_operator_precedence(op);
+
+         if (precedence && precedence >= min_precedence)
+         {
+            advance();
+            FType type = (op == TType::question ? FType::ternary_middle : FType::binary);
+            this->frames.push_back({type, op, min_precedence, operand, nullptr});
+
+            if (op == TType::question)
+               min_precedence = 1;
+            else
+               min_precedence = (op == TType::star_star ? precedence : precedence + 1);
+            break;
+         }
+
+         if (this->frames.size() == base)
+            return operand;
+
+         if (reduce_frame(operand, min_precedence))
+            break;
+      }
    }
-   return left;
 }
 
-Stmt Parser::parse_ternary_expr()
+bool Parser::reduce_frame(Stmt& operand, int& min_precedence)
 {
-   auto boolean_expr = parse_logical_or_expr();
-
-   if (is(TType::question))
-   {
-      advance();
-      auto left = parse_compound_bitwise_expr();
-
+   auto frame = this->frames.back();
+   this->frames.pop_back();
+   min_precedence = frame.min_precedence;
+
+   switch (frame.type)
+   {
+   case FType::binary:
+      if (get_operator_precedence(frame.op) <= 6)
+         operand = this->program.arena.make<AssignmentExpr>(frame.op, frame.left, operand);
+      else
+         operand = this->program.arena.make<BinaryExpr>(frame.op, frame.left, operand);
+      return false;
+   case FType::ternary_middle:
       if (!is(TType::colon))
       {
          this->catcher.insert(err::expected_colon_ternary);
-         return boolean_expr;
+         operand = frame.left;
+         return false;
       }
       advance();
-
-      auto right = parse_compound_bitwise_expr();
-      boolean_expr = std::make_unique<TernaryExpr>(boolean_expr, left, right);
-   }
-   return boolean_expr;
-}
-
-Stmt Parser::parse_logical_or_expr()
-{
-   auto left = parse_logical_and_expr();
-
-   while (is(TType::logical_or))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_logical_and_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_logical_and_expr()
-{
-   auto left = parse_bitwise_or_expr();
-
-   while (is(TType::logical_and))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_bitwise_or_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_bitwise_or_expr()
-{
-   auto left = parse_bitwise_xor_expr();
-
-   while (is(TType::bitwise_or))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_bitwise_xor_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_bitwise_xor_expr()
-{
-   auto left = parse_bitwise_and_expr();
-
-   while (is(TType::bitwise_xor))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_bitwise_and_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_bitwise_and_expr()
-{
-   auto left = parse_equality_expr();
-
-   while (is(TType::bitwise_and))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_equality_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_equality_expr()
-{
-   auto left = parse_relational_expr();
-
-   while (is(TType::equals_equals) || is(TType::not_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_relational_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_relational_expr()
-{
-   auto left = parse_shift_expr();
-
-   while (is(TType::smaller) || is(TType::smaller_equals) || is(TType::bigger) || is(TType::bigger_equals))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_shift_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_shift_expr()
-{
-   auto left = parse_additive_expr();
-
-   while (is(TType::shift_left) || is(TType::shift_right))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_additive_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_additive_expr()
-{
-   auto left = parse_multiplicative_expr();
-
-   while (is(TType::plus) || is(TType::minus))
-   {
-      TType op = current().type;
-      advance();
-
-      auto right = parse_multiplicative_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
-   }
-   return left;
-}
-
-Stmt Parser::parse_multiplicative_expr()
-{
-   auto left = parse_exponentiation_expr();
-
-   while (is(TType::star) || is(TType::slash) || is(TType::percent))
-   {
-      TType op = current().type;
+      this->frames.push_back({FType::ternary_right, frame.op, min_precedence, frame.left, operand});
+      min_precedence = 1;
+      return true;
+   case FType::ternary_right:
+      operand = this->program.arena.make<TernaryExpr>(frame.left, frame.middle, operand);
+      return false;
+   case FType::unary:
+      operand = this->program.arena.make<UnaryExpr>(frame.op, operand);
+      return false;
+   case FType::group:
+      if (!is(TType::r_paren))
+         this->catcher.insert(err::mismatched_parentheses);
       advance();
-
-      auto right = parse_exponentiation_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
+      return false;
    }
-   return left;
+   return false;
 }
 
-Stmt Parser::parse_exponentiation_expr()
+Stmt Parser::parse_unary_expr(int& min_precedence)
 {
-   auto left = parse_unary_expr();
-
-   while (is(TType::star_star))
+   if (is(TType::minus) || is(TType::plus) || is(TType::logical_not) || is(TType::bitwise_not) || is(TType::bitwise_and) || is(TType::star) || is(TType::plus_plus) || is(TType::minus_minus))
    {
       TType op = current().type;
       advance();
 
-      auto right = parse_exponentiation_expr();
-      left = std::make_unique<BinaryExpr>(op, left, right);
+      if (!is_group())
+      {
+         auto expr = parse_primary_expr();
+         return this->program.arena.make<UnaryExpr>(op, expr);
+      }
+      this->frames.push_back({FType::unary, op, min_precedence, nullptr, nullptr});
+      min_precedence = max_precedence + 1;
    }
-   return left;
-}
 
-Stmt Parser::parse_unary_expr()
-{
-   if (is(TType::minus) || is(TType::plus) || is(TType::logical_not) || is(TType::bitwise_not) || is(TType::bitwise_and) || is(TType::star) || is(TType::plus_plus) || is(TType::minus_minus))
-   {
-      TType op = tokens.at(index).type;
-      advance();
+   if (!is_group())
+      return parse_primary_expr();
 
-      auto expr = parse_primary_expr();
-      return std::make_unique<UnaryExpr>(op, expr);
-   }
-   return parse_primary_expr();
+   advance();
+   this->frames.push_back({FType::group, TType::l_paren, min_precedence, nullptr, nullptr});
+   min_precedence = 1;
+   return nullptr;
 }
 
 Stmt Parser::parse_increment_suffix()
@@ -416,7 +257,7 @@ Stmt Parser::parse_increment_suffix()
    {
       TType op = tokens.at(index).type;
       advance();
-      value = std::make_unique<UnaryExpr>(static_cast<TType>((int)op + 1), value);
+      value = this->program.arena.make<UnaryExpr>(static_cast<TType>((int)op + 1), value);
    }
    return value;
 }
@@ -425,9 +266,9 @@ Stmt Parser::parse_primary_expr()
 {
    if (is(TType::identifier))
    {
-      std::string identifier = current().lexeme;
+      auto identifier = this->program.arena.copy(current().lexeme);
       advance();
-      return std::make_unique<Identifier>(identifier);
+      return this->program.arena.make<Identifier>(identifier);
    }
    else if (is(TType::integer))
    {
@@ -439,31 +280,31 @@ Stmt Parser::parse_primary_expr()
       { this->catcher.insert(err::could_not_convert_number); }
 
       advance();
-      return std::make_unique<IntegralLiteral>(number);
+      return this->program.arena.make<IntegralLiteral>(number);
    }
    else if (is(TType::real))
    {
-      long double number = 0.0;
+      real_t number = 0.0;
 
       try
-      { number = std::stold(current().lexeme); }
+      { number = parse_real(current().lexeme); }
       catch (...)
       { this->catcher.insert(err::could_not_convert_number); }
 
       advance();
-      return std::make_unique<RealLiteral>(number);
+      return this->program.arena.make<RealLiteral>(number);
    }
    else if (is(TType::string))
    {
-      std::string string = current().lexeme;
+      auto string = this->program.arena.copy(current().lexeme);
       advance();
-      return std::make_unique<StringLiteral>(string);
+      return this->program.arena.make<StringLiteral>(string);
    }
    else if (is(TType::character))
    {
       char ch = (current().lexeme.size() == 0 ? char{} : current().lexeme.at(0));
       advance();
-      return std::make_unique<CharLiteral>(ch);
+      return this->program.arena.make<CharLiteral>(ch);
    }
    else if (is(TType::l_paren))
    {
@@ -479,7 +320,7 @@ Stmt Parser::parse_primary_expr()
    {
       this->catcher.insert(err::expected_primary_expression);
       advance();
-      return std::make_unique<NullLiteral>();
+      return this->program.arena.make<NullLiteral>();
    }
 }
 
@@ -500,6 +341,44 @@ bool Parser::is_type() const
    return t.type == TType::keyword && (t.lexeme == "int"s || t.lexeme == "real"s || t.lexeme == "char"s || t.lexeme == "string"s || t.lexeme == "bool"s); 
 }
 
+bool Parser::is_declaration(const Token& token) const
+{
+   if (token.lexeme == "mut"s || token.lexeme == "con"s || token.lexeme == "let"s)
+      return true;
+   return token.type == TType::keyword && (token.lexeme == "int"s || token.lexeme == "real"s || token.lexeme == "char"s || token.lexeme == "string"s || token.lexeme == "bool"s);
+}
+
+bool Parser::is_group() const
+{
+   return is(TType::l_paren) && !(this->index + 1 < this->tokens.size() && is_declaration(this->tokens.at(this->index + 1)));
+}
+
+int Parser::get_operator_precedence(TType type) const
+{
+   switch (type)
+   {
+      case TType::bitwise_and_equals: case TType::bitwise_xor_equals: case TType::bitwise_or_equals: return 1;
+      case TType::shift_left_equals: case TType::shift_right_equals: return 2;
+      case TType::plus_equals: case TType::minus_equals: return 3;
+      case TType::star_equals: case TType::slash_equals: case TType::percent_equals: return 4;
+      case TType::star_star_equals: return 5;
+      case TType::equals: return 6;
+      case TType::question: return 7;
+      case TType::logical_or: return 8;
+      case TType::logical_and: return 9;
+      case TType::bitwise_or: return 10;
+      case TType::bitwise_xor: return 11;
+      case TType::bitwise_and: return 12;
+      case TType::equals_equals: case TType::not_equals: return 13;
+      case TType::smaller: case TType::smaller_equals: case TType::bigger: case TType::bigger_equals: return 14;
+      case TType::shift_left: case TType::shift_right: return 15;
+      case TType::plus: case TType::minus: return 16;
+      case TType::star: case TType::slash: case TType::percent: return 17;
+      case TType::star_star: return max_precedence;
+      default: return 0;
+   }
+}
+
 Token& Parser::current()
 {
    return this->tokens.at(this->index);
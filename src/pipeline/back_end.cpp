@@ -0,0 +1,64 @@
+#include "pipeline/back_end.hpp"
+#include "resolver/resolver.hpp"
+#include "resolver/type_checker.hpp"
+#include <chrono>
+
+namespace
+{
+   long microseconds(std::chrono::high_resolution_clock::time_point start)
+   {
+      auto end = std::chrono::high_resolution_clock::now();
+      return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+   }
+} // namespace
+
+BackEnd::BackEnd(Catcher& catcher, Program& program, PassManager& passes)
+   : catcher(catcher), program(program), passes(passes) {}
+
+void BackEnd::define(const std::string& name, VType type)
+{
+   this->names.push_back(name);
+   this->types.push_back(type);
+}
+
+std::optional<FlatProgram> BackEnd::compile()
+{
+   Resolver resolver (this->catcher, this->program);
+   for (const auto& name : this->names)
+      resolver.define(name);
+   auto start = std::chrono::high_resolution_clock::now();
+   resolver.resolve();
+   this->measured.resolve = microseconds(start);
+
+   if (this->catcher.display())
+      return std::nullopt;
+
+   TypeChecker checker (this->catcher, this->program);
+   for (std::uint32_t i = 0; i < this->types.size(); ++i)
+      checker.define(i, this->types[i]);
+   start = std::chrono::high_resolution_clock::now();
+   this->measured.typed = checker.check();
+   this->measured.check = microseconds(start);
+
+   if (this->catcher.display())
+      return std::nullopt;
+
+   for (std::uint32_t i = 0; i < this->types.size(); ++i)
+      this->passes.define(i, this->types[i]);
+
+   if (!this->passes.run())
+   {
+      this->catcher.display();
+      return std::nullopt;
+   }
+
+   start = std::chrono::high_resolution_clock::now();
+   auto flat = flatten(this->program);
+   this->measured.flatten = microseconds(start);
+   return flat;
+}
+
+const BackEnd::Times& BackEnd::times() const
+{
+   return this->measured;
+}
@@ -0,0 +1,214 @@
+#include "pipeline/pipeline.hpp"
+#include "lexer/lexer.hpp"
+#include "preprocessor/preprocessor.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
+#include <iterator>
+#include <thread>
+
+Pipeline::Pipeline(Catcher& catcher, std::string& source, const std::string& file, bool skip_preprocessor, bool skip_macros)
+   : catcher(catcher), source(source), file(file), skip_preprocessor(skip_preprocessor), skip_macros(skip_macros),
+     parser(this->parser_catcher, this->parser_tokens) {}
+
+void Pipeline::specify_max_macro_depth(size_t max_macro_depth)
+{
+   this->max_macro_depth = max_macro_depth;
+}
+
+Program& Pipeline::run()
+{
+   auto precision = real_precision;
+   auto cancel = cancel_flag;
+   std::thread preprocessor_thread ([this, precision, cancel]() { real_precision = precision; cancel_flag = cancel; run_preprocessor(); });
+   std::thread parser_thread ([this, precision, cancel]() { real_precision = precision; cancel_flag = cancel; run_parser(); });
+
+   Lexer lexer (this->lexer_catcher, this->source);
+   lexer.specify_line_sink([this](std::vector<Token>& tokens) { segment(tokens); });
+   auto& tokens = lexer.tokenize();
+
+   if (tokens.empty() || tokens.back().type != TType::eof)
+      tokens.emplace_back(TType::eof, "EOF");
+   this->lexed.push(std::move(tokens));
+
+   preprocessor_thread.join();
+   parser_thread.join();
+
+   // Later stages only ever see input that the serial path would have rejected
+   // earlier, so only the errors of the first failing stage are reported.
+   for (auto* stage : {&this->lexer_catcher, &this->preprocessor_catcher, &this->parser_catcher})
+   {
+      if (!stage->empty())
+      {
+         this->catcher.merge(*stage);
+         break;
+      }
+   }
+   return *this->program;
+}
+
+void Pipeline::segment(std::vector<Token>& tokens)
+{
+   for (; this->scanned < tokens.size(); ++this->scanned)
+   {
+      TType type = tokens.at(this->scanned).type;
+
+      if (this->cut && type != TType::newline)
+      {
+         // '##', '#==' and '#!=' work on the two tokens before them.
+         if (type != TType::hash_hash && type != TType::hash_equals && type != TType::hash_not_equals)
+         {
+            TokenBatch batch (std::make_move_iterator(tokens.begin()), std::make_move_iterator(tokens.begin() + this->cut));
+            tokens.erase(tokens.begin(), tokens.begin() + this->cut);
+            this->scanned -= this->cut;
+            this->lexed.push(std::move(batch));
+         }
+         this->cut = 0;
+      }
+
+      if (track(tokens.at(this->scanned)) && this->scanned + 1 >= batch_size)
+         this->cut = this->scanned + 1;
+   }
+}
+
+bool Pipeline::track(const Token& token)
+{
+   switch (token.type)
+   {
+   case TType::newline:
+      if (this->wait_newline)
+      {
+         this->wait_newline = false;
+         this->line_complete = true;
+      }
+      return !this->paren_depth && !this->mcond_depth && !this->wait_semicolon && this->line_complete;
+   case TType::semicolon:
+      this->wait_semicolon = false;
+      this->line_complete = true;
+      return false;
+   case TType::l_paren:
+      ++this->paren_depth;
+      break;
+   case TType::r_paren:
+      if (this->paren_depth)
+         --this->paren_depth;
+      break;
+   case TType::macro:
+      if (token.lexeme == "endif")
+      {
+         if (this->mcond_depth)
+            --this->mcond_depth;
+         this->line_complete = true;
+         return false;
+      }
+      else if (token.lexeme == "else")
+         return false;
+      else if (token.lexeme == "if")
+      {
+         ++this->mcond_depth;
+         this->wait_newline = true;
+      }
+      else if (token.lexeme == "elif" || token.lexeme == "defl" || token.lexeme == "logl")
+         this->wait_newline = true;
+      else
+         this->wait_semicolon = true;
+      break;
+   default:
+      break;
+   }
+   this->line_complete = false;
+   return false;
+}
+
+void Pipeline::run_preprocessor()
+{
+   Preprocessor preprocessor (this->preprocessor_catcher, this->preprocessor_tokens, this->file, this->skip_macros);
+
+   if (this->max_macro_depth)
+      preprocessor.specify_max_macro_depth(this->max_macro_depth);
+
+   bool failed = false;
+
+   while (true)
+   {
+      auto batch = this->lexed.pop();
+      bool last = (batch.back().type == TType::eof);
+
+      if (failed)
+         batch.clear();
+      else if (!this->skip_preprocessor)
+      {
+         this->preprocessor_tokens = std::move(batch);
+
+         if (!last)
+            this->preprocessor_tokens.emplace_back(TType::eof, "EOF");
+
+         preprocessor.refill();
+         preprocessor.process();
+
+         // Error messages of '#error' and '#assert' point into these tokens.
+         failed = !this->preprocessor_catcher.empty();
+
+         if (!failed)
+         {
+            batch = std::move(this->preprocessor_tokens);
+
+            if (!last && !batch.empty() && batch.back().type == TType::eof)
+               batch.pop_back();
+         }
+      }
+
+      if (last && (batch.empty() || batch.back().type != TType::eof))
+         batch.emplace_back(TType::eof, "EOF");
+
+      this->processed.push(std::move(batch));
+
+      if (last)
+      {
+         this->deterministic = preprocessor.is_deterministic();
+         this->included_files = preprocessor.get_included_files();
+         this->log = preprocessor.get_log();
+         return;
+      }
+   }
+}
+
+bool Pipeline::is_deterministic() const
+{
+   return this->deterministic;
+}
+
+const std::unordered_set<std::string>& Pipeline::get_included_files() const
+{
+   return this->included_files;
+}
+
+const std::string& Pipeline::get_log() const
+{
+   return this->log;
+}
+
+void Pipeline::run_parser()
+{
+   bool failed = false;
+
+   while (true)
+   {
+      auto batch = this->processed.pop();
+      bool last = (!batch.empty() && batch.back().type == TType::eof);
+
+      if (!failed)
+      {
+         this->parser_tokens = std::move(batch);
+
+         if (!last)
+            this->parser_tokens.emplace_back(TType::eof, "EOF");
+
+         this->parser.refill();
+         this->program = &this->parser.parse();
+         failed = !this->parser_catcher.empty();
+      }
+
+      if (last)
+         return;
+   }
+}
@@ -3,6 +3,8 @@
 #include "io/files.hpp"
 #include "lexer/lexer.hpp"
 #include "config/version.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
 #include <iomanip>
 #include <algorithm>
 #include <iostream>
@@ -55,7 +57,14 @@ Preprocessor::Preprocessor(Catcher& catcher, std::vector<Token>& tokens, const s
    this->macros.insert({"__EPOCH_NS__", {token}});
 
    auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-   std::tm now_tm = *std::localtime(&now);
+   std::tm now_tm {};
+
+   // std::localtime shares its result between threads, scripts can compile on many.
+   #if defined(_WIN32)
+   localtime_s(&now_tm, &now);
+   #else
+   localtime_r(&now, &now_tm);
+   #endif
 
    std::ostringstream oss;
    oss << std::put_time(&now_tm, "%Y-%m-%d");
@@ -120,11 +129,25 @@ void Preprocessor::specify_max_macro_depth(size_t max_macro_depth)
    this->max_macro_depth = max_macro_depth;
 }
 
+void Preprocessor::specify_log_sink(LogSink log_sink)
+{
+   this->log_sink = std::move(log_sink);
+}
+
+void Preprocessor::specify_token_cache(TokenCache* token_cache)
+{
+   this->token_cache = token_cache;
+}
+
 void Preprocessor::process()
 {
    for (; this->index < this->total_size; ++this->index)
    {
-      evaluate_token();
+      if (cancelled())
+         this->catcher.insert(err::job_cancelled);
+      else
+         evaluate_token();
+
       if (!this->catcher.empty())
          return;
    }
@@ -135,6 +158,28 @@ void Preprocessor::process()
    }), this->tokens.end());
 }
 
+void Preprocessor::refill()
+{
+   this->index = 0;
+   this->total_size = this->tokens.size();
+   this->macro_depth = 0;
+}
+
+bool Preprocessor::is_deterministic() const
+{
+   return this->deterministic;
+}
+
+const std::unordered_set<std::string>& Preprocessor::get_included_files() const
+{
+   return this->included_files;
+}
+
+const std::string& Preprocessor::get_log() const
+{
+   return this->log_output;
+}
+
 void Preprocessor::evaluate_token()
 {
    auto& token = current();
@@ -339,6 +384,7 @@ void Preprocessor::handle_using_macro()
 
    auto& token = current();
    auto& definition = this->macros.at(token.lexeme);
+   check_time_macro(token.lexeme);
 
    token = skip();
    bool args = (token.type == TType::l_paren);
@@ -588,16 +634,26 @@ void Preprocessor::handle_file(const std::string& file, bool include_guard)
    if (!contains)
       this->included_files.insert(file);
    
-   std::string input = read_file(this->catcher, file);
+   std::vector<Token> tokens;
 
-   if (!this->catcher.empty())
-      return;
-   
-   Lexer lexer (this->catcher, input);
-   auto& tokens = lexer.tokenize();
+   if (this->token_cache && this->token_cache->contains(file))
+      tokens = this->token_cache->at(file);
+   else
+   {
+      std::string input = read_file(this->catcher, file);
 
-   if (!this->catcher.empty())
-      return;
+      if (!this->catcher.empty())
+         return;
+
+      Lexer lexer (this->catcher, input);
+      tokens = std::move(lexer.tokenize());
+
+      if (!this->catcher.empty())
+         return;
+
+      if (this->token_cache)
+         this->token_cache->insert({file, tokens});
+   }
 
    if (this->macros.find("__FILE__") != this->macros.end())
    {
@@ -750,7 +806,7 @@ bool Preprocessor::handle_boolean_expressions()
       reversed.push(token);
    }
 
-   std::stack<long double> evaluated;
+   std::stack<real_t> evaluated;
 
    while (!reversed.empty())
    {
@@ -766,6 +822,7 @@ bool Preprocessor::handle_boolean_expressions()
          }
 
          auto& macro_body = this->macros.at(token.lexeme);
+         check_time_macro(token.lexeme);
 
          if (macro_body.size() == 1 && macro_body.at(0).type == TType::skip)
          {
@@ -778,10 +835,10 @@ bool Preprocessor::handle_boolean_expressions()
       }
       else if (token.type == TType::real || token.type == TType::integer)
       {
-         long double result = 0.0;
+         real_t result = 0.0;
          try
          {
-            result = std::stold(token.lexeme);
+            result = parse_real(token.lexeme);
          }
          catch (...)
          {
@@ -798,8 +855,8 @@ bool Preprocessor::handle_boolean_expressions()
             return false;
          }
 
-         long double a = evaluated.top();
-         long double result = (a == 0.0 ? 1.0 : 0.0);
+         real_t a = evaluated.top();
+         real_t result = (a == 0.0 ? 1.0 : 0.0);
          evaluated.pop();
          evaluated.push(result);
       }
@@ -811,12 +868,12 @@ bool Preprocessor::handle_boolean_expressions()
             return false;
          }
 
-         long double b = evaluated.top();
+         real_t b = evaluated.top();
          evaluated.pop();
-         long double a = evaluated.top();
+         real_t a = evaluated.top();
          evaluated.pop();
 
-         long double result = 0.0;
+         real_t result = 0.0;
          switch (token.type)
          {
          case TType::logical_and:
@@ -951,7 +1008,13 @@ void Preprocessor::handle_logging()
    skip();
 
    --this->index;
-   std::cout << log << "\n";
+   log += '\n';
+
+   if (this->log_sink)
+      this->log_sink(log);
+   else
+      std::cout << log;
+   this->log_output += log;
 }
 
 void Preprocessor::handle_asserts()
@@ -984,6 +1047,12 @@ void Preprocessor::handle_asserts()
    --this->index;
 }
 
+void Preprocessor::check_time_macro(const std::string& macro)
+{
+   if (macro == "__EPOCH__" || macro == "__EPOCH_NS__" || macro == "__DATE__" || macro == "__TIME__" || macro == "__DATETIME__")
+      this->deterministic = false;
+}
+
 Token& Preprocessor::current()
 {
    return this->tokens.at(this->index);
@@ -0,0 +1,120 @@
+#include "resolver/resolver.hpp"
+#include "errors/errors.hpp"
+
+Resolver::Resolver(Catcher& catcher, Program& program)
+   : catcher(catcher), program(program)
+{
+   // Scripts only have the global scope for now.
+   this->scopes.emplace_back();
+}
+
+std::uint32_t Resolver::define(std::string_view name, bool con, bool mut)
+{
+   this->scopes.front().insert_or_assign(name, Binding {this->slots, con, mut});
+   return this->slots++;
+}
+
+std::uint32_t Resolver::resolve()
+{
+   for (auto stmt : this->program.statements)
+      resolve_stmt(stmt);
+   return this->slots;
+}
+
+void Resolver::resolve_stmt(Stmt stmt)
+{
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+      resolve_var_decl(static_cast<VarDeclaration*>(stmt));
+      break;
+   case StmtType::assignment:
+   {
+      auto* s = static_cast<AssignmentExpr*>(stmt);
+      resolve_stmt(s->right);
+      resolve_assignment(s->left);
+      break;
+   }
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<TernaryExpr*>(stmt);
+      resolve_stmt(s->expr);
+      resolve_stmt(s->left);
+      resolve_stmt(s->right);
+      break;
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<BinaryExpr*>(stmt);
+      resolve_stmt(s->left);
+      resolve_stmt(s->right);
+      break;
+   }
+   case StmtType::unary:
+   {
+      auto* s = static_cast<UnaryExpr*>(stmt);
+
+      if (s->op == TType::plus_plus || s->op == TType::right_plus_plus || s->op == TType::minus_minus || s->op == TType::right_minus_minus)
+         resolve_assignment(s->value);
+      else
+         resolve_stmt(s->value);
+      break;
+   }
+   case StmtType::identifier:
+      resolve_identifier(static_cast<Identifier*>(stmt));
+      break;
+   default:
+      break;
+   }
+}
+
+void Resolver::resolve_var_decl(VarDeclaration* decl)
+{
+   // The body is resolved first, so 'int x = x;' refers to the previous 'x'.
+   resolve_stmt(decl->body);
+
+   auto* type = static_cast<TypeExpr*>(decl->ttype);
+   auto& scope = this->scopes.back();
+   auto it = scope.find(decl->identifier);
+
+   if (it != scope.end() && it->second.con)
+   {
+      this->catcher.insert(err::con_shadowing);
+      return;
+   }
+
+   decl->slot = this->slots++;
+   scope.insert_or_assign(decl->identifier, Binding {decl->slot, type->con, type->mut});
+}
+
+void Resolver::resolve_assignment(Stmt target)
+{
+   if (target->type() != StmtType::identifier)
+   {
+      this->catcher.insert(err::invalid_assignment_target);
+      return;
+   }
+
+   auto* binding = resolve_identifier(static_cast<Identifier*>(target));
+
+   if (binding && !binding->mut)
+      this->catcher.insert(err::immutable_assignment);
+}
+
+const Resolver::Binding* Resolver::resolve_identifier(Identifier* identifier)
+{
+   for (size_t i = this->scopes.size(); i-- > 0;)
+   {
+      auto it = this->scopes[i].find(identifier->identifier);
+
+      if (it != this->scopes[i].end())
+      {
+         identifier->scope = static_cast<std::uint32_t>(i);
+         identifier->slot = it->second.slot;
+         return &it->second;
+      }
+   }
+
+   this->catcher.insert(err::undefined_variable);
+   return nullptr;
+}
@@ -0,0 +1,151 @@
+#include "resolver/type_checker.hpp"
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+
+TypeChecker::TypeChecker(Catcher& catcher, Program& program)
+   : catcher(catcher), program(program) {}
+
+void TypeChecker::define(std::uint32_t slot, VType type)
+{
+   if (slot >= this->slots.size())
+      this->slots.resize(slot + 1, VType::null);
+   this->slots[slot] = type;
+}
+
+size_t TypeChecker::check()
+{
+   for (auto stmt : this->program.statements)
+      check_stmt(stmt);
+   return this->typed;
+}
+
+VType TypeChecker::check_stmt(Stmt stmt)
+{
+   VType type = VType::null;
+
+   switch (stmt->type())
+   {
+   case StmtType::var_decl:
+      type = check_var_decl(static_cast<VarDeclaration*>(stmt));
+      break;
+   case StmtType::assignment:
+      type = check_assignment(static_cast<AssignmentExpr*>(stmt));
+      break;
+   case StmtType::ternary:
+   {
+      auto* s = static_cast<TernaryExpr*>(stmt);
+      report(truthy_type(check_stmt(s->expr)));
+
+      auto left = check_stmt(s->left);
+      auto right = check_stmt(s->right);
+      type = (left == right ? left : VType::null);
+      break;
+   }
+   case StmtType::binary:
+   {
+      auto* s = static_cast<BinaryExpr*>(stmt);
+      auto left = check_stmt(s->left);
+      auto right = check_stmt(s->right);
+
+      // '&&' and '||' only test their operands.
+      if (s->op == TType::logical_and || s->op == TType::logical_or)
+      {
+         report(truthy_type(left));
+         report(truthy_type(right));
+         type = VType::integer;
+      }
+      else
+         report(binary_type(s->op, left, right, type));
+      break;
+   }
+   case StmtType::unary:
+      type = check_unary(static_cast<UnaryExpr*>(stmt));
+      break;
+   case StmtType::identifier:
+      type = this->slots[static_cast<Identifier*>(stmt)->slot];
+      break;
+   case StmtType::real:
+      type = VType::real;
+      break;
+   case StmtType::integer:
+      type = VType::integer;
+      break;
+   case StmtType::string:
+      type = VType::string;
+      break;
+   case StmtType::character:
+      type = VType::character;
+      break;
+   default:
+      break;
+   }
+
+   stmt->static_type = type;
+   this->typed += (type != VType::null);
+   return type;
+}
+
+VType TypeChecker::check_var_decl(VarDeclaration* decl)
+{
+   auto* type = static_cast<TypeExpr*>(decl->ttype);
+   auto value = check_stmt(decl->body);
+
+   if (decl->slot >= this->slots.size())
+      this->slots.resize(decl->slot + 1, VType::null);
+
+   // 'let' takes the type of its initial value.
+   if (type->automatic)
+      this->slots[decl->slot] = value;
+   else
+   {
+      this->slots[decl->slot] = type_from_name(type->ttype);
+      check_store(this->slots[decl->slot], value);
+   }
+
+   decl->ttype->static_type = this->slots[decl->slot];
+   return this->slots[decl->slot];
+}
+
+VType TypeChecker::check_assignment(AssignmentExpr* assignment)
+{
+   auto value = check_stmt(assignment->right);
+   auto target = check_stmt(assignment->left);
+
+   if (assignment->op != TType::equals)
+      report(binary_type(compound_operator(assignment->op), target, value, value));
+
+   check_store(target, value);
+   return target;
+}
+
+VType TypeChecker::check_unary(UnaryExpr* unary)
+{
+   auto value = check_stmt(unary->value);
+   VType result = VType::null;
+
+   switch (unary->op)
+   {
+   case TType::plus_plus:
+   case TType::right_plus_plus:
+   case TType::minus_minus:
+   case TType::right_minus_minus:
+      report(binary_type(TType::plus, value, VType::integer, result));
+      return value;
+   default:
+      report(unary_type(unary->op, value, result));
+      return result;
+   }
+}
+
+void TypeChecker::report(const char* error)
+{
+   if (error)
+      this->catcher.insert(error);
+}
+
+void TypeChecker::check_store(VType target, VType value)
+{
+   // Numbers convert into each other, strings only ever hold strings.
+   if (target != VType::null && value != VType::null && (target == VType::string) != (value == VType::string))
+      this->catcher.insert(err::type_mismatch);
+}
@@ -0,0 +1,52 @@
+#include "runtime/box.hpp"
+#include "config/precision.hpp"
+
+Box box(const Value& value, Heap& heap)
+{
+   switch (type_of(value))
+   {
+   case VType::integer:
+      return Box::from_int(std::get<long long>(value), heap);
+   case VType::real:
+      if (real_precision == Precision::long_real)
+      {
+         heap.longs.push_back(std::get<real_t>(value));
+         heap.bytes += sizeof(real_t);
+         return Box::tagged(Box::long_tag, heap.longs.size() - 1);
+      }
+      return Box::from_real(static_cast<double>(std::get<real_t>(value)));
+   case VType::character:
+      return Box::tagged(Box::char_tag, static_cast<unsigned char>(std::get<char>(value)));
+   case VType::boolean:
+      return Box::tagged(Box::bool_tag, std::get<bool>(value));
+   case VType::string:
+      heap.strings.push_back(std::get<std::string>(value));
+      heap.bytes += heap.strings.back().size();
+      return Box::tagged(Box::string_tag, heap.strings.size() - 1);
+   default:
+      return Box {};
+   }
+}
+
+Value unbox(Box box, const Heap& heap)
+{
+   if (box.is_real())
+      return static_cast<real_t>(box.real());
+
+   switch (box.tag())
+   {
+   case Box::int_tag:
+   case Box::wide_tag:
+      return box.integer(heap);
+   case Box::char_tag:
+      return static_cast<char>(box.index());
+   case Box::bool_tag:
+      return box.index() != 0;
+   case Box::string_tag:
+      return heap.strings[box.index()];
+   case Box::long_tag:
+      return heap.longs[box.index()];
+   default:
+      return std::monostate {};
+   }
+}
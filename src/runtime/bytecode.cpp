@@ -0,0 +1,65 @@
+#include "runtime/bytecode.hpp"
+#include <cstdio>
+#include <iostream>
+
+const char* opcode_to_string(OpCode op)
+{
+   #define X(name, layout) case OpCode::name: return #name;
+   switch (op)
+   {
+   OPCODES(X)
+   }
+   #undef X
+   return "unknown";
+}
+
+static Layout layout_of(OpCode op)
+{
+   #define X(name, layout) case OpCode::name: return Layout::layout;
+   switch (op)
+   {
+   OPCODES(X)
+   }
+   #undef X
+   return Layout::none;
+}
+
+void Chunk::disassemble() const
+{
+   for (const auto& [slot, name] : this->variables)
+      std::cout << "r" << slot << " = [" << name << "]\n";
+
+   size_t statement = 0;
+
+   for (std::uint32_t pc = 0; pc < this->code.size(); ++pc)
+   {
+      const auto& ins = this->code[pc];
+
+      if (statement < this->statements.size() && this->statements[statement] == pc)
+         printf("; statement %zu\n", statement++);
+
+      printf("%04u  %-14s", pc, opcode_to_string(ins.op));
+
+      switch (layout_of(ins.op))
+      {
+      case Layout::none: break;
+      case Layout::a: printf("r%u", ins.a); break;
+      case Layout::ab: printf("r%u, r%u", ins.a, ins.b); break;
+      case Layout::abc: printf("r%u, r%u, r%u", ins.a, ins.b, ins.c); break;
+      case Layout::a_imm: printf("r%u, %lld", ins.a, static_cast<long long>(ins.b | std::uint64_t{ins.c} << 32)); break;
+      case Layout::a_const: printf("r%u, k%u", ins.a, ins.b); break;
+      case Layout::a_type: printf("r%u, %s", ins.a, type_to_name(ins.vtype)); break;
+      case Layout::jump: printf("%04u", ins.a); break;
+      case Layout::a_jump: printf("r%u, %04u", ins.a, ins.b); break;
+      case Layout::region: printf("n%u, %04u", ins.a, ins.b); break;
+      }
+
+      if (ins.op == OpCode::binary || ins.op == OpCode::unary)
+         printf("  (%s)", token_to_string(ins.ttype));
+      else if (ins.op == OpCode::native)
+         printf("  (%u statements)", ins.c);
+      else if (ins.op == OpCode::load)
+         std::cout << "  (" << to_string(this->constants[ins.b]) << ")";
+      printf("\n");
+   }
+}
@@ -0,0 +1,1102 @@
+#include "runtime/columnar.hpp"
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include "config/cancellation.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define COLUMNAR_AVX2
+#include <immintrin.h>
+#endif
+
+namespace
+{
+   // Records per batch, small enough for the registers of a script to stay in the cache.
+   constexpr size_t batch_size = 1024;
+   constexpr std::uint32_t no_mask = std::numeric_limits<std::uint32_t>::max();
+
+   bool is_comparison(TType op)
+   {
+      switch (op)
+      {
+      case TType::equals_equals: case TType::not_equals:
+      case TType::smaller: case TType::smaller_equals:
+      case TType::bigger: case TType::bigger_equals:
+         return true;
+      default:
+         return false;
+      }
+   }
+
+   bool is_supported(VType type)
+   {
+      return type == VType::integer || type == VType::real || type == VType::boolean;
+   }
+
+   // The kernels return whether any record may have failed, the failing records and
+   // their errors are found again with the scalar operations.
+   namespace scalar
+   {
+      template <typename T, typename Compare>
+      void compare_with(const T* a, const T* b, long long* dst, size_t n, Compare compare)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = compare(a[i], b[i]);
+      }
+
+      template <typename T>
+      bool compare(TType op, const T* a, const T* b, long long* dst, size_t n)
+      {
+         switch (op)
+         {
+         case TType::equals_equals: compare_with(a, b, dst, n, [](T x, T y) { return x == y; }); break;
+         case TType::not_equals: compare_with(a, b, dst, n, [](T x, T y) { return x != y; }); break;
+         case TType::smaller: compare_with(a, b, dst, n, [](T x, T y) { return x < y; }); break;
+         case TType::smaller_equals: compare_with(a, b, dst, n, [](T x, T y) { return x <= y; }); break;
+         case TType::bigger: compare_with(a, b, dst, n, [](T x, T y) { return x > y; }); break;
+         case TType::bigger_equals: compare_with(a, b, dst, n, [](T x, T y) { return x >= y; }); break;
+         default: break;
+         }
+         return false;
+      }
+
+      bool int_binary(TType op, const long long* a, const long long* b, long long* dst, size_t n)
+      {
+         bool failed = false;
+
+         switch (op)
+         {
+         case TType::plus:
+            for (size_t i = 0; i < n; ++i)
+               failed |= __builtin_add_overflow(a[i], b[i], &dst[i]);
+            return failed;
+         case TType::minus:
+            for (size_t i = 0; i < n; ++i)
+               failed |= __builtin_sub_overflow(a[i], b[i], &dst[i]);
+            return failed;
+         case TType::star:
+            for (size_t i = 0; i < n; ++i)
+               failed |= __builtin_mul_overflow(a[i], b[i], &dst[i]);
+            return failed;
+         case TType::slash:
+         case TType::percent:
+            for (size_t i = 0; i < n; ++i)
+            {
+               if (b[i] == 0 || (a[i] == std::numeric_limits<long long>::min() && b[i] == -1))
+               {
+                  failed |= (b[i] == 0 || op == TType::slash);
+                  dst[i] = 0;
+               }
+               else
+                  dst[i] = (op == TType::slash ? a[i] / b[i] : a[i] % b[i]);
+            }
+            return failed;
+         case TType::shift_left:
+         case TType::shift_right:
+            for (size_t i = 0; i < n; ++i)
+            {
+               failed |= (b[i] < 0 || b[i] > 63);
+               auto shift = b[i] & 63;
+               dst[i] = (op == TType::shift_left ? static_cast<long long>(static_cast<unsigned long long>(a[i]) << shift) : a[i] >> shift);
+            }
+            return failed;
+         case TType::bitwise_and:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] & b[i];
+            return false;
+         case TType::bitwise_or:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] | b[i];
+            return false;
+         case TType::bitwise_xor:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] ^ b[i];
+            return false;
+         default:
+            if (is_comparison(op))
+               return compare(op, a, b, dst, n);
+
+            // '**' has no kernel of its own.
+            for (size_t i = 0; i < n; ++i)
+            {
+               Value result;
+
+               if (integer_operation(op, a[i], b[i], result))
+               {
+                  failed = true;
+                  dst[i] = 0;
+               }
+               else
+                  dst[i] = std::get<long long>(result);
+            }
+            return failed;
+         }
+      }
+
+      bool real_binary(TType op, const double* a, const double* b, double* dst, size_t n)
+      {
+         bool failed = false;
+
+         switch (op)
+         {
+         case TType::plus:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] + b[i];
+            return false;
+         case TType::minus:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] - b[i];
+            return false;
+         case TType::star:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = a[i] * b[i];
+            return false;
+         case TType::slash:
+            for (size_t i = 0; i < n; ++i)
+            {
+               failed |= (b[i] == 0.0);
+               dst[i] = a[i] / b[i];
+            }
+            return failed;
+         case TType::percent:
+            for (size_t i = 0; i < n; ++i)
+            {
+               failed |= (b[i] == 0.0);
+               dst[i] = std::fmod(a[i], b[i]);
+            }
+            return failed;
+         case TType::star_star:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = std::pow(a[i], b[i]);
+            return false;
+         default:
+            return false;
+         }
+      }
+
+      bool int_unary(TType op, const long long* a, long long* dst, size_t n)
+      {
+         bool failed = false;
+
+         switch (op)
+         {
+         case TType::minus:
+            for (size_t i = 0; i < n; ++i)
+            {
+               failed |= (a[i] == std::numeric_limits<long long>::min());
+               dst[i] = static_cast<long long>(0ull - static_cast<unsigned long long>(a[i]));
+            }
+            return failed;
+         case TType::bitwise_not:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = ~a[i];
+            return false;
+         case TType::logical_not:
+            for (size_t i = 0; i < n; ++i)
+               dst[i] = (a[i] == 0);
+            return false;
+         default:
+            return false;
+         }
+      }
+
+      void real_negate(const double* a, double* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = -a[i];
+      }
+
+      void real_not(const double* a, long long* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = (a[i] == 0.0);
+      }
+
+      void int_to_real(const long long* a, double* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = static_cast<double>(a[i]);
+      }
+
+      bool real_to_int(const double* a, long long* dst, size_t n)
+      {
+         bool failed = false;
+
+         for (size_t i = 0; i < n; ++i)
+         {
+            bool fits = (a[i] >= -9223372036854775808.0 && a[i] < 9223372036854775808.0);
+            failed |= !fits;
+            dst[i] = (fits ? static_cast<long long>(a[i]) : 0);
+         }
+         return failed;
+      }
+
+      void truthy_int(const long long* a, long long* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = (a[i] != 0);
+      }
+
+      void truthy_real(const double* a, long long* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = (a[i] != 0.0);
+      }
+
+      void mask_and(const long long* mask, const long long* a, long long* dst, size_t n, bool negated)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = mask[i] & (a[i] ^ negated);
+      }
+
+      template <typename T>
+      void select(const long long* condition, const T* a, const T* b, T* dst, size_t n)
+      {
+         for (size_t i = 0; i < n; ++i)
+            dst[i] = (condition[i] ? a[i] : b[i]);
+      }
+   } // namespace scalar
+
+#ifdef COLUMNAR_AVX2
+   // Four records per instruction, the records that do not fill a vector go through
+   // the scalar kernels.
+   namespace avx2
+   {
+      #define AVX2 __attribute__((target("avx2")))
+
+      AVX2 inline __m256i load(const long long* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+      AVX2 inline void store(long long* p, __m256i v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+      AVX2 inline bool any_sign(__m256i v) { return _mm256_movemask_pd(_mm256_castsi256_pd(v)) != 0; }
+
+      AVX2 bool int_binary(TType op, const long long* a, const long long* b, long long* dst, size_t n)
+      {
+         const auto one = _mm256_set1_epi64x(1);
+         const auto zero = _mm256_setzero_si256();
+         const auto max_shift = _mm256_set1_epi64x(63);
+         auto failed = zero;
+         size_t i = 0;
+
+         switch (op)
+         {
+         case TType::plus:
+         case TType::minus:
+         case TType::shift_left:
+         case TType::bitwise_and:
+         case TType::bitwise_or:
+         case TType::bitwise_xor:
+            break;
+         default:
+            if (!is_comparison(op))
+               return scalar::int_binary(op, a, b, dst, n);
+            break;
+         }
+
+         for (; i + 4 <= n; i += 4)
+         {
+            auto x = load(a + i), y = load(b + i), r = zero;
+
+            switch (op)
+            {
+            case TType::plus:
+               r = _mm256_add_epi64(x, y);
+               // Overflowed when both operands have a sign the result does not have.
+               failed = _mm256_or_si256(failed, _mm256_and_si256(_mm256_xor_si256(x, r), _mm256_xor_si256(y, r)));
+               break;
+            case TType::minus:
+               r = _mm256_sub_epi64(x, y);
+               failed = _mm256_or_si256(failed, _mm256_and_si256(_mm256_xor_si256(x, y), _mm256_xor_si256(x, r)));
+               break;
+            case TType::shift_left:
+               r = _mm256_sllv_epi64(x, y);
+               failed = _mm256_or_si256(failed, _mm256_or_si256(_mm256_cmpgt_epi64(zero, y), _mm256_cmpgt_epi64(y, max_shift)));
+               break;
+            case TType::bitwise_and: r = _mm256_and_si256(x, y); break;
+            case TType::bitwise_or: r = _mm256_or_si256(x, y); break;
+            case TType::bitwise_xor: r = _mm256_xor_si256(x, y); break;
+            case TType::equals_equals: r = _mm256_and_si256(_mm256_cmpeq_epi64(x, y), one); break;
+            case TType::not_equals: r = _mm256_andnot_si256(_mm256_cmpeq_epi64(x, y), one); break;
+            case TType::smaller: r = _mm256_and_si256(_mm256_cmpgt_epi64(y, x), one); break;
+            case TType::smaller_equals: r = _mm256_andnot_si256(_mm256_cmpgt_epi64(x, y), one); break;
+            case TType::bigger: r = _mm256_and_si256(_mm256_cmpgt_epi64(x, y), one); break;
+            case TType::bigger_equals: r = _mm256_andnot_si256(_mm256_cmpgt_epi64(y, x), one); break;
+            default: break;
+            }
+            store(dst + i, r);
+         }
+
+         bool tail = scalar::int_binary(op, a + i, b + i, dst + i, n - i);
+         return tail || any_sign(failed);
+      }
+
+      template <int predicate>
+      AVX2 void real_compare(const double* a, const double* b, long long* dst, size_t n)
+      {
+         const auto one = _mm256_set1_epi64x(1);
+
+         for (size_t i = 0; i + 4 <= n; i += 4)
+         {
+            auto r = _mm256_cmp_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), predicate);
+            store(dst + i, _mm256_and_si256(_mm256_castpd_si256(r), one));
+         }
+      }
+
+      AVX2 void real_compare(TType op, const double* a, const double* b, long long* dst, size_t n)
+      {
+         switch (op)
+         {
+         case TType::equals_equals: real_compare<_CMP_EQ_OQ>(a, b, dst, n); break;
+         case TType::not_equals: real_compare<_CMP_NEQ_UQ>(a, b, dst, n); break;
+         case TType::smaller: real_compare<_CMP_LT_OQ>(a, b, dst, n); break;
+         case TType::smaller_equals: real_compare<_CMP_LE_OQ>(a, b, dst, n); break;
+         case TType::bigger: real_compare<_CMP_GT_OQ>(a, b, dst, n); break;
+         case TType::bigger_equals: real_compare<_CMP_GE_OQ>(a, b, dst, n); break;
+         default: break;
+         }
+
+         size_t i = n - n % 4;
+         scalar::compare(op, a + i, b + i, dst + i, n - i);
+      }
+
+      AVX2 bool real_binary(TType op, const double* a, const double* b, double* dst, size_t n)
+      {
+         if (op != TType::plus && op != TType::minus && op != TType::star && op != TType::slash)
+            return scalar::real_binary(op, a, b, dst, n);
+
+         const auto zero = _mm256_setzero_pd();
+         auto failed = zero;
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+         {
+            auto x = _mm256_loadu_pd(a + i), y = _mm256_loadu_pd(b + i), r = zero;
+
+            switch (op)
+            {
+            case TType::plus: r = _mm256_add_pd(x, y); break;
+            case TType::minus: r = _mm256_sub_pd(x, y); break;
+            case TType::star: r = _mm256_mul_pd(x, y); break;
+            default:
+               r = _mm256_div_pd(x, y);
+               failed = _mm256_or_pd(failed, _mm256_cmp_pd(y, zero, _CMP_EQ_OQ));
+               break;
+            }
+            _mm256_storeu_pd(dst + i, r);
+         }
+
+         bool tail = scalar::real_binary(op, a + i, b + i, dst + i, n - i);
+         return tail || _mm256_movemask_pd(failed) != 0;
+      }
+
+      AVX2 void truthy_int(const long long* a, long long* dst, size_t n)
+      {
+         const auto one = _mm256_set1_epi64x(1);
+         const auto zero = _mm256_setzero_si256();
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+            store(dst + i, _mm256_andnot_si256(_mm256_cmpeq_epi64(load(a + i), zero), one));
+         scalar::truthy_int(a + i, dst + i, n - i);
+      }
+
+      AVX2 void truthy_real(const double* a, long long* dst, size_t n)
+      {
+         const auto one = _mm256_set1_epi64x(1);
+         const auto zero = _mm256_setzero_pd();
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+            store(dst + i, _mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(a + i), zero, _CMP_NEQ_UQ)), one));
+         scalar::truthy_real(a + i, dst + i, n - i);
+      }
+
+      AVX2 void real_not(const double* a, long long* dst, size_t n)
+      {
+         const auto one = _mm256_set1_epi64x(1);
+         const auto zero = _mm256_setzero_pd();
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+            store(dst + i, _mm256_and_si256(_mm256_castpd_si256(_mm256_cmp_pd(_mm256_loadu_pd(a + i), zero, _CMP_EQ_OQ)), one));
+         scalar::real_not(a + i, dst + i, n - i);
+      }
+
+      AVX2 void real_negate(const double* a, double* dst, size_t n)
+      {
+         const auto sign = _mm256_set1_pd(-0.0);
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(dst + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+         scalar::real_negate(a + i, dst + i, n - i);
+      }
+
+      AVX2 void mask_and(const long long* mask, const long long* a, long long* dst, size_t n, bool negated)
+      {
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+         {
+            auto m = load(mask + i), x = load(a + i);
+            store(dst + i, negated ? _mm256_andnot_si256(x, m) : _mm256_and_si256(x, m));
+         }
+         scalar::mask_and(mask + i, a + i, dst + i, n - i, negated);
+      }
+
+      AVX2 void select_int(const long long* condition, const long long* a, const long long* b, long long* dst, size_t n)
+      {
+         const auto zero = _mm256_setzero_si256();
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+         {
+            auto skipped = _mm256_cmpeq_epi64(load(condition + i), zero);
+            store(dst + i, _mm256_blendv_epi8(load(a + i), load(b + i), skipped));
+         }
+         scalar::select(condition + i, a + i, b + i, dst + i, n - i);
+      }
+
+      AVX2 void select_real(const long long* condition, const double* a, const double* b, double* dst, size_t n)
+      {
+         const auto zero = _mm256_setzero_si256();
+         size_t i = 0;
+
+         for (; i + 4 <= n; i += 4)
+         {
+            auto skipped = _mm256_castsi256_pd(_mm256_cmpeq_epi64(load(condition + i), zero));
+            _mm256_storeu_pd(dst + i, _mm256_blendv_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), skipped));
+         }
+         scalar::select(condition + i, a + i, b + i, dst + i, n - i);
+      }
+
+      #undef AVX2
+   } // namespace avx2
+#endif
+
+   bool has_avx2()
+   {
+#ifdef COLUMNAR_AVX2
+      static const bool supported = __builtin_cpu_supports("avx2");
+      return supported;
+#else
+      return false;
+#endif
+   }
+} // namespace
+
+Column::Column(VType type, size_t size)
+   : type(type)
+{
+   if (type == VType::real)
+      this->reals.resize(size);
+   else
+      this->integers.resize(size);
+}
+
+size_t Column::size() const
+{
+   return (this->type == VType::real ? this->reals.size() : this->integers.size());
+}
+
+Value Column::at(size_t index) const
+{
+   switch (this->type)
+   {
+   case VType::integer: return this->integers[index];
+   case VType::real: return static_cast<real_t>(this->reals[index]);
+   case VType::boolean: return this->integers[index] != 0;
+   default: return std::monostate {};
+   }
+}
+
+ColumnarProgram::ColumnarProgram(Catcher& catcher, FlatView view, std::vector<Binding> inputs)
+   : catcher(catcher), view(view), input_bindings(std::move(inputs)) {}
+
+bool ColumnarProgram::vectorized()
+{
+   return has_avx2();
+}
+
+bool ColumnarProgram::compile()
+{
+   if (real_precision != Precision::double_real)
+   {
+      this->catcher.insert(err::columnar_long_real);
+      return false;
+   }
+
+   for (const auto& input : this->input_bindings)
+   {
+      if (!is_supported(input.type))
+         return unsupported();
+      this->slots.push_back(make(input.type));
+      this->slots.back().temporary = false;
+   }
+
+   for (auto index : this->view.statements)
+   {
+      if (!compile_stmt(index))
+         return false;
+   }
+   return true;
+}
+
+void ColumnarProgram::run(size_t records, const std::vector<Column>& inputs, std::vector<Column>& outputs, std::vector<const char*>& errors) const
+{
+   bool avx2 = has_avx2();
+
+   std::vector<long long> ints (this->int_registers * batch_size);
+   std::vector<double> reals (this->real_registers * batch_size);
+   auto int_register = [&](std::uint32_t reg) { return ints.data() + reg * batch_size; };
+   auto real_register = [&](std::uint32_t reg) { return reals.data() + reg * batch_size; };
+
+   outputs.clear();
+   for (const auto& output : this->output_bindings)
+      outputs.emplace_back(output.type, records);
+   errors.assign(records, nullptr);
+
+   for (const auto& [reg, value] : this->int_constants)
+      std::fill_n(int_register(reg), batch_size, value);
+   for (const auto& [reg, value] : this->real_constants)
+      std::fill_n(real_register(reg), batch_size, value);
+
+   for (size_t offset = 0; offset < records; offset += batch_size)
+   {
+      size_t n = std::min(batch_size, records - offset);
+      const char** failures = errors.data() + offset;
+
+      // A cancelled job fails the records that are left.
+      if (cancelled())
+      {
+         std::fill(errors.begin() + offset, errors.end(), err::job_cancelled);
+         return;
+      }
+
+      for (size_t i = 0; i < inputs.size(); ++i)
+      {
+         if (inputs[i].type == VType::real)
+            std::memcpy(real_register(this->slots[i].reg), inputs[i].reals.data() + offset, n * sizeof(double));
+         else
+            std::memcpy(int_register(this->slots[i].reg), inputs[i].integers.data() + offset, n * sizeof(long long));
+      }
+
+      for (const auto& ins : this->code)
+      {
+         bool failed = false;
+
+         switch (ins.kind)
+         {
+         case Kind::copy_int:
+            std::memcpy(int_register(ins.dst), int_register(ins.a), n * sizeof(long long));
+            break;
+         case Kind::copy_real:
+            std::memcpy(real_register(ins.dst), real_register(ins.a), n * sizeof(double));
+            break;
+         case Kind::int_to_real:
+            scalar::int_to_real(int_register(ins.a), real_register(ins.dst), n);
+            break;
+         case Kind::real_to_int:
+            failed = scalar::real_to_int(real_register(ins.a), int_register(ins.dst), n);
+            break;
+         case Kind::truthy_int:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::truthy_int(int_register(ins.a), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::truthy_int(int_register(ins.a), int_register(ins.dst), n);
+            break;
+         case Kind::truthy_real:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::truthy_real(real_register(ins.a), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::truthy_real(real_register(ins.a), int_register(ins.dst), n);
+            break;
+         case Kind::int_binary:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               failed = avx2::int_binary(ins.op, int_register(ins.a), int_register(ins.b), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            failed = scalar::int_binary(ins.op, int_register(ins.a), int_register(ins.b), int_register(ins.dst), n);
+            break;
+         case Kind::real_binary:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               failed = avx2::real_binary(ins.op, real_register(ins.a), real_register(ins.b), real_register(ins.dst), n);
+               break;
+            }
+#endif
+            failed = scalar::real_binary(ins.op, real_register(ins.a), real_register(ins.b), real_register(ins.dst), n);
+            break;
+         case Kind::real_compare:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::real_compare(ins.op, real_register(ins.a), real_register(ins.b), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::compare(ins.op, real_register(ins.a), real_register(ins.b), int_register(ins.dst), n);
+            break;
+         case Kind::int_unary:
+            failed = scalar::int_unary(ins.op, int_register(ins.a), int_register(ins.dst), n);
+            break;
+         case Kind::real_unary:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::real_negate(real_register(ins.a), real_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::real_negate(real_register(ins.a), real_register(ins.dst), n);
+            break;
+         case Kind::real_not:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::real_not(real_register(ins.a), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::real_not(real_register(ins.a), int_register(ins.dst), n);
+            break;
+         case Kind::mask_and:
+         case Kind::mask_and_not:
+         {
+            bool negated = (ins.kind == Kind::mask_and_not);
+
+            // Records outside of any ternary or '&&'/'||' are all evaluated.
+            if (ins.a == no_mask && !negated)
+            {
+               std::memcpy(int_register(ins.dst), int_register(ins.b), n * sizeof(long long));
+               break;
+            }
+            if (ins.a == no_mask)
+            {
+               scalar::int_unary(TType::logical_not, int_register(ins.b), int_register(ins.dst), n);
+               break;
+            }
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::mask_and(int_register(ins.a), int_register(ins.b), int_register(ins.dst), n, negated);
+               break;
+            }
+#endif
+            scalar::mask_and(int_register(ins.a), int_register(ins.b), int_register(ins.dst), n, negated);
+            break;
+         }
+         case Kind::select_int:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::select_int(int_register(ins.c), int_register(ins.a), int_register(ins.b), int_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::select(int_register(ins.c), int_register(ins.a), int_register(ins.b), int_register(ins.dst), n);
+            break;
+         case Kind::select_real:
+#ifdef COLUMNAR_AVX2
+            if (avx2)
+            {
+               avx2::select_real(int_register(ins.c), real_register(ins.a), real_register(ins.b), real_register(ins.dst), n);
+               break;
+            }
+#endif
+            scalar::select(int_register(ins.c), real_register(ins.a), real_register(ins.b), real_register(ins.dst), n);
+            break;
+         }
+
+         if (!failed)
+            continue;
+
+         // Find the records that failed with the scalar operations, only the first error
+         // of a record counts and only records the instruction is evaluated for.
+         const long long* mask = (ins.mask == no_mask ? nullptr : int_register(ins.mask));
+
+         for (size_t i = 0; i < n; ++i)
+         {
+            if (failures[i] || (mask && !mask[i]))
+               continue;
+
+            Value result;
+            switch (ins.kind)
+            {
+            case Kind::int_binary:
+               failures[i] = integer_operation(ins.op, int_register(ins.a)[i], int_register(ins.b)[i], result);
+               break;
+            case Kind::real_binary:
+               failures[i] = real_operation(ins.op, real_register(ins.a)[i], real_register(ins.b)[i], result);
+               break;
+            case Kind::int_unary:
+               failures[i] = unary_operation(ins.op, Value(int_register(ins.a)[i]), result);
+               break;
+            default:
+               result = static_cast<real_t>(real_register(ins.a)[i]);
+               failures[i] = ::convert(result, VType::integer);
+               break;
+            }
+         }
+      }
+
+      for (size_t i = 0; i < this->output_registers.size(); ++i)
+      {
+         const auto& reg = this->output_registers[i];
+
+         if (reg.type == VType::real)
+            std::memcpy(outputs[i].reals.data() + offset, real_register(reg.reg), n * sizeof(double));
+         else
+            std::memcpy(outputs[i].integers.data() + offset, int_register(reg.reg), n * sizeof(long long));
+      }
+   }
+}
+
+const std::vector<ColumnarProgram::Binding>& ColumnarProgram::inputs() const
+{
+   return this->input_bindings;
+}
+
+const std::vector<ColumnarProgram::Binding>& ColumnarProgram::outputs() const
+{
+   return this->output_bindings;
+}
+
+size_t ColumnarProgram::instruction_count() const
+{
+   return this->code.size();
+}
+
+bool ColumnarProgram::compile_stmt(std::uint32_t index)
+{
+   const auto& node = this->view.nodes[index];
+   Operand value;
+
+   switch (node.tag)
+   {
+   case StmtType::var_decl:
+   {
+      const auto& type = this->view.nodes[node.first];
+      const auto& identifier = this->view.nodes[node.children.third];
+      bool mut = (type.flags & flag::mut);
+
+      if (this->view.nodes[node.children.second].tag == StmtType::null)
+         return unsupported();
+
+      // 'let' takes the type of its initial value.
+      auto declared = (type.flags & flag::automatic ? VType::null : type_from_name(this->view.text(type)));
+
+      if (!compile_expr(node.children.second, no_mask, value, declared))
+         return false;
+
+      if (type.flags & flag::automatic)
+         declared = value.type;
+
+      if (!is_supported(declared))
+         return unsupported();
+
+      // A variable takes over the register of its value when nothing else can change
+      // it later, a 'mut' one only the register of a temporary.
+      Operand variable = convert(value, declared, no_mask);
+      if (mut ? !variable.temporary : variable.mutable_register)
+      {
+         auto copy = make(declared);
+         emit(declared == VType::real ? Kind::copy_real : Kind::copy_int, TType::eof, copy.reg, variable.reg, 0, 0, no_mask);
+         variable = copy;
+      }
+      variable.temporary = false;
+      variable.mutable_register = mut;
+
+      if (identifier.first >= this->slots.size())
+         this->slots.resize(identifier.first + 1, Operand {VType::null, 0, false, false});
+      this->slots[identifier.first] = variable;
+
+      this->output_bindings.push_back({std::string(this->view.text(identifier)), declared});
+      this->output_registers.push_back(variable);
+      return true;
+   }
+   case StmtType::assignment:
+   {
+      auto slot = this->view.nodes[node.first].first;
+      Operand result;
+
+      if (!compile_expr(node.children.second, no_mask, value, node.op == TType::equals ? this->slots[slot].type : VType::null))
+         return false;
+
+      if (node.op == TType::equals)
+         return compile_store(slot, value);
+
+      if (!binary(compound_operator(node.op), this->slots[slot], value, no_mask, result))
+         return false;
+      return compile_store(slot, result);
+   }
+   case StmtType::unary:
+   {
+      bool increment = (node.op == TType::plus_plus || node.op == TType::right_plus_plus);
+      bool decrement = (node.op == TType::minus_minus || node.op == TType::right_minus_minus);
+
+      if (!increment && !decrement)
+         break;
+
+      auto slot = this->view.nodes[node.first].first;
+      auto one = make(VType::integer);
+      one.temporary = false;
+      this->int_constants.push_back({one.reg, 1});
+
+      if (!binary(increment ? TType::plus : TType::minus, this->slots[slot], one, no_mask, value))
+         return false;
+      return compile_store(slot, value);
+   }
+   default:
+      break;
+   }
+
+   return compile_expr(index, no_mask, value);
+}
+
+bool ColumnarProgram::compile_expr(std::uint32_t index, std::uint32_t mask, Operand& result, VType target)
+{
+   const auto& node = this->view.nodes[index];
+
+   switch (node.tag)
+   {
+   case StmtType::integer:
+      result = make(VType::integer);
+      result.temporary = false;
+      this->int_constants.push_back({result.reg, node.integer});
+      return true;
+   case StmtType::real:
+      result = make(VType::real);
+      result.temporary = false;
+      this->real_constants.push_back({result.reg, static_cast<double>(this->view.reals[node.first])});
+      return true;
+   case StmtType::identifier:
+      if (node.first >= this->slots.size() || this->slots[node.first].type == VType::null)
+         return unsupported();
+      result = this->slots[node.first];
+      return true;
+   case StmtType::binary:
+      return compile_binary(node, mask, result);
+   case StmtType::unary:
+      return compile_unary(node, mask, result);
+   case StmtType::ternary:
+      return compile_ternary(node, mask, result, target);
+   default:
+      return unsupported();
+   }
+}
+
+bool ColumnarProgram::compile_binary(const FlatNode& node, std::uint32_t mask, Operand& result)
+{
+   if (node.op == TType::logical_and || node.op == TType::logical_or)
+      return compile_logical(node, mask, result);
+
+   Operand left, right;
+
+   if (!compile_expr(node.first, mask, left) || !compile_expr(node.children.second, mask, right))
+      return false;
+   return binary(node.op, left, right, mask, result);
+}
+
+bool ColumnarProgram::binary(TType op, const Operand& left, const Operand& right, std::uint32_t mask, Operand& result)
+{
+   // Bools are ints of 0 or 1, the operation is on reals when either side is one.
+   if (left.type != VType::real && right.type != VType::real)
+   {
+      result = make(VType::integer);
+      emit(Kind::int_binary, op, result.reg, left.reg, right.reg, 0, mask);
+      return true;
+   }
+
+   auto a = convert(left, VType::real, mask);
+   auto b = convert(right, VType::real, mask);
+
+   if (is_comparison(op))
+   {
+      result = make(VType::integer);
+      emit(Kind::real_compare, op, result.reg, a.reg, b.reg, 0, mask);
+      return true;
+   }
+
+   switch (op)
+   {
+   case TType::plus: case TType::minus: case TType::star:
+   case TType::slash: case TType::percent: case TType::star_star:
+      result = make(VType::real);
+      emit(Kind::real_binary, op, result.reg, a.reg, b.reg, 0, mask);
+      return true;
+   default:
+      this->catcher.insert(err::invalid_operands);
+      return false;
+   }
+}
+
+bool ColumnarProgram::compile_logical(const FlatNode& node, std::uint32_t mask, Operand& result)
+{
+   Operand left, right;
+
+   if (!compile_expr(node.first, mask, left))
+      return false;
+
+   // The right side only counts for the records it is evaluated for.
+   bool conjunction = (node.op == TType::logical_and);
+   auto tested = truthy(left, mask);
+   auto taken = make(VType::integer);
+   emit(conjunction ? Kind::mask_and : Kind::mask_and_not, TType::eof, taken.reg, mask, tested.reg, 0, mask);
+
+   if (!compile_expr(node.children.second, taken.reg, right))
+      return false;
+
+   result = make(VType::integer);
+   emit(Kind::int_binary, conjunction ? TType::bitwise_and : TType::bitwise_or, result.reg, tested.reg, truthy(right, taken.reg).reg, 0, mask);
+   return true;
+}
+
+bool ColumnarProgram::compile_unary(const FlatNode& node, std::uint32_t mask, Operand& result)
+{
+   Operand value;
+
+   // '++' and '--' change a variable, they are only supported as statements.
+   if (node.op != TType::plus && node.op != TType::minus && node.op != TType::logical_not && node.op != TType::bitwise_not)
+      return unsupported();
+
+   if (!compile_expr(node.first, mask, value))
+      return false;
+
+   if (value.type == VType::real)
+   {
+      switch (node.op)
+      {
+      case TType::plus:
+         result = value;
+         return true;
+      case TType::minus:
+         result = make(VType::real);
+         emit(Kind::real_unary, node.op, result.reg, value.reg, 0, 0, mask);
+         return true;
+      case TType::logical_not:
+         result = make(VType::integer);
+         emit(Kind::real_not, node.op, result.reg, value.reg, 0, 0, mask);
+         return true;
+      default:
+         this->catcher.insert(err::invalid_operands);
+         return false;
+      }
+   }
+
+   // '+' only turns a bool into an int, which is the same register.
+   if (node.op == TType::plus)
+   {
+      result = value;
+      result.type = VType::integer;
+      return true;
+   }
+
+   result = make(VType::integer);
+   emit(Kind::int_unary, node.op, result.reg, value.reg, 0, 0, mask);
+   return true;
+}
+
+bool ColumnarProgram::compile_ternary(const FlatNode& node, std::uint32_t mask, Operand& result, VType target)
+{
+   Operand condition, left, right;
+
+   if (!compile_expr(node.first, mask, condition))
+      return false;
+
+   auto tested = truthy(condition, mask);
+   auto taken = make(VType::integer);
+   auto skipped = make(VType::integer);
+   emit(Kind::mask_and, TType::eof, taken.reg, mask, tested.reg, 0, mask);
+   emit(Kind::mask_and_not, TType::eof, skipped.reg, mask, tested.reg, 0, mask);
+
+   if (!compile_expr(node.children.second, taken.reg, left, target) || !compile_expr(node.children.third, skipped.reg, right, target))
+      return false;
+
+   // Branches of different types give a value whose type is only known at run time,
+   // unless it is converted right away.
+   if (left.type != right.type)
+   {
+      if (target == VType::null)
+         return unsupported();
+      left = convert(left, target, taken.reg);
+      right = convert(right, target, skipped.reg);
+   }
+
+   result = make(left.type);
+   emit(left.type == VType::real ? Kind::select_real : Kind::select_int, TType::eof, result.reg, left.reg, right.reg, tested.reg, mask);
+   return true;
+}
+
+bool ColumnarProgram::compile_store(std::uint32_t slot, const Operand& value)
+{
+   const auto target = this->slots[slot];
+   auto converted = convert(value, target.type, no_mask);
+
+   if (converted.reg != target.reg)
+      emit(target.type == VType::real ? Kind::copy_real : Kind::copy_int, TType::eof, target.reg, converted.reg, 0, 0, no_mask);
+   return true;
+}
+
+ColumnarProgram::Operand ColumnarProgram::convert(const Operand& value, VType type, std::uint32_t mask)
+{
+   // Bools already are ints of 0 or 1.
+   if (value.type == type || (value.type == VType::boolean && type == VType::integer))
+      return {type, value.reg, value.temporary, value.mutable_register};
+
+   if (type == VType::boolean)
+   {
+      auto result = truthy(value, mask);
+      result.type = VType::boolean;
+      return result;
+   }
+
+   auto result = make(type);
+   if (type == VType::real)
+      emit(Kind::int_to_real, TType::eof, result.reg, value.reg, 0, 0, mask);
+   else
+      emit(Kind::real_to_int, TType::eof, result.reg, value.reg, 0, 0, mask);
+   return result;
+}
+
+ColumnarProgram::Operand ColumnarProgram::truthy(const Operand& value, std::uint32_t mask)
+{
+   if (value.type == VType::boolean)
+      return value;
+
+   auto result = make(VType::integer);
+   emit(value.type == VType::real ? Kind::truthy_real : Kind::truthy_int, TType::eof, result.reg, value.reg, 0, 0, mask);
+   return result;
+}
+
+ColumnarProgram::Operand ColumnarProgram::make(VType type)
+{
+   if (type == VType::real)
+      return {type, this->real_registers++, true, false};
+   return {type, this->int_registers++, true, false};
+}
+
+void ColumnarProgram::emit(Kind kind, TType op, std::uint32_t dst, std::uint32_t a, std::uint32_t b, std::uint32_t c, std::uint32_t mask)
+{
+   this->code.push_back({kind, op, dst, a, b, c, mask});
+}
+
+bool ColumnarProgram::unsupported()
+{
+   this->catcher.insert(err::columnar_unsupported);
+   return false;
+}
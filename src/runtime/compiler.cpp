@@ -0,0 +1,434 @@
+#include "runtime/compiler.hpp"
+#include "runtime/operations.hpp"
+#include "config/precision.hpp"
+#include <algorithm>
+
+Compiler::Compiler(FlatView view, Jit* jit)
+   : view(view), jit(jit) {}
+
+static bool is_increment(TType op)
+{
+   return op == TType::plus_plus || op == TType::right_plus_plus || op == TType::minus_minus || op == TType::right_minus_minus;
+}
+
+void Compiler::define(std::uint32_t slot, VType type)
+{
+   this->slots = std::max(this->slots, slot + 1);
+   this->types.resize(this->slots, VType::null);
+   this->dynamic.resize(this->slots, false);
+   this->initialized.resize(this->slots, false);
+
+   this->types[slot] = type;
+   this->initialized[slot] = true;
+}
+
+Chunk Compiler::compile()
+{
+   const auto& nodes = this->view.nodes;
+   this->effects.resize(nodes.size());
+   this->chunk.code.reserve(nodes.size());
+
+   // Children come before their parents, so one pass finds every subtree that writes a variable.
+   for (std::uint32_t i = 0; i < nodes.size(); ++i)
+   {
+      const auto& node = nodes[i];
+
+      switch (node.tag)
+      {
+      case StmtType::var_decl:
+      case StmtType::assignment:
+         this->effects[i] = true;
+         break;
+      case StmtType::ternary:
+         this->effects[i] = this->effects[node.first] || this->effects[node.children.second] || this->effects[node.children.third];
+         break;
+      case StmtType::binary:
+         this->effects[i] = this->effects[node.first] || this->effects[node.children.second];
+         break;
+      case StmtType::unary:
+         this->effects[i] = is_increment(node.op) || this->effects[node.first];
+         break;
+      case StmtType::identifier:
+         this->slots = std::max(this->slots, node.first + 1);
+         break;
+      default:
+         break;
+      }
+   }
+
+   this->types.resize(this->slots, VType::null);
+   this->dynamic.resize(this->slots, false);
+   this->initialized.resize(this->slots, false);
+   this->chunk.registers = this->slots;
+
+   size_t native = 0;
+   std::uint32_t end = 0;
+
+   for (std::uint32_t i = 0; i < this->view.statements.size(); ++i)
+   {
+      this->chunk.statements.push_back(static_cast<std::uint32_t>(this->chunk.code.size()));
+      this->next = this->slots;
+
+      std::uint32_t region = 0, count = 0;
+      if (this->jit && i >= end && (count = this->jit->compile(i, region)))
+      {
+         native = emit({OpCode::native, TType::eof, VType::null, region, 0, count});
+         end = i + count;
+      }
+
+      compile_expr(this->view.statements[i]);
+
+      if (this->jit && i + 1 == end)
+         patch(native);
+   }
+
+   emit({OpCode::halt});
+
+   if (this->jit)
+      this->jit->finalize();
+   return std::move(this->chunk);
+}
+
+Compiler::Operand Compiler::compile_expr(std::uint32_t index)
+{
+   const auto& node = this->view.nodes[index];
+
+   switch (node.tag)
+   {
+   case StmtType::var_decl:
+      return compile_var_decl(node);
+   case StmtType::assignment:
+      return compile_assignment(node);
+   case StmtType::ternary:
+      return compile_ternary(node);
+   case StmtType::binary:
+      if (node.op == TType::logical_and || node.op == TType::logical_or)
+         return compile_logical(node);
+      return compile_binary(node);
+   case StmtType::unary:
+      if (is_increment(node.op))
+         return compile_increment(node);
+      return compile_unary(node);
+   case StmtType::identifier:
+      return read(node.first);
+   case StmtType::integer:
+   {
+      auto dst = temporary();
+      auto bits = static_cast<std::uint64_t>(node.integer);
+      emit({OpCode::load_int, TType::eof, VType::null, dst, static_cast<std::uint32_t>(bits), static_cast<std::uint32_t>(bits >> 32)});
+      return {dst, VType::integer};
+   }
+   case StmtType::real:
+   {
+      auto dst = temporary();
+      emit({OpCode::load, TType::eof, VType::null, dst, constant(this->view.reals[node.first])});
+      return {dst, VType::real};
+   }
+   case StmtType::character:
+   {
+      auto dst = temporary();
+      emit({OpCode::load, TType::eof, VType::null, dst, constant(node.ch)});
+      return {dst, VType::character};
+   }
+   case StmtType::string:
+   {
+      auto dst = temporary();
+      emit({OpCode::load, TType::eof, VType::null, dst, constant(std::string(this->view.text(node)))});
+      return {dst, VType::string};
+   }
+   default:
+   {
+      auto dst = temporary();
+      emit({OpCode::load, TType::eof, VType::null, dst, constant(std::monostate {})});
+      return {dst, VType::null};
+   }
+   }
+}
+
+Compiler::Operand Compiler::compile_var_decl(const FlatNode& node)
+{
+   const auto& type = this->view.nodes[node.first];
+   const auto& identifier = this->view.nodes[node.children.third];
+   auto slot = identifier.first;
+
+   // 'mut int x;' leaves the register empty until something is assigned to it.
+   if (this->view.nodes[node.children.second].tag == StmtType::null)
+   {
+      this->chunk.variables.emplace_back(slot, this->view.text(identifier));
+      this->types[slot] = type_from_name(this->view.text(type));
+      return {slot, this->types[slot]};
+   }
+
+   auto base = this->next;
+   auto value = compile_expr(node.children.second);
+   this->next = base;
+   this->chunk.variables.emplace_back(slot, this->view.text(identifier));
+
+   if (type.flags & flag::automatic)
+   {
+      // 'let' takes the type of its initial value, which may only be known at run time.
+      this->types[slot] = value.type;
+      this->dynamic[slot] = (value.type == VType::null);
+      move(slot, value.reg);
+   }
+   else
+   {
+      this->types[slot] = type_from_name(this->view.text(type));
+      store(slot, value);
+   }
+
+   this->initialized[slot] = true;
+   return {slot, this->types[slot]};
+}
+
+Compiler::Operand Compiler::compile_assignment(const FlatNode& node)
+{
+   auto slot = this->view.nodes[node.first].first;
+   auto base = this->next;
+   auto value = compile_expr(node.children.second);
+
+   if (node.op != TType::equals)
+   {
+      auto target = read(slot);
+      this->next = base;
+      value = operation(compound_operator(node.op), temporary(), target, value);
+   }
+
+   this->next = base;
+   store(slot, value);
+
+   if (!this->conditional)
+      this->initialized[slot] = true;
+   return {slot, this->types[slot]};
+}
+
+Compiler::Operand Compiler::compile_ternary(const FlatNode& node)
+{
+   auto base = this->next;
+   auto condition = compile_expr(node.first);
+   auto to_right = emit({OpCode::jump_false, TType::eof, VType::null, condition.reg});
+
+   this->next = base;
+   auto dst = temporary();
+   ++this->conditional;
+
+   auto left = compile_expr(node.children.second);
+   move(dst, left.reg);
+   auto to_end = emit({OpCode::jump});
+
+   this->next = base + 1;
+   patch(to_right);
+   auto right = compile_expr(node.children.third);
+   move(dst, right.reg);
+   patch(to_end);
+
+   --this->conditional;
+   this->next = base + 1;
+   return {dst, (left.type == right.type ? left.type : VType::null)};
+}
+
+Compiler::Operand Compiler::compile_binary(const FlatNode& node)
+{
+   auto base = this->next;
+   auto left = compile_expr(node.first);
+
+   // The right side may change the variable before the operator reads it.
+   if (left.reg < this->slots && this->effects[node.children.second])
+   {
+      auto copy = temporary();
+      move(copy, left.reg);
+      left.reg = copy;
+   }
+
+   auto right = compile_expr(node.children.second);
+   this->next = base;
+   return operation(node.op, temporary(), left, right);
+}
+
+Compiler::Operand Compiler::compile_logical(const FlatNode& node)
+{
+   auto base = this->next;
+   auto left = compile_expr(node.first);
+   this->next = base;
+
+   auto dst = temporary();
+   emit({OpCode::truthy, TType::eof, VType::null, dst, left.reg});
+   auto to_end = emit({(node.op == TType::logical_and ? OpCode::jump_false : OpCode::jump_true), TType::eof, VType::null, dst});
+
+   ++this->conditional;
+   auto right = compile_expr(node.children.second);
+   emit({OpCode::truthy, TType::eof, VType::null, dst, right.reg});
+   --this->conditional;
+
+   patch(to_end);
+   this->next = base + 1;
+   return {dst, VType::integer};
+}
+
+Compiler::Operand Compiler::compile_unary(const FlatNode& node)
+{
+   auto base = this->next;
+   auto value = compile_expr(node.first);
+   this->next = base;
+   auto dst = temporary();
+
+   if (node.op == TType::minus && value.type == VType::integer)
+   {
+      emit({OpCode::neg_int, TType::eof, VType::null, dst, value.reg});
+      return {dst, VType::integer};
+   }
+
+   if (node.op == TType::minus && value.type == VType::real && real_precision == Precision::double_real)
+   {
+      emit({OpCode::neg_real, TType::eof, VType::null, dst, value.reg});
+      return {dst, VType::real};
+   }
+
+   emit({OpCode::unary, node.op, VType::null, dst, value.reg});
+
+   VType type = VType::null;
+   unary_type(node.op, value.type, type);
+   return {dst, type};
+}
+
+Compiler::Operand Compiler::compile_increment(const FlatNode& node)
+{
+   auto slot = this->view.nodes[node.first].first;
+   auto target = read(slot);
+   bool prefix = (node.op == TType::plus_plus || node.op == TType::minus_minus);
+   bool increment = (node.op == TType::plus_plus || node.op == TType::right_plus_plus);
+
+   // Suffix operators give the value from before the change.
+   Operand old = target;
+   if (!prefix)
+   {
+      old.reg = temporary();
+      move(old.reg, slot);
+   }
+
+   auto base = this->next;
+   auto one = temporary();
+   emit({OpCode::load_int, TType::eof, VType::null, one, 1});
+
+   this->next = base;
+   auto value = operation(increment ? TType::plus : TType::minus, temporary(), target, {one, VType::integer});
+   this->next = base;
+   store(slot, value);
+   return old;
+}
+
+Compiler::Operand Compiler::read(std::uint32_t slot)
+{
+   if (!this->initialized[slot])
+      emit({OpCode::check, TType::eof, VType::null, slot});
+   return {slot, this->types[slot]};
+}
+
+static OpCode typed_opcode(TType op, VType type)
+{
+   bool real = (type == VType::real);
+
+   switch (op)
+   {
+   case TType::plus: return (real ? OpCode::add_real : OpCode::add_int);
+   case TType::minus: return (real ? OpCode::sub_real : OpCode::sub_int);
+   case TType::star: return (real ? OpCode::mul_real : OpCode::mul_int);
+   case TType::slash: return (real ? OpCode::div_real : OpCode::div_int);
+   case TType::percent: return (real ? OpCode::binary : OpCode::mod_int);
+   case TType::equals_equals: return (real ? OpCode::eq_real : OpCode::eq_int);
+   case TType::not_equals: return (real ? OpCode::ne_real : OpCode::ne_int);
+   case TType::smaller: return (real ? OpCode::lt_real : OpCode::lt_int);
+   case TType::smaller_equals: return (real ? OpCode::le_real : OpCode::le_int);
+   case TType::bigger: return (real ? OpCode::gt_real : OpCode::gt_int);
+   case TType::bigger_equals: return (real ? OpCode::ge_real : OpCode::ge_int);
+   default: return OpCode::binary;
+   }
+}
+
+Compiler::Operand Compiler::operation(TType op, std::uint32_t dst, Operand a, Operand b)
+{
+   OpCode code = OpCode::binary;
+
+   // Long reals live in the heap, only the generic opcodes handle them.
+   if (a.type == b.type && (a.type == VType::integer || (a.type == VType::real && real_precision == Precision::double_real)))
+      code = typed_opcode(op, a.type);
+
+   emit({code, op, VType::null, dst, a.reg, b.reg});
+
+   VType type = VType::null;
+   binary_type(op, a.type, b.type, type);
+   return {dst, type};
+}
+
+void Compiler::store(std::uint32_t slot, Operand value)
+{
+   if (this->dynamic[slot])
+   {
+      emit({OpCode::store_dynamic, TType::eof, VType::null, slot, value.reg});
+      return;
+   }
+
+   move(slot, value.reg);
+
+   if (value.type != this->types[slot])
+      emit({OpCode::convert, TType::eof, this->types[slot], slot});
+}
+
+static bool writes_destination(OpCode op)
+{
+   switch (op)
+   {
+   case OpCode::halt: case OpCode::check: case OpCode::convert: case OpCode::store_dynamic:
+   case OpCode::jump: case OpCode::jump_false: case OpCode::jump_true: case OpCode::native:
+      return false;
+   default:
+      return true;
+   }
+}
+
+void Compiler::move(std::uint32_t dst, std::uint32_t src)
+{
+   if (dst == src)
+      return;
+
+   auto& code = this->chunk.code;
+
+   // Write the temporary computed by the previous instruction straight into dst.
+   if (src >= this->slots && code.size() > this->label && writes_destination(code.back().op) && code.back().a == src)
+   {
+      code.back().a = dst;
+      return;
+   }
+   emit({OpCode::move, TType::eof, VType::null, dst, src});
+}
+
+std::uint32_t Compiler::temporary()
+{
+   auto reg = this->next++;
+   this->chunk.registers = std::max(this->chunk.registers, this->next);
+   return reg;
+}
+
+std::uint32_t Compiler::constant(const Value& value)
+{
+   this->chunk.constants.push_back(value);
+   return static_cast<std::uint32_t>(this->chunk.constants.size() - 1);
+}
+
+size_t Compiler::emit(Instruction instruction)
+{
+   this->chunk.code.push_back(instruction);
+   return this->chunk.code.size() - 1;
+}
+
+void Compiler::patch(size_t jump)
+{
+   auto& ins = this->chunk.code[jump];
+   auto target = static_cast<std::uint32_t>(this->chunk.code.size());
+
+   if (ins.op == OpCode::jump)
+      ins.a = target;
+   else
+      ins.b = target;
+   this->label = target;
+}
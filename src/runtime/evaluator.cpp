@@ -0,0 +1,289 @@
+#include "runtime/evaluator.hpp"
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+#include "config/cancellation.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+Evaluator::Evaluator(Catcher& catcher, FlatView view, std::pmr::memory_resource* memory)
+   : catcher(catcher), view(view), slots(memory), types(memory), declarations(memory)
+{
+   std::uint32_t count = 0;
+
+   for (const auto& node : this->view.nodes)
+   {
+      if (node.tag == StmtType::identifier)
+         count = std::max(count, node.first + 1);
+      else if (node.tag == StmtType::var_decl)
+         this->declarations.push_back(node.children.third);
+   }
+
+   this->slots.resize(count);
+   this->types.resize(count, VType::null);
+}
+
+void Evaluator::define(std::uint32_t slot, Value value, VType type)
+{
+   // Inputs the program never reads have no slot.
+   if (slot >= this->slots.size())
+      return;
+
+   this->types[slot] = (type == VType::null ? type_of(value) : type);
+   this->slots[slot] = std::move(value);
+}
+
+size_t Evaluator::evaluate()
+{
+   return *resume(std::numeric_limits<size_t>::max());
+}
+
+std::optional<size_t> Evaluator::resume(size_t budget)
+{
+   Value result;
+
+   for (; !this->failed && this->next < this->view.statements.size(); ++this->next)
+   {
+      if (budget-- == 0)
+         return std::nullopt;
+
+      if (cancelled())
+         return interrupt(err::job_cancelled);
+
+      if (!eval(this->view.statements[this->next], result))
+      {
+         this->failed = true;
+         break;
+      }
+   }
+   return this->next;
+}
+
+size_t Evaluator::interrupt(const char* error)
+{
+   fail(error);
+   this->failed = true;
+   return this->next;
+}
+
+void Evaluator::specify_memory_limit(size_t bytes)
+{
+   this->memory_limit = bytes;
+}
+
+void Evaluator::print() const
+{
+   for (auto index : this->declarations)
+   {
+      const auto& node = this->view.nodes[index];
+      std::cout << "[" << this->view.text(node) << "] = " << to_string(this->slots[node.first]) << "\n";
+   }
+}
+
+std::vector<std::pair<std::string, Value>> Evaluator::variables() const
+{
+   std::vector<std::pair<std::string, Value>> variables;
+
+   for (auto index : this->declarations)
+   {
+      const auto& node = this->view.nodes[index];
+      variables.emplace_back(this->view.text(node), this->slots[node.first]);
+   }
+   return variables;
+}
+
+const Value* Evaluator::value(std::uint32_t slot) const
+{
+   return (slot < this->slots.size() ? &this->slots[slot] : nullptr);
+}
+
+bool Evaluator::eval(std::uint32_t index, Value& result)
+{
+   const auto& node = this->view.nodes[index];
+
+   switch (node.tag)
+   {
+   case StmtType::var_decl:
+      return eval_var_decl(node, result);
+   case StmtType::assignment:
+      return eval_assignment(node, result);
+   case StmtType::ternary:
+   {
+      bool condition = false;
+
+      if (!eval(node.first, result))
+         return false;
+
+      if (auto error = truthy(result, condition))
+         return fail(error);
+      return eval(condition ? node.children.second : node.children.third, result);
+   }
+   case StmtType::binary:
+   {
+      if (node.op == TType::logical_and || node.op == TType::logical_or)
+         return eval_logical(node, result);
+
+      Value left, right;
+
+      if (!eval(node.first, left) || !eval(node.children.second, right))
+         return false;
+
+      // The type checker proved both operand types, skip the dispatch on them.
+      const char* error = nullptr;
+      auto type = this->view.nodes[node.first].type;
+
+      if (type == this->view.nodes[node.children.second].type && type == VType::integer)
+         error = integer_operation(node.op, *std::get_if<long long>(&left), *std::get_if<long long>(&right), result);
+      else if (type == this->view.nodes[node.children.second].type && type == VType::real)
+         error = real_operation(node.op, *std::get_if<real_t>(&left), *std::get_if<real_t>(&right), result);
+      else
+         error = binary_operation(node.op, left, right, result);
+
+      if (error)
+         return fail(error);
+      return true;
+   }
+   case StmtType::unary:
+      return eval_unary(node, result);
+   case StmtType::identifier:
+      result = this->slots[node.first];
+
+      if (type_of(result) == VType::null)
+         return fail(err::uninitialized_variable);
+      return true;
+   case StmtType::null:
+      result = std::monostate {};
+      return true;
+   case StmtType::real:
+      result = this->view.reals[node.first];
+      return true;
+   case StmtType::integer:
+      result = node.integer;
+      return true;
+   case StmtType::string:
+      result = std::string(this->view.text(node));
+      return true;
+   case StmtType::character:
+      result = node.ch;
+      return true;
+   default:
+      return fail(err::invalid_operands);
+   }
+}
+
+bool Evaluator::eval_var_decl(const FlatNode& node, Value& result)
+{
+   const auto& type = this->view.nodes[node.first];
+   auto slot = this->view.nodes[node.children.third].first;
+
+   if (!eval(node.children.second, result))
+      return false;
+
+   // 'let' takes the type of its initial value.
+   this->types[slot] = (type.flags & flag::automatic ? type_of(result) : type_from_name(this->view.text(type)));
+   return store(slot, result, this->view.nodes[node.children.second].type);
+}
+
+bool Evaluator::eval_assignment(const FlatNode& node, Value& result)
+{
+   auto slot = this->view.nodes[node.first].first;
+   auto type = this->view.nodes[node.children.second].type;
+
+   if (!eval(node.children.second, result))
+      return false;
+
+   if (node.op != TType::equals)
+   {
+      type = VType::null;
+      Value right = std::move(result);
+
+      if (type_of(this->slots[slot]) == VType::null)
+         return fail(err::uninitialized_variable);
+
+      if (auto error = binary_operation(compound_operator(node.op), this->slots[slot], right, result))
+         return fail(error);
+   }
+   return store(slot, result, type);
+}
+
+bool Evaluator::eval_unary(const FlatNode& node, Value& result)
+{
+   bool increment = (node.op == TType::plus_plus || node.op == TType::right_plus_plus);
+   bool decrement = (node.op == TType::minus_minus || node.op == TType::right_minus_minus);
+
+   if (!eval(node.first, result))
+      return false;
+
+   if (!increment && !decrement)
+   {
+      Value value = std::move(result);
+
+      if (auto error = unary_operation(node.op, value, result))
+         return fail(error);
+      return true;
+   }
+
+   auto slot = this->view.nodes[node.first].first;
+   Value changed;
+
+   if (auto error = binary_operation(increment ? TType::plus : TType::minus, result, Value(1LL), changed))
+      return fail(error);
+
+   if (!store(slot, changed, VType::null))
+      return false;
+
+   // Prefix operators give the new value, suffix operators the old one.
+   if (node.op == TType::plus_plus || node.op == TType::minus_minus)
+      result = this->slots[slot];
+   return true;
+}
+
+bool Evaluator::eval_logical(const FlatNode& node, Value& result)
+{
+   bool value = false;
+
+   if (!eval(node.first, result))
+      return false;
+
+   if (auto error = truthy(result, value))
+      return fail(error);
+
+   if (value == (node.op == TType::logical_and))
+   {
+      if (!eval(node.children.second, result))
+         return false;
+
+      if (auto error = truthy(result, value))
+         return fail(error);
+   }
+
+   result = static_cast<long long>(value);
+   return true;
+}
+
+bool Evaluator::store(std::uint32_t slot, Value& value, VType type)
+{
+   // Values whose static type already matches the variable need no conversion.
+   if (type != this->types[slot] || type == VType::null)
+   {
+      if (auto error = convert(value, this->types[slot]))
+         return fail(error);
+   }
+
+   if (auto text = std::get_if<std::string>(&value))
+   {
+      this->allocated += text->size();
+
+      if (this->allocated > this->memory_limit)
+         return fail(err::memory_budget_exceeded);
+   }
+
+   this->slots[slot] = value;
+   return true;
+}
+
+bool Evaluator::fail(const char* error)
+{
+   this->catcher.insert(error);
+   return false;
+}
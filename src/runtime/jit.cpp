@@ -0,0 +1,1359 @@
+#include "runtime/jit.hpp"
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <tuple>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+namespace
+{
+   // Values the generated code returns in eax.
+   enum Status : int
+   { done, deoptimized, done_wide, division_by_zero, integer_overflow, invalid_shift };
+
+   enum Reg : std::uint8_t
+   { rax, rcx, rdx, rbx, rsp, rbp, rsi, rdi, r8, r9, r10, r11, r12, r13, r14, r15 };
+
+   // Xmm registers share the numbering, xmm0 to xmm2 are scratch registers.
+   constexpr std::uint8_t xmm0 = 0, xmm1 = 1, xmm2 = 2;
+
+   enum Cond : std::uint8_t
+   {
+      overflow = 0x0, below = 0x2, above_equal = 0x3, below_equal = 0x6, equal = 0x4, not_equal = 0x5, above = 0x7,
+      parity = 0xA, no_parity = 0xB, less = 0xC, greater_equal = 0xD, less_equal = 0xE, greater = 0xF
+   };
+
+   // Int variables go into registers the templates never touch, the registers passed in
+   // are rdi (virtual machine registers) and rsi (wide int spill slots).
+   constexpr std::array<Reg, 9> int_pool {rbx, r12, r13, r14, r15, r8, r9, r10, r11};
+   constexpr std::uint8_t real_pool_first = 3;
+   constexpr size_t real_pool_size = 13;
+
+   constexpr size_t cache_line = 64;
+   constexpr size_t prefetch_distance = 4096;
+
+   bool fits_int32(std::int64_t value)
+   {
+      return value >= std::numeric_limits<std::int32_t>::min() && value <= std::numeric_limits<std::int32_t>::max();
+   }
+
+   // Just enough of an x86-64 encoder for the templates. Jumps take a 32-bit displacement
+   // unless the template knows the target is close, they are patched when the region is
+   // done.
+   class Assembler
+   {
+   public:
+      explicit Assembler(std::vector<std::uint8_t>& code)
+         : code(code) {}
+
+      size_t label()
+      {
+         this->labels.push_back(0);
+         return this->labels.size() - 1;
+      }
+
+      void bind(size_t label) { this->labels[label] = this->code.size(); }
+      void jump(size_t label) { byte(0xE9); fixup(label, false); }
+      void jump_if(Cond cond, size_t label) { byte(0x0F); byte(0x80 | cond); fixup(label, false); }
+      void jump_short(size_t label) { byte(0xEB); fixup(label, true); }
+      void jump_if_short(Cond cond, size_t label) { byte(0x70 | cond); fixup(label, true); }
+
+      void resolve()
+      {
+         for (auto [at, label, short_jump] : this->fixups)
+         {
+            if (short_jump)
+            {
+               auto displacement = static_cast<std::int64_t>(this->labels[label]) - static_cast<std::int64_t>(at + 1);
+               this->code[at] = static_cast<std::uint8_t>(static_cast<std::int8_t>(displacement));
+               continue;
+            }
+
+            auto displacement = static_cast<std::int32_t>(this->labels[label] - (at + 4));
+            std::memcpy(this->code.data() + at, &displacement, 4);
+         }
+
+         this->labels.clear();
+         this->fixups.clear();
+      }
+
+      // 'op r/m64, r64' form of add (0x01), or (0x09), and (0x21), sub (0x29), xor (0x31),
+      // cmp (0x39), test (0x85) and mov (0x89).
+      void alu(std::uint8_t op, Reg dst, Reg src) { rex(true, src, dst); byte(op); modrm(3, src, dst); }
+      void mov(Reg dst, Reg src) { alu(0x89, dst, src); }
+      void test(Reg reg) { alu(0x85, reg, reg); }
+
+      void mov(Reg dst, std::uint64_t imm)
+      {
+         if (imm <= std::numeric_limits<std::uint32_t>::max())
+         {
+            rex(false, 0, dst);
+            byte(0xB8 | (dst & 7));
+            imm32(static_cast<std::uint32_t>(imm));
+            return;
+         }
+
+         // Small negative numbers are sign extended.
+         if (fits_int32(static_cast<std::int64_t>(imm)))
+         {
+            rex(true, 0, dst);
+            byte(0xC7);
+            modrm(3, 0, dst);
+            imm32(static_cast<std::uint32_t>(imm));
+            return;
+         }
+
+         rex(true, 0, dst);
+         byte(0xB8 | (dst & 7));
+         for (int i = 0; i < 8; ++i)
+            byte(static_cast<std::uint8_t>(imm >> (8 * i)));
+      }
+
+      void load(Reg dst, Reg base, std::int32_t disp) { rex(true, dst, base); byte(0x8B); memory(dst, base, disp); }
+      void store(Reg base, std::int32_t disp, Reg src) { rex(true, src, base); byte(0x89); memory(src, base, disp); }
+      void lea(Reg dst, Reg base, std::int32_t disp) { rex(true, dst, base); byte(0x8D); memory(dst, base, disp); }
+      void store(Reg base, std::int32_t disp, std::int32_t imm) { rex(true, 0, base); byte(0xC7); memory(0, base, disp); imm32(static_cast<std::uint32_t>(imm)); }
+
+      void imul(Reg dst, Reg src) { rex(true, dst, src); byte(0x0F); byte(0xAF); modrm(3, dst, src); }
+
+      void imul(Reg dst, Reg src, std::int32_t imm)
+      {
+         rex(true, dst, src);
+         byte(fits_int8(imm) ? 0x6B : 0x69);
+         modrm(3, dst, src);
+         immediate(imm);
+      }
+
+      // Group 3 with its /digit: not (2), neg (3), idiv (7).
+      void group3(std::uint8_t digit, Reg reg) { rex(true, 0, reg); byte(0xF7); modrm(3, digit, reg); }
+      void cqo() { byte(0x48); byte(0x99); }
+      // Shift group with its /digit: shl (4), shr (5), sar (7).
+      void shift_cl(std::uint8_t digit, Reg reg) { rex(true, 0, reg); byte(0xD3); modrm(3, digit, reg); }
+      void shift(std::uint8_t digit, Reg reg, std::uint8_t amount) { rex(true, 0, reg); byte(0xC1); modrm(3, digit, reg); byte(amount); }
+      // Immediate group with its /digit: add (0), or (1), and (4), sub (5), xor (6), cmp (7).
+      void arith(std::uint8_t digit, Reg reg, std::int32_t imm)
+      {
+         rex(true, 0, reg);
+         byte(fits_int8(imm) ? 0x83 : 0x81);
+         modrm(3, digit, reg);
+         immediate(imm);
+      }
+
+      void btc(Reg reg, std::uint8_t bit) { rex(true, 0, reg); byte(0x0F); byte(0xBA); modrm(3, 7, reg); byte(bit); }
+
+      // Byte operations only ever use al and cl.
+      void set(Cond cond, Reg reg) { byte(0x0F); byte(0x90 | cond); modrm(3, 0, reg); }
+      void and_byte(Reg dst, Reg src) { byte(0x20); modrm(3, src, dst); }
+      void or_byte(Reg dst, Reg src) { byte(0x08); modrm(3, src, dst); }
+      void zero_extend(Reg reg) { byte(0x0F); byte(0xB6); modrm(3, reg, reg); }
+
+      void quad(std::uint64_t value)
+      {
+         imm32(static_cast<std::uint32_t>(value));
+         imm32(static_cast<std::uint32_t>(value >> 32));
+      }
+
+      void align(size_t bytes)
+      {
+         while (this->code.size() % bytes != 0)
+            byte(0xCC);
+      }
+
+      void push(Reg reg) { rex(false, 0, reg); byte(0x50 | (reg & 7)); }
+      void push_zero() { byte(0x6A); byte(0); }
+
+      // prefetcht0 of the code at the given offset.
+      void prefetch(size_t target)
+      {
+         byte(0x0F);
+         byte(0x18);
+         modrm(0, 1, rbp);
+         imm32(static_cast<std::uint32_t>(target - (this->code.size() + 4)));
+      }
+
+      size_t size() const { return this->code.size(); }
+      void pop(Reg reg) { rex(false, 0, reg); byte(0x58 | (reg & 7)); }
+      void ret() { byte(0xC3); }
+
+      void addsd(std::uint8_t dst, std::uint8_t src) { sse(0xF2, 0x58, dst, src); }
+      void mulsd(std::uint8_t dst, std::uint8_t src) { sse(0xF2, 0x59, dst, src); }
+      void subsd(std::uint8_t dst, std::uint8_t src) { sse(0xF2, 0x5C, dst, src); }
+      void divsd(std::uint8_t dst, std::uint8_t src) { sse(0xF2, 0x5E, dst, src); }
+      void movapd(std::uint8_t dst, std::uint8_t src) { if (dst != src) sse(0x66, 0x28, dst, src); }
+      void ucomisd(std::uint8_t a, std::uint8_t b) { sse(0x66, 0x2E, a, b); }
+      void xorpd(std::uint8_t dst, std::uint8_t src) { sse(0x66, 0x57, dst, src); }
+      void cvtsi2sd(std::uint8_t dst, Reg src) { sse(0xF2, 0x2A, dst, src, true); }
+      void cvttsd2si(Reg dst, std::uint8_t src) { sse(0xF2, 0x2C, dst, src, true); }
+      void movq(std::uint8_t dst, Reg src) { sse(0x66, 0x6E, dst, src, true); }
+      void movq(Reg dst, std::uint8_t src) { sse(0x66, 0x7E, src, dst, true); }
+
+      // movsd from a constant placed after the code of the region.
+      void load_real(std::uint8_t dst, size_t label) { byte(0xF2); rex(false, dst, 0); byte(0x0F); byte(0x10); modrm(0, dst, rbp); fixup(label, false); }
+      void load_real(std::uint8_t dst, Reg base, std::int32_t disp) { byte(0xF2); rex(false, dst, base); byte(0x0F); byte(0x10); memory(dst, base, disp); }
+      void store_real(Reg base, std::int32_t disp, std::uint8_t src) { byte(0xF2); rex(false, src, base); byte(0x0F); byte(0x11); memory(src, base, disp); }
+
+   private:
+      std::vector<std::uint8_t>& code;
+      std::vector<size_t> labels;
+      std::vector<std::tuple<size_t, size_t, bool>> fixups;
+
+      void byte(std::uint8_t value) { this->code.push_back(value); }
+
+      static bool fits_int8(std::int64_t value) { return value >= -128 && value <= 127; }
+
+      void imm32(std::uint32_t value)
+      {
+         for (int i = 0; i < 4; ++i)
+            byte(static_cast<std::uint8_t>(value >> (8 * i)));
+      }
+
+      void immediate(std::int32_t value)
+      {
+         if (fits_int8(value))
+            byte(static_cast<std::uint8_t>(value));
+         else
+            imm32(static_cast<std::uint32_t>(value));
+      }
+
+      void fixup(size_t label, bool short_jump)
+      {
+         this->fixups.emplace_back(this->code.size(), label, short_jump);
+         if (short_jump)
+            byte(0);
+         else
+            imm32(0);
+      }
+
+      void rex(bool wide, std::uint8_t reg, std::uint8_t rm)
+      {
+         std::uint8_t prefix = 0x40 | (wide ? 8 : 0) | ((reg >> 3) << 2) | (rm >> 3);
+         if (prefix != 0x40)
+            byte(prefix);
+      }
+
+      void modrm(std::uint8_t mod, std::uint8_t reg, std::uint8_t rm) { byte(static_cast<std::uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7))); }
+
+      void memory(std::uint8_t reg, Reg base, std::int32_t disp)
+      {
+         modrm(fits_int8(disp) ? 1 : 2, reg, base);
+         if ((base & 7) == rsp)
+            byte(0x24);
+         immediate(disp);
+      }
+
+      void sse(std::uint8_t prefix, std::uint8_t op, std::uint8_t reg, std::uint8_t rm, bool wide = false)
+      {
+         byte(prefix);
+         rex(wide, reg, rm);
+         byte(0x0F);
+         byte(op);
+         modrm(3, reg, rm);
+      }
+   };
+
+   bool is_increment(TType op)
+   {
+      return op == TType::plus_plus || op == TType::right_plus_plus || op == TType::minus_minus || op == TType::right_minus_minus;
+   }
+
+   bool is_shift(TType op)
+   {
+      return op == TType::shift_left || op == TType::shift_right;
+   }
+
+   bool is_comparison(TType op)
+   {
+      return op == TType::equals_equals || op == TType::not_equals || op == TType::smaller ||
+             op == TType::smaller_equals || op == TType::bigger || op == TType::bigger_equals;
+   }
+
+   bool is_number(VType type)
+   {
+      return type == VType::integer || type == VType::real;
+   }
+
+   // Operators with a template for the given operand types.
+   bool has_template(TType op, VType a, VType b)
+   {
+      bool real = (a == VType::real || b == VType::real);
+
+      switch (op)
+      {
+      case TType::plus: case TType::minus: case TType::star: case TType::slash:
+      case TType::equals_equals: case TType::not_equals:
+      case TType::smaller: case TType::smaller_equals:
+      case TType::bigger: case TType::bigger_equals:
+         return true;
+      case TType::percent:
+      case TType::shift_left: case TType::shift_right:
+      case TType::bitwise_and: case TType::bitwise_or: case TType::bitwise_xor:
+         return !real;
+      default:
+         return false;
+      }
+   }
+
+   // Compiles one region: a scan picks the statements and the variables they use, then
+   // the templates are emitted. Ints are computed in rax (rcx holds the right operand),
+   // reals in xmm0 (xmm1 holds the right operand), partial results go on the stack.
+   class RegionCompiler
+   {
+   public:
+      RegionCompiler(FlatView view, std::vector<std::uint8_t>& code)
+         : view(view), as(code) {}
+
+      std::uint32_t compile(std::uint32_t first, std::vector<std::uint32_t>& ints)
+      {
+         std::uint32_t count = 0;
+
+         for (auto i = first; i < this->view.statements.size(); ++i, ++count)
+         {
+            auto locals = this->locals;
+
+            if (!scan(this->view.statements[i], false) || !allocate())
+            {
+               this->locals = std::move(locals);
+               break;
+            }
+         }
+
+         if (count == 0)
+            return 0;
+
+         this->deopt = this->as.label();
+         this->exit = this->as.label();
+         for (auto& label : this->errors)
+            label = this->as.label();
+
+         prologue();
+         this->prefetched = this->as.size() / cache_line;
+         for (auto i = first; i < first + count; ++i)
+         {
+            prefetch();
+            gen(this->view.statements[i]);
+         }
+         epilogue(ints);
+         this->as.resolve();
+         return count;
+      }
+
+   private:
+      struct Local
+      {
+         std::uint32_t slot;
+         VType type;
+         std::uint8_t reg = 0;
+         // Read, or maybe written, before the region certainly wrote it, so it has to
+         // hold a value of its type when the region is entered.
+         bool entry = false;
+         bool written = false;
+         bool definite = false;
+      };
+
+      FlatView view;
+      Assembler as;
+      std::vector<Local> locals;
+      size_t deopt = 0;
+      size_t exit = 0;
+      // Division by zero, integer overflow and invalid shift.
+      std::array<size_t, 3> errors {};
+      // Real constants and their labels.
+      std::vector<std::pair<std::uint64_t, size_t>> constants;
+      // Cache lines of code that have a prefetch ahead of them.
+      size_t prefetched = 0;
+
+      const FlatNode& node(std::uint32_t index) const { return this->view.nodes[index]; }
+      VType type(std::uint32_t index) const { return this->view.nodes[index].type; }
+      size_t error(Status status) const { return this->errors[status - division_by_zero]; }
+
+      // Every statement runs once, so the code is never in the instruction cache when it
+      // is reached and fetching it from memory is the bulk of the time. A prefetch for
+      // each cache line the last statement covered keeps the next few pages coming.
+      void prefetch()
+      {
+         for (; this->prefetched < this->as.size() / cache_line; ++this->prefetched)
+            this->as.prefetch(this->prefetched * cache_line + prefetch_distance);
+      }
+
+      void load_constant(std::uint8_t dst, double value)
+      {
+         auto bits = std::bit_cast<std::uint64_t>(value);
+         auto found = std::find_if(this->constants.begin(), this->constants.end(), [bits](const auto& constant) { return constant.first == bits; });
+
+         if (found == this->constants.end())
+            found = this->constants.insert(found, {bits, this->as.label()});
+         this->as.load_real(dst, found->second);
+      }
+
+      Local& local(std::uint32_t slot)
+      {
+         for (auto& local : this->locals)
+         {
+            if (local.slot == slot)
+               return local;
+         }
+         return this->locals.emplace_back(Local {slot, VType::null});
+      }
+
+      bool use(const FlatNode& identifier, bool write, bool conditional)
+      {
+         if (!is_number(identifier.type))
+            return false;
+
+         auto& local = this->local(identifier.first);
+         local.type = identifier.type;
+
+         if (!write || conditional)
+            local.entry = local.entry || !local.definite;
+
+         if (write)
+         {
+            local.written = true;
+            local.definite = local.definite || !conditional;
+         }
+         return true;
+      }
+
+      bool allocate()
+      {
+         size_t ints = 0, reals = 0;
+
+         for (auto& local : this->locals)
+         {
+            if (local.type == VType::integer)
+               local.reg = (ints < int_pool.size() ? int_pool[ints] : 0), ++ints;
+            else
+               local.reg = static_cast<std::uint8_t>(real_pool_first + reals++);
+         }
+         return ints <= int_pool.size() && reals <= real_pool_size;
+      }
+
+      // Follows the evaluation order of the virtual machine, conditional is set inside
+      // the branches of ternaries and the right side of '&&' and '||'.
+      bool scan(std::uint32_t index, bool conditional)
+      {
+         const auto& n = node(index);
+
+         switch (n.tag)
+         {
+         case StmtType::integer:
+         case StmtType::real:
+            return true;
+         case StmtType::identifier:
+            return use(n, false, conditional);
+         case StmtType::binary:
+         {
+            auto left = type(n.first), right = type(n.children.second);
+
+            if (!is_number(left) || !is_number(right))
+               return false;
+
+            if (n.op == TType::logical_and || n.op == TType::logical_or)
+               return scan(n.first, conditional) && scan(n.children.second, true);
+            return has_template(n.op, left, right) && scan(n.first, conditional) && scan(n.children.second, conditional);
+         }
+         case StmtType::unary:
+            if (is_increment(n.op))
+               return use(node(n.first), false, conditional) && use(node(n.first), true, conditional);
+
+            if (!is_number(type(n.first)) || !(n.op == TType::plus || n.op == TType::minus || n.op == TType::logical_not || n.op == TType::bitwise_not))
+               return false;
+            return scan(n.first, conditional);
+         case StmtType::ternary:
+            if (!is_number(type(n.first)) || !is_number(n.type) || type(n.children.second) != n.type || type(n.children.third) != n.type)
+               return false;
+            return scan(n.first, conditional) && scan(n.children.second, true) && scan(n.children.third, true);
+         case StmtType::assignment:
+         {
+            const auto& target = node(n.first);
+            auto value = type(n.children.second);
+
+            if (!is_number(target.type) || !is_number(value))
+               return false;
+
+            if (n.op != TType::equals && !has_template(compound_operator(n.op), target.type, value))
+               return false;
+
+            if (!scan(n.children.second, conditional))
+               return false;
+            return (n.op == TType::equals || use(target, false, conditional)) && use(target, true, conditional);
+         }
+         case StmtType::var_decl:
+         {
+            const auto& body = node(n.children.second);
+
+            // 'mut int x;' leaves the variable empty.
+            if (body.tag == StmtType::null)
+               return is_number(node(n.children.third).type);
+
+            if (!is_number(body.type) || !scan(n.children.second, conditional))
+               return false;
+            return use(node(n.children.third), true, conditional);
+         }
+         default:
+            return false;
+         }
+      }
+
+      template <typename Predicate>
+      bool any(Predicate predicate) const
+      {
+         return std::any_of(this->locals.begin(), this->locals.end(), predicate);
+      }
+
+      // The status of a finished region is kept below the saved registers.
+      static constexpr std::int32_t status_slot = -6 * 8;
+
+      void prologue()
+      {
+         this->as.push(rbp);
+         this->as.mov(rbp, rsp);
+         for (auto reg : {rbx, r12, r13, r14, r15})
+            this->as.push(reg);
+         this->as.push_zero();
+
+         // Loaded variables are checked before anything changes, so the bytecode can
+         // still take over.
+         if (any([](const Local& local) { return local.entry && local.type == VType::real; }))
+            this->as.mov(rdx, Box::null_tag << 48);
+
+         for (const auto& local : this->locals)
+         {
+            if (!local.entry)
+               continue;
+
+            auto disp = static_cast<std::int32_t>(local.slot * sizeof(Box));
+
+            if (local.type == VType::integer)
+            {
+               auto reg = static_cast<Reg>(local.reg);
+               this->as.load(reg, rdi, disp);
+               this->as.mov(rax, reg);
+               this->as.shift(5, rax, 48);
+               this->as.arith(7, rax, static_cast<std::int32_t>(Box::int_tag));
+               this->as.jump_if(not_equal, this->deopt);
+               this->as.shift(4, reg, 16);
+               this->as.shift(7, reg, 16);
+            }
+            else
+            {
+               this->as.load(rax, rdi, disp);
+               this->as.alu(0x39, rax, rdx);
+               this->as.jump_if(above_equal, this->deopt);
+               this->as.movq(local.reg, rax);
+            }
+         }
+      }
+
+      void epilogue(std::vector<std::uint32_t>& ints)
+      {
+         // Ints outside the inline range and NaNs other than the canonical one are rare,
+         // they are written back out of line.
+         struct Cold
+         {
+            size_t label;
+            size_t back;
+            const Local* local;
+            std::int32_t spill;
+         };
+         std::vector<Cold> cold;
+
+         if (any([](const Local& local) { return local.written && local.type == VType::integer; }))
+            this->as.mov(rdx, Box::int_tag << 48);
+
+         for (const auto& local : this->locals)
+         {
+            if (!local.written)
+               continue;
+
+            auto disp = static_cast<std::int32_t>(local.slot * sizeof(Box));
+            auto& path = cold.emplace_back(Cold {this->as.label(), this->as.label(), &local, 0});
+
+            if (local.type == VType::integer)
+            {
+               auto reg = static_cast<Reg>(local.reg);
+
+               path.spill = static_cast<std::int32_t>(ints.size() * sizeof(long long));
+               ints.push_back(local.slot);
+
+               this->as.mov(rcx, reg);
+               this->as.shift(4, rcx, 16);
+               this->as.mov(rax, rcx);
+               this->as.shift(7, rax, 16);
+               this->as.alu(0x39, rax, reg);
+               this->as.jump_if(not_equal, path.label);
+               this->as.shift(5, rcx, 16);
+               this->as.alu(0x09, rcx, rdx);
+               this->as.store(rdi, disp, rcx);
+            }
+            else
+            {
+               this->as.movq(rcx, local.reg);
+               this->as.ucomisd(local.reg, local.reg);
+               this->as.jump_if(parity, path.label);
+               this->as.store(rdi, disp, rcx);
+            }
+            this->as.bind(path.back);
+         }
+
+         this->as.load(rax, rbp, status_slot);
+
+         this->as.bind(this->exit);
+         this->as.lea(rsp, rbp, -5 * 8);
+         for (auto reg : {r15, r14, r13, r12, rbx})
+            this->as.pop(reg);
+         this->as.pop(rbp);
+         this->as.ret();
+
+         // Wide ints are spilled and marked with null, Jit::run puts them in the heap.
+         for (const auto& path : cold)
+         {
+            auto disp = static_cast<std::int32_t>(path.local->slot * sizeof(Box));
+
+            this->as.bind(path.label);
+            if (path.local->type == VType::integer)
+            {
+               this->as.store(rsi, path.spill, static_cast<Reg>(path.local->reg));
+               this->as.mov(rcx, Box::null_tag << 48);
+               this->as.store(rbp, status_slot, std::int32_t {done_wide});
+            }
+            else
+               this->as.mov(rcx, Box::canonical_nan);
+            this->as.store(rdi, disp, rcx);
+            this->as.jump(path.back);
+         }
+
+         this->as.bind(this->deopt);
+         this->as.mov(rax, std::uint64_t {deoptimized});
+         this->as.jump(this->exit);
+
+         for (auto status : {division_by_zero, integer_overflow, invalid_shift})
+         {
+            this->as.bind(error(status));
+            this->as.mov(rax, static_cast<std::uint64_t>(status));
+            this->as.jump(this->exit);
+         }
+
+         this->as.align(sizeof(double));
+         for (auto [bits, label] : this->constants)
+         {
+            this->as.bind(label);
+            this->as.quad(bits);
+         }
+      }
+
+      bool is_leaf(std::uint32_t index) const
+      {
+         auto tag = node(index).tag;
+         return tag == StmtType::identifier || tag == StmtType::integer || tag == StmtType::real;
+      }
+
+      // Puts a leaf into rcx, or into xmm1 when the operation is done in reals, and returns
+      // where it is. Variables of the right type are used where they are.
+      std::uint8_t operand(std::uint32_t index, bool real, bool in_place)
+      {
+         const auto& n = node(index);
+
+         if (n.tag == StmtType::identifier)
+         {
+            auto reg = local(n.first).reg;
+
+            if (n.type == VType::real || !real)
+            {
+               if (in_place)
+                  return reg;
+               if (!real)
+               {
+                  this->as.mov(rcx, static_cast<Reg>(reg));
+                  return rcx;
+               }
+               this->as.movapd(xmm1, reg);
+               return xmm1;
+            }
+
+            this->as.cvtsi2sd(xmm1, static_cast<Reg>(reg));
+            return xmm1;
+         }
+
+         if (!real)
+         {
+            this->as.mov(rcx, static_cast<std::uint64_t>(n.integer));
+            return rcx;
+         }
+
+         load_constant(xmm1, n.tag == StmtType::real ? static_cast<double>(this->view.reals[n.first]) : static_cast<double>(n.integer));
+         return xmm1;
+      }
+
+      // Puts the left operand of a binary operation in rax or xmm0 and returns where the
+      // right one is, like operand.
+      std::uint8_t operands(const FlatNode& n, bool real, bool in_place)
+      {
+         auto left = type(n.first), right = type(n.children.second);
+         bool constant = (real && node(n.first).tag == StmtType::integer);
+
+         if (constant)
+            load_constant(xmm0, static_cast<double>(node(n.first).integer));
+         else
+         {
+            gen(n.first);
+            if (real && left == VType::integer && is_leaf(n.children.second))
+               this->as.cvtsi2sd(xmm0, rax);
+         }
+
+         if (is_leaf(n.children.second))
+            return operand(n.children.second, real, in_place);
+
+         bool integer = (left == VType::integer && !constant);
+
+         if (integer)
+            this->as.push(rax);
+         else
+         {
+            this->as.arith(5, rsp, 8);
+            this->as.store_real(rsp, 0, xmm0);
+         }
+
+         gen(n.children.second);
+
+         if (!real)
+         {
+            this->as.mov(rcx, rax);
+            this->as.pop(rax);
+            return rcx;
+         }
+
+         if (right == VType::integer)
+            this->as.cvtsi2sd(xmm1, rax);
+         else
+            this->as.movapd(xmm1, xmm0);
+
+         if (integer)
+         {
+            this->as.pop(rax);
+            this->as.cvtsi2sd(xmm0, rax);
+         }
+         else
+         {
+            this->as.load_real(xmm0, rsp, 0);
+            this->as.arith(0, rsp, 8);
+         }
+         return xmm1;
+      }
+
+      // The left operand is in rax, the right one is a leaf.
+      void leaf_operation(TType op, std::uint32_t right)
+      {
+         const auto& n = node(right);
+
+         if (n.tag == StmtType::integer && constant_operation(op, n.integer))
+            return;
+         integer_operation(op, static_cast<Reg>(operand(right, false, !is_shift(op))));
+      }
+
+      void gen(std::uint32_t index)
+      {
+         const auto& n = node(index);
+
+         switch (n.tag)
+         {
+         case StmtType::integer:
+            this->as.mov(rax, static_cast<std::uint64_t>(n.integer));
+            break;
+         case StmtType::real:
+            load_constant(xmm0, static_cast<double>(this->view.reals[n.first]));
+            break;
+         case StmtType::identifier:
+            if (n.type == VType::integer)
+               this->as.mov(rax, static_cast<Reg>(local(n.first).reg));
+            else
+               this->as.movapd(xmm0, local(n.first).reg);
+            break;
+         case StmtType::binary:
+            if (n.op == TType::logical_and || n.op == TType::logical_or)
+               gen_logical(n);
+            else
+               gen_binary(n);
+            break;
+         case StmtType::unary:
+            if (is_increment(n.op))
+               gen_increment(n);
+            else
+               gen_unary(n);
+            break;
+         case StmtType::ternary:
+         {
+            auto right = this->as.label(), end = this->as.label();
+
+            this->as.jump_if(gen_condition(n.first), right);
+            gen(n.children.second);
+            this->as.jump(end);
+            this->as.bind(right);
+            gen(n.children.third);
+            this->as.bind(end);
+            break;
+         }
+         case StmtType::assignment:
+            gen_assignment(n);
+            break;
+         case StmtType::var_decl:
+            if (node(n.children.second).tag != StmtType::null)
+            {
+               gen(n.children.second);
+               store(local(node(n.children.third).first), type(n.children.second));
+            }
+            break;
+         default:
+            break;
+         }
+      }
+
+      // Returns the condition that holds when the value is false, comparisons set the
+      // flags without making a bool first. NaN is true, like everywhere else.
+      Cond gen_condition(std::uint32_t index)
+      {
+         const auto& n = node(index);
+
+         if (n.tag == StmtType::binary && is_comparison(n.op))
+         {
+            bool real = (type(n.first) == VType::real || type(n.children.second) == VType::real);
+            const auto& right = node(n.children.second);
+
+            if (!real)
+            {
+               if (right.tag == StmtType::integer && fits_int32(right.integer))
+               {
+                  gen(n.first);
+                  this->as.arith(7, rax, static_cast<std::int32_t>(right.integer));
+               }
+               else
+                  this->as.alu(0x39, rax, static_cast<Reg>(operands(n, false, true)));
+               return static_cast<Cond>(comparison(n.op) ^ 1);
+            }
+
+            // Unordered operands set the carry flag, so they fail every ordering.
+            if (n.op != TType::equals_equals && n.op != TType::not_equals)
+            {
+               auto src = operands(n, true, true);
+               bool smaller = (n.op == TType::smaller || n.op == TType::smaller_equals);
+               bool strict = (n.op == TType::smaller || n.op == TType::bigger);
+
+               if (smaller)
+                  this->as.ucomisd(src, xmm0);
+               else
+                  this->as.ucomisd(xmm0, src);
+               return (strict ? below_equal : below);
+            }
+         }
+
+         gen(index);
+
+         if (type(index) == VType::integer)
+         {
+            this->as.test(rax);
+            return equal;
+         }
+
+         this->as.xorpd(xmm1, xmm1);
+         this->as.ucomisd(xmm0, xmm1);
+         this->as.set(not_equal, rax);
+         this->as.set(parity, rcx);
+         this->as.or_byte(rax, rcx);
+         return equal;
+      }
+
+      void gen_binary(const FlatNode& n)
+      {
+         bool real = (type(n.first) == VType::real || type(n.children.second) == VType::real);
+
+         if (!real && node(n.children.second).tag == StmtType::integer)
+         {
+            gen(n.first);
+            leaf_operation(n.op, n.children.second);
+         }
+         else if (real)
+            real_operation(n.op, operands(n, true, true));
+         else
+            integer_operation(n.op, static_cast<Reg>(operands(n, false, !is_shift(n.op))));
+      }
+
+      static Cond comparison(TType op)
+      {
+         return op == TType::equals_equals ? equal : op == TType::not_equals ? not_equal :
+                op == TType::smaller ? less : op == TType::smaller_equals ? less_equal :
+                op == TType::bigger ? greater : greater_equal;
+      }
+
+      // rax = rax op src, with the checks of integer_operation. Shifts need the amount
+      // in rcx.
+      void integer_operation(TType op, Reg src)
+      {
+         switch (op)
+         {
+         case TType::plus:
+            this->as.alu(0x01, rax, src);
+            this->as.jump_if(overflow, error(integer_overflow));
+            break;
+         case TType::minus:
+            this->as.alu(0x29, rax, src);
+            this->as.jump_if(overflow, error(integer_overflow));
+            break;
+         case TType::star:
+            this->as.imul(rax, src);
+            this->as.jump_if(overflow, error(integer_overflow));
+            break;
+         case TType::slash:
+         case TType::percent:
+         {
+            auto divide = this->as.label(), end = this->as.label();
+
+            this->as.test(src);
+            this->as.jump_if(equal, error(division_by_zero));
+            this->as.arith(7, src, -1);
+            this->as.jump_if_short(not_equal, divide);
+
+            // Dividing by -1 negates, which only overflows for the smallest int. The
+            // remainder is always 0.
+            if (op == TType::slash)
+            {
+               this->as.group3(3, rax);
+               this->as.jump_if(overflow, error(integer_overflow));
+            }
+            else
+               this->as.mov(rax, std::uint64_t {0});
+            this->as.jump_short(end);
+
+            this->as.bind(divide);
+            this->as.cqo();
+            this->as.group3(7, src);
+            if (op == TType::percent)
+               this->as.mov(rax, rdx);
+            this->as.bind(end);
+            break;
+         }
+         case TType::shift_left:
+         case TType::shift_right:
+            // Negative amounts are above 63 as unsigned numbers.
+            this->as.arith(7, rcx, 63);
+            this->as.jump_if(above, error(invalid_shift));
+            this->as.shift_cl(op == TType::shift_left ? 4 : 7, rax);
+            break;
+         case TType::bitwise_and: this->as.alu(0x21, rax, src); break;
+         case TType::bitwise_or: this->as.alu(0x09, rax, src); break;
+         case TType::bitwise_xor: this->as.alu(0x31, rax, src); break;
+         default:
+            this->as.alu(0x39, rax, src);
+            this->as.set(comparison(op), rax);
+            this->as.zero_extend(rax);
+            break;
+         }
+      }
+
+      // rax = rax op value for the constants that need no check or a simpler one, returns
+      // false when integer_operation has to do it.
+      bool constant_operation(TType op, long long value)
+      {
+         bool small = fits_int32(value);
+         auto imm = static_cast<std::int32_t>(value);
+
+         switch (op)
+         {
+         case TType::plus:
+         case TType::minus:
+            if (!small)
+               return false;
+            this->as.arith(op == TType::plus ? 0 : 5, rax, imm);
+            this->as.jump_if(overflow, error(integer_overflow));
+            return true;
+         case TType::star:
+            if (!small)
+               return false;
+            this->as.imul(rax, rax, imm);
+            this->as.jump_if(overflow, error(integer_overflow));
+            return true;
+         case TType::slash:
+         case TType::percent:
+            if (value == 0 || value == -1)
+               return false;
+            this->as.mov(rcx, static_cast<std::uint64_t>(value));
+            this->as.cqo();
+            this->as.group3(7, rcx);
+            if (op == TType::percent)
+               this->as.mov(rax, rdx);
+            return true;
+         case TType::shift_left:
+         case TType::shift_right:
+            if (value < 0 || value > 63)
+               return false;
+            if (value != 0)
+               this->as.shift(op == TType::shift_left ? 4 : 7, rax, static_cast<std::uint8_t>(value));
+            return true;
+         case TType::bitwise_and:
+         case TType::bitwise_or:
+         case TType::bitwise_xor:
+            if (!small)
+               return false;
+            this->as.arith(op == TType::bitwise_and ? 4 : op == TType::bitwise_or ? 1 : 6, rax, imm);
+            return true;
+         default:
+            if (!small)
+               return false;
+            this->as.arith(7, rax, imm);
+            this->as.set(comparison(op), rax);
+            this->as.zero_extend(rax);
+            return true;
+         }
+      }
+
+      // xmm0 = xmm0 op src, comparisons leave their result in rax. Comparisons with NaN
+      // are false except for '!='. Xmm2 is free.
+      void real_operation(TType op, std::uint8_t src)
+      {
+         switch (op)
+         {
+         case TType::plus: this->as.addsd(xmm0, src); return;
+         case TType::minus: this->as.subsd(xmm0, src); return;
+         case TType::star: this->as.mulsd(xmm0, src); return;
+         case TType::slash:
+         {
+            auto divide = this->as.label();
+
+            this->as.xorpd(xmm2, xmm2);
+            this->as.ucomisd(src, xmm2);
+            this->as.jump_if_short(parity, divide);
+            this->as.jump_if(equal, error(division_by_zero));
+            this->as.bind(divide);
+            this->as.divsd(xmm0, src);
+            return;
+         }
+         case TType::equals_equals:
+            this->as.ucomisd(xmm0, src);
+            this->as.set(equal, rax);
+            this->as.set(no_parity, rcx);
+            this->as.and_byte(rax, rcx);
+            break;
+         case TType::not_equals:
+            this->as.ucomisd(xmm0, src);
+            this->as.set(not_equal, rax);
+            this->as.set(parity, rcx);
+            this->as.or_byte(rax, rcx);
+            break;
+         case TType::smaller:
+         case TType::smaller_equals:
+            this->as.ucomisd(src, xmm0);
+            this->as.set(op == TType::smaller ? above : above_equal, rax);
+            break;
+         default:
+            this->as.ucomisd(xmm0, src);
+            this->as.set(op == TType::bigger ? above : above_equal, rax);
+            break;
+         }
+         this->as.zero_extend(rax);
+      }
+
+      void gen_logical(const FlatNode& n)
+      {
+         bool conjunction = (n.op == TType::logical_and);
+         auto decided = this->as.label(), end = this->as.label();
+
+         auto falsy = gen_condition(n.first);
+         this->as.jump_if(conjunction ? falsy : static_cast<Cond>(falsy ^ 1), decided);
+         falsy = gen_condition(n.children.second);
+         this->as.set(static_cast<Cond>(falsy ^ 1), rax);
+         this->as.zero_extend(rax);
+         this->as.jump(end);
+
+         this->as.bind(decided);
+         this->as.mov(rax, std::uint64_t {conjunction ? 0u : 1u});
+         this->as.bind(end);
+      }
+
+      void gen_unary(const FlatNode& n)
+      {
+         gen(n.first);
+
+         if (type(n.first) == VType::integer)
+         {
+            switch (n.op)
+            {
+            case TType::minus:
+               this->as.group3(3, rax);
+               this->as.jump_if(overflow, error(integer_overflow));
+               break;
+            case TType::logical_not:
+               this->as.test(rax);
+               this->as.set(equal, rax);
+               this->as.zero_extend(rax);
+               break;
+            case TType::bitwise_not:
+               this->as.group3(2, rax);
+               break;
+            default:
+               break;
+            }
+            return;
+         }
+
+         switch (n.op)
+         {
+         case TType::minus:
+            this->as.movq(rax, xmm0);
+            this->as.btc(rax, 63);
+            this->as.movq(xmm0, rax);
+            break;
+         case TType::logical_not:
+            this->as.xorpd(xmm1, xmm1);
+            this->as.ucomisd(xmm0, xmm1);
+            this->as.set(equal, rax);
+            this->as.set(no_parity, rcx);
+            this->as.and_byte(rax, rcx);
+            this->as.zero_extend(rax);
+            break;
+         default:
+            break;
+         }
+      }
+
+      void gen_increment(const FlatNode& n)
+      {
+         const auto& target = local(node(n.first).first);
+         bool prefix = (n.op == TType::plus_plus || n.op == TType::minus_minus);
+         bool increment = (n.op == TType::plus_plus || n.op == TType::right_plus_plus);
+
+         // Suffix operators give the value from before the change.
+         if (target.type == VType::integer)
+         {
+            auto reg = static_cast<Reg>(target.reg);
+            auto changed = (prefix ? rax : rcx);
+
+            this->as.mov(rax, reg);
+            if (!prefix)
+               this->as.mov(rcx, rax);
+            this->as.arith(increment ? 0 : 5, changed, 1);
+            this->as.jump_if(overflow, error(integer_overflow));
+            this->as.mov(reg, changed);
+            return;
+         }
+
+         auto changed = (prefix ? xmm0 : xmm2);
+
+         this->as.movapd(xmm0, target.reg);
+         load_constant(xmm1, 1.0);
+         this->as.movapd(changed, xmm0);
+         if (increment)
+            this->as.addsd(changed, xmm1);
+         else
+            this->as.subsd(changed, xmm1);
+         this->as.movapd(target.reg, changed);
+      }
+
+      void gen_assignment(const FlatNode& n)
+      {
+         auto& target = local(node(n.first).first);
+         auto value = type(n.children.second);
+         auto op = compound_operator(n.op);
+         bool real = (target.type == VType::real || value == VType::real);
+
+         if (n.op != TType::equals && !real && is_leaf(n.children.second))
+         {
+            this->as.mov(rax, static_cast<Reg>(target.reg));
+            leaf_operation(op, n.children.second);
+            store(target, VType::integer);
+            return;
+         }
+
+         gen(n.children.second);
+
+         if (n.op == TType::equals)
+         {
+            store(target, value);
+            return;
+         }
+
+         // The right side runs first, it may change the variable.
+         if (real)
+         {
+            if (value == VType::integer)
+               this->as.cvtsi2sd(xmm1, rax);
+            else
+               this->as.movapd(xmm1, xmm0);
+
+            if (target.type == VType::integer)
+               this->as.cvtsi2sd(xmm0, static_cast<Reg>(target.reg));
+            else
+               this->as.movapd(xmm0, target.reg);
+
+            real_operation(op, xmm1);
+         }
+         else
+         {
+            this->as.mov(rcx, rax);
+            this->as.mov(rax, static_cast<Reg>(target.reg));
+            integer_operation(op, rcx);
+         }
+         store(target, real ? VType::real : VType::integer);
+      }
+
+      // Converts the value to the type of the variable like convert does and keeps it in
+      // rax or xmm0 as the result of the expression.
+      void store(const Local& target, VType value)
+      {
+         if (target.type == VType::real)
+         {
+            if (value == VType::integer)
+               this->as.cvtsi2sd(xmm0, rax);
+            this->as.movapd(target.reg, xmm0);
+            return;
+         }
+
+         if (value == VType::real)
+         {
+            // cvttsd2si gives the smallest int for NaN and everything out of range,
+            // which is only right for -2^63 itself.
+            auto converted = this->as.label();
+
+            this->as.cvttsd2si(rax, xmm0);
+            this->as.mov(rcx, static_cast<std::uint64_t>(std::numeric_limits<long long>::min()));
+            this->as.alu(0x39, rax, rcx);
+            this->as.jump_if_short(not_equal, converted);
+            load_constant(xmm1, -9223372036854775808.0);
+            this->as.ucomisd(xmm0, xmm1);
+            this->as.jump_if(parity, error(integer_overflow));
+            this->as.jump_if(not_equal, error(integer_overflow));
+            this->as.bind(converted);
+         }
+         this->as.mov(static_cast<Reg>(target.reg), rax);
+      }
+   };
+} // namespace
+
+Jit::Jit(FlatView view)
+   : view(view)
+{
+   // Around 14 bytes of machine code per node, growing the buffer on the way costs more
+   // than compiling.
+   if (available())
+      this->code.reserve(this->view.nodes.size() * 16);
+}
+
+Jit::~Jit()
+{
+   #ifdef JIT_X86_64
+   if (this->memory)
+      munmap(this->memory, this->mapped);
+   #endif
+}
+
+bool Jit::available()
+{
+   #ifdef JIT_X86_64
+   return real_precision == Precision::double_real;
+   #else
+   return false;
+   #endif
+}
+
+std::uint32_t Jit::compile(std::uint32_t first, std::uint32_t& region)
+{
+   if (!available())
+      return 0;
+
+   Region compiled {this->code.size(), {}};
+   auto count = RegionCompiler(this->view, this->code).compile(first, compiled.ints);
+
+   if (count == 0)
+      return 0;
+
+   this->regions.push_back(std::move(compiled));
+   this->statements += count;
+   region = static_cast<std::uint32_t>(this->regions.size() - 1);
+   return count;
+}
+
+void Jit::finalize()
+{
+   #ifdef JIT_X86_64
+   if (this->code.empty() || this->memory)
+      return;
+
+   void* pages = mmap(nullptr, this->code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   if (pages == MAP_FAILED)
+      return;
+
+   std::memcpy(pages, this->code.data(), this->code.size());
+
+   if (mprotect(pages, this->code.size(), PROT_READ | PROT_EXEC) != 0)
+   {
+      munmap(pages, this->code.size());
+      return;
+   }
+
+   this->memory = static_cast<std::uint8_t*>(pages);
+   this->mapped = this->code.size();
+   this->code = {};
+   #endif
+}
+
+const char* Jit::run(std::uint32_t region, Box* registers, Heap& heap, bool& fallback) const
+{
+   // Without executable pages every region falls back to its bytecode.
+   if (!this->memory)
+   {
+      fallback = true;
+      return nullptr;
+   }
+
+   using Native = int (*)(Box*, long long*);
+   const auto& compiled = this->regions[region];
+   std::array<long long, int_pool.size()> wides;
+
+   auto native = reinterpret_cast<Native>(this->memory + compiled.offset);
+   auto status = native(registers, wides.data());
+
+   switch (status)
+   {
+   case done:
+      return nullptr;
+   case deoptimized:
+      fallback = true;
+      return nullptr;
+   case done_wide:
+      for (size_t i = 0; i < compiled.ints.size(); ++i)
+      {
+         auto& reg = registers[compiled.ints[i]];
+         if (reg.tag() == Box::null_tag)
+            reg = Box::from_int(wides[i], heap);
+      }
+      return nullptr;
+   case division_by_zero:
+      return err::division_by_zero;
+   case invalid_shift:
+      return err::invalid_shift;
+   default:
+      return err::integer_overflow;
+   }
+}
+
+size_t Jit::region_count() const
+{
+   return this->regions.size();
+}
+
+size_t Jit::statement_count() const
+{
+   return this->statements;
+}
+
+size_t Jit::code_size() const
+{
+   return (this->memory ? this->mapped : this->code.size());
+}
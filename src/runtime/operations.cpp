@@ -0,0 +1,306 @@
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include <cmath>
+#include <limits>
+
+const char* integer_operation(TType op, long long a, long long b, Value& result)
+{
+   long long value = 0;
+
+   switch (op)
+   {
+   case TType::plus:
+      if (__builtin_add_overflow(a, b, &value))
+         return err::integer_overflow;
+      break;
+   case TType::minus:
+      if (__builtin_sub_overflow(a, b, &value))
+         return err::integer_overflow;
+      break;
+   case TType::star:
+      if (__builtin_mul_overflow(a, b, &value))
+         return err::integer_overflow;
+      break;
+   case TType::slash:
+   case TType::percent:
+      if (b == 0)
+         return err::division_by_zero;
+
+      if (a == std::numeric_limits<long long>::min() && b == -1)
+      {
+         if (op == TType::slash)
+            return err::integer_overflow;
+         value = 0;
+         break;
+      }
+      value = (op == TType::slash ? a / b : a % b);
+      break;
+   case TType::star_star:
+      // Negative exponents truncate towards zero like integer division does.
+      if (b < 0)
+      {
+         if (a == 0)
+            return err::division_by_zero;
+         value = (a == 1 ? 1 : a == -1 ? (b % 2 ? -1 : 1) : 0);
+         break;
+      }
+
+      value = 1;
+      for (long long base = a; b > 0; b >>= 1)
+      {
+         if ((b & 1) && __builtin_mul_overflow(value, base, &value))
+            return err::integer_overflow;
+
+         if (b > 1 && __builtin_mul_overflow(base, base, &base))
+            return err::integer_overflow;
+      }
+      break;
+   case TType::shift_left:
+   case TType::shift_right:
+      if (b < 0 || b > 63)
+         return err::invalid_shift;
+
+      if (op == TType::shift_left)
+         value = static_cast<long long>(static_cast<unsigned long long>(a) << b);
+      else
+         value = a >> b;
+      break;
+   case TType::bitwise_and: value = a & b; break;
+   case TType::bitwise_or: value = a | b; break;
+   case TType::bitwise_xor: value = a ^ b; break;
+   case TType::equals_equals: value = (a == b); break;
+   case TType::not_equals: value = (a != b); break;
+   case TType::smaller: value = (a < b); break;
+   case TType::smaller_equals: value = (a <= b); break;
+   case TType::bigger: value = (a > b); break;
+   case TType::bigger_equals: value = (a >= b); break;
+   case TType::logical_and: value = (a && b); break;
+   case TType::logical_or: value = (a || b); break;
+   default:
+      return err::invalid_operands;
+   }
+
+   result = value;
+   return nullptr;
+}
+
+template <typename Real>
+static const char* real_operation_as(TType op, Real a, Real b, Value& result)
+{
+   switch (op)
+   {
+   case TType::plus: result = static_cast<real_t>(a + b); break;
+   case TType::minus: result = static_cast<real_t>(a - b); break;
+   case TType::star: result = static_cast<real_t>(a * b); break;
+   case TType::slash:
+   case TType::percent:
+      if (b == 0.0)
+         return err::division_by_zero;
+      result = static_cast<real_t>(op == TType::slash ? a / b : std::fmod(a, b));
+      break;
+   case TType::star_star: result = static_cast<real_t>(std::pow(a, b)); break;
+   case TType::equals_equals: result = static_cast<long long>(a == b); break;
+   case TType::not_equals: result = static_cast<long long>(a != b); break;
+   case TType::smaller: result = static_cast<long long>(a < b); break;
+   case TType::smaller_equals: result = static_cast<long long>(a <= b); break;
+   case TType::bigger: result = static_cast<long long>(a > b); break;
+   case TType::bigger_equals: result = static_cast<long long>(a >= b); break;
+   case TType::logical_and: result = static_cast<long long>(a != 0.0 && b != 0.0); break;
+   case TType::logical_or: result = static_cast<long long>(a != 0.0 || b != 0.0); break;
+   default:
+      return err::invalid_operands;
+   }
+   return nullptr;
+}
+
+const char* real_operation(TType op, real_t a, real_t b, Value& result)
+{
+   if (real_precision == Precision::double_real)
+      return real_operation_as<double>(op, a, b, result);
+   return real_operation_as<real_t>(op, a, b, result);
+}
+
+static const char* string_operation(TType op, const std::string& a, const std::string& b, Value& result)
+{
+   switch (op)
+   {
+   case TType::plus: result = a + b; break;
+   case TType::equals_equals: result = static_cast<long long>(a == b); break;
+   case TType::not_equals: result = static_cast<long long>(a != b); break;
+   default:
+      return err::invalid_operands;
+   }
+   return nullptr;
+}
+
+const char* binary_operation(TType op, const Value& a, const Value& b, Value& result)
+{
+   auto left = type_of(a);
+   auto right = type_of(b);
+
+   if (left == VType::string && right == VType::string)
+      return string_operation(op, std::get<std::string>(a), std::get<std::string>(b), result);
+
+   if (!is_number(a) || !is_number(b))
+      return err::invalid_operands;
+
+   if (left == VType::real || right == VType::real)
+      return real_operation(op, to_real(a), to_real(b), result);
+   return integer_operation(op, to_integer(a), to_integer(b), result);
+}
+
+const char* unary_operation(TType op, const Value& value, Value& result)
+{
+   if (!is_number(value))
+      return err::invalid_operands;
+
+   bool real = (type_of(value) == VType::real);
+
+   switch (op)
+   {
+   case TType::plus:
+      if (real)
+         result = value;
+      else
+         result = to_integer(value);
+      break;
+   case TType::minus:
+      if (real)
+         result = -to_real(value);
+      else if (to_integer(value) == std::numeric_limits<long long>::min())
+         return err::integer_overflow;
+      else
+         result = -to_integer(value);
+      break;
+   case TType::logical_not:
+      result = static_cast<long long>(to_real(value) == 0.0);
+      break;
+   case TType::bitwise_not:
+      if (real)
+         return err::invalid_operands;
+      result = ~to_integer(value);
+      break;
+   default:
+      return err::invalid_operands;
+   }
+   return nullptr;
+}
+
+TType compound_operator(TType op)
+{
+   switch (op)
+   {
+   case TType::plus_equals: return TType::plus;
+   case TType::minus_equals: return TType::minus;
+   case TType::star_equals: return TType::star;
+   case TType::slash_equals: return TType::slash;
+   case TType::percent_equals: return TType::percent;
+   case TType::shift_left_equals: return TType::shift_left;
+   case TType::shift_right_equals: return TType::shift_right;
+   case TType::bitwise_and_equals: return TType::bitwise_and;
+   case TType::bitwise_xor_equals: return TType::bitwise_xor;
+   case TType::bitwise_or_equals: return TType::bitwise_or;
+   case TType::star_star_equals: return TType::star_star;
+   default: return TType::equals;
+   }
+}
+
+const char* truthy(const Value& value, bool& result)
+{
+   if (!is_number(value))
+      return err::invalid_operands;
+
+   result = (to_real(value) != 0.0);
+   return nullptr;
+}
+
+static bool is_comparison(TType op)
+{
+   switch (op)
+   {
+   case TType::equals_equals: case TType::not_equals:
+   case TType::smaller: case TType::smaller_equals:
+   case TType::bigger: case TType::bigger_equals:
+   case TType::logical_and: case TType::logical_or:
+      return true;
+   default:
+      return false;
+   }
+}
+
+const char* binary_type(TType op, VType a, VType b, VType& result)
+{
+   result = VType::null;
+
+   if (a == VType::null || b == VType::null)
+      return nullptr;
+
+   if (a == VType::string || b == VType::string)
+   {
+      if (a != b)
+         return err::invalid_operands;
+
+      switch (op)
+      {
+      case TType::plus: result = VType::string; break;
+      case TType::equals_equals:
+      case TType::not_equals: result = VType::integer; break;
+      default:
+         return err::invalid_operands;
+      }
+      return nullptr;
+   }
+
+   bool real = (a == VType::real || b == VType::real);
+
+   switch (op)
+   {
+   case TType::shift_left:
+   case TType::shift_right:
+   case TType::bitwise_and:
+   case TType::bitwise_or:
+   case TType::bitwise_xor:
+      if (real)
+         return err::invalid_operands;
+      break;
+   default:
+      break;
+   }
+
+   result = (is_comparison(op) || !real ? VType::integer : VType::real);
+   return nullptr;
+}
+
+const char* unary_type(TType op, VType value, VType& result)
+{
+   result = VType::null;
+
+   if (value == VType::string)
+      return err::invalid_operands;
+
+   switch (op)
+   {
+   case TType::plus:
+   case TType::minus:
+      if (value != VType::null)
+         result = (value == VType::real ? VType::real : VType::integer);
+      break;
+   case TType::bitwise_not:
+      if (value == VType::real)
+         return err::invalid_operands;
+      result = VType::integer;
+      break;
+   case TType::logical_not:
+      result = VType::integer;
+      break;
+   default:
+      return err::invalid_operands;
+   }
+   return nullptr;
+}
+
+const char* truthy_type(VType value)
+{
+   return (value == VType::string ? err::invalid_operands : nullptr);
+}
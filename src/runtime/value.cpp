@@ -0,0 +1,119 @@
+#include "runtime/value.hpp"
+#include "errors/errors.hpp"
+#include "config/precision.hpp"
+#include <cmath>
+#include <sstream>
+
+VType type_of(const Value& value)
+{
+   return static_cast<VType>(value.index());
+}
+
+VType type_from_name(std::string_view name)
+{
+   if (name == "int")
+      return VType::integer;
+   if (name == "real")
+      return VType::real;
+   if (name == "char")
+      return VType::character;
+   if (name == "bool")
+      return VType::boolean;
+   if (name == "string")
+      return VType::string;
+   return VType::null;
+}
+
+const char* type_to_name(VType type)
+{
+   switch (type)
+   {
+   case VType::integer: return "int";
+   case VType::real: return "real";
+   case VType::character: return "char";
+   case VType::boolean: return "bool";
+   case VType::string: return "string";
+   default: return "null";
+   }
+}
+
+bool is_number(const Value& value)
+{
+   auto type = type_of(value);
+   return type != VType::null && type != VType::string;
+}
+
+long long to_integer(const Value& value)
+{
+   switch (type_of(value))
+   {
+   case VType::integer: return std::get<long long>(value);
+   case VType::real: return static_cast<long long>(std::get<real_t>(value));
+   case VType::character: return std::get<char>(value);
+   case VType::boolean: return std::get<bool>(value);
+   default: return 0;
+   }
+}
+
+real_t to_real(const Value& value)
+{
+   if (type_of(value) == VType::real)
+      return std::get<real_t>(value);
+   return round_real(static_cast<real_t>(to_integer(value)));
+}
+
+const char* convert(Value& value, VType type)
+{
+   if (type == VType::null || type == type_of(value) || type_of(value) == VType::null)
+      return nullptr;
+
+   if (type == VType::string || type_of(value) == VType::string)
+      return err::type_mismatch;
+
+   switch (type)
+   {
+   case VType::integer:
+   {
+      real_t real = to_real(value);
+
+      if (std::isnan(real) || real >= 9223372036854775808.0L || real < -9223372036854775808.0L)
+         return err::integer_overflow;
+      value = to_integer(value);
+      break;
+   }
+   case VType::real:
+      value = to_real(value);
+      break;
+   case VType::character:
+      value = static_cast<char>(to_integer(value));
+      break;
+   case VType::boolean:
+      value = (to_real(value) != 0.0);
+      break;
+   default:
+      break;
+   }
+   return nullptr;
+}
+
+std::string to_string(const Value& value)
+{
+   std::ostringstream stream;
+
+   switch (type_of(value))
+   {
+   case VType::null: stream << "null"; break;
+   case VType::integer: stream << std::get<long long>(value); break;
+   case VType::real:
+      // The sign of a NaN depends on how it was produced, print them all the same way.
+      if (std::isnan(std::get<real_t>(value)))
+         stream << "nan";
+      else
+         stream << std::get<real_t>(value);
+      break;
+   case VType::character: stream << std::get<char>(value); break;
+   case VType::boolean: stream << (std::get<bool>(value) ? "true" : "false"); break;
+   case VType::string: stream << std::get<std::string>(value); break;
+   }
+   return stream.str();
+}
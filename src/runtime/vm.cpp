@@ -0,0 +1,410 @@
+#include "runtime/vm.hpp"
+#include "runtime/operations.hpp"
+#include "errors/errors.hpp"
+#include "config/cancellation.hpp"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+VirtualMachine::VirtualMachine(Catcher& catcher, const Chunk& chunk, const Jit* jit, std::pmr::memory_resource* memory)
+   : catcher(catcher), chunk(chunk), jit(jit), constants(memory), registers(chunk.registers, memory), next(chunk.code.data())
+{
+   this->constants.reserve(chunk.constants.size());
+
+   for (const auto& constant : chunk.constants)
+      this->constants.push_back(box(constant, this->heap));
+}
+
+void VirtualMachine::define(std::uint32_t slot, const Value& value)
+{
+   // Inputs the program never reads have no register.
+   if (slot < this->registers.size())
+      this->registers[slot] = box(value, this->heap);
+}
+
+void VirtualMachine::print() const
+{
+   for (const auto& [slot, name] : this->chunk.variables)
+      std::cout << "[" << name << "] = " << to_string(unbox(this->registers[slot], this->heap)) << "\n";
+}
+
+std::vector<std::pair<std::string, Value>> VirtualMachine::variables() const
+{
+   std::vector<std::pair<std::string, Value>> variables;
+
+   for (const auto& [slot, name] : this->chunk.variables)
+      variables.emplace_back(name, unbox(this->registers[slot], this->heap));
+   return variables;
+}
+
+size_t VirtualMachine::register_count() const
+{
+   return this->registers.size();
+}
+
+// Truthiness of inline ints and reals without going through Value.
+static const char* test(Box box, const Heap& heap, bool& result)
+{
+   if (box.tag() == Box::int_tag)
+      result = (box.index() != 0);
+   else if (box.is_real())
+      result = (box.real() != 0.0);
+   else
+      return truthy(unbox(box, heap), result);
+   return nullptr;
+}
+
+// Arithmetic on a real and an inline int is done in doubles without going through Value,
+// returns false for every other combination.
+static bool mixed_binary(TType op, Box x, Box y, Box& result, const char*& error)
+{
+   if (!(x.is_real() || x.tag() == Box::int_tag) || !(y.is_real() || y.tag() == Box::int_tag) || Box::both_inline(x, y))
+      return false;
+
+   double a = (x.is_real() ? x.real() : static_cast<double>(x.inline_int()));
+   double b = (y.is_real() ? y.real() : static_cast<double>(y.inline_int()));
+
+   switch (op)
+   {
+   case TType::plus: result = Box::from_real(a + b); return true;
+   case TType::minus: result = Box::from_real(a - b); return true;
+   case TType::star: result = Box::from_real(a * b); return true;
+   case TType::slash:
+      if (b == 0.0)
+         error = err::division_by_zero;
+      else
+         result = Box::from_real(a / b);
+      return true;
+   case TType::equals_equals: result = Box::tagged(Box::int_tag, a == b); return true;
+   case TType::not_equals: result = Box::tagged(Box::int_tag, a != b); return true;
+   case TType::smaller: result = Box::tagged(Box::int_tag, a < b); return true;
+   case TType::smaller_equals: result = Box::tagged(Box::int_tag, a <= b); return true;
+   case TType::bigger: result = Box::tagged(Box::int_tag, a > b); return true;
+   case TType::bigger_equals: result = Box::tagged(Box::int_tag, a >= b); return true;
+   default: return false;
+   }
+}
+
+size_t VirtualMachine::fail(const char* error, const Instruction* ip)
+{
+   this->catcher.insert(error);
+   this->next = nullptr;
+
+   // Statements before the one that failed have been executed.
+   auto pc = static_cast<std::uint32_t>(ip - this->chunk.code.data());
+   const auto& starts = this->chunk.statements;
+   return static_cast<size_t>(std::upper_bound(starts.begin(), starts.end(), pc) - starts.begin()) - 1;
+}
+
+// A budgeted run counts every instruction it dispatches, the other one compiles without.
+#define YIELD() if constexpr (budgeted) { if (budget-- == 0) goto yield; }
+
+#ifdef VM_COMPUTED_GOTO
+#define DISPATCH() do { YIELD() goto *labels[static_cast<size_t>(ip->op)]; } while (false)
+#define CASE(name) op_##name
+#else
+#define DISPATCH() do { YIELD() goto dispatch; } while (false)
+#define CASE(name) case OpCode::name
+#endif
+
+#define NEXT() do { ++ip; DISPATCH(); } while (false)
+#define FAIL(message) do { error = (message); goto fail; } while (false)
+// Only the generic paths box strings and long reals, the typed ones never allocate.
+#define CHECK_MEMORY() do { if (heap.bytes > this->memory_limit) FAIL(err::memory_budget_exceeded); } while (false)
+
+// Inline ints take the fast path after one branch, wide ints are read from the heap.
+#define INT_COMPARE(name, op) \
+   CASE(name): \
+   { \
+      Box x = r[ip->b], y = r[ip->c]; \
+      bool value = (Box::both_inline(x, y) ? x.inline_int() op y.inline_int() : x.integer(heap) op y.integer(heap)); \
+      r[ip->a] = Box::tagged(Box::int_tag, value); \
+      NEXT(); \
+   }
+
+// The compiler only emits real opcodes for registers that hold reals.
+#define REAL_COMPARE(name, op) \
+   CASE(name): \
+      r[ip->a] = Box::tagged(Box::int_tag, r[ip->b].real() op r[ip->c].real()); \
+      NEXT();
+
+#define REAL_ARITHMETIC(name, op) \
+   CASE(name): \
+      r[ip->a] = Box::from_real(r[ip->b].real() op r[ip->c].real()); \
+      NEXT();
+
+size_t VirtualMachine::run()
+{
+   if (!cancel_flag)
+      return (this->next ? execute<false>(0) : this->chunk.statements.size());
+
+   // A job that can be cancelled runs in slices and checks between them.
+   while (true)
+   {
+      if (auto evaluated = resume(cancel_interval))
+         return *evaluated;
+
+      if (cancelled())
+         return interrupt(err::job_cancelled);
+   }
+}
+
+std::optional<size_t> VirtualMachine::resume(size_t budget)
+{
+   if (!this->next)
+      return this->chunk.statements.size();
+
+   size_t evaluated = execute<true>(budget);
+
+   if (this->next)
+      return std::nullopt;
+   return evaluated;
+}
+
+size_t VirtualMachine::interrupt(const char* error)
+{
+   return fail(error, this->next);
+}
+
+void VirtualMachine::specify_memory_limit(size_t bytes)
+{
+   this->memory_limit = bytes;
+}
+
+template <bool budgeted>
+size_t VirtualMachine::execute(size_t budget)
+{
+   const Instruction* code = this->chunk.code.data();
+   const Instruction* ip = this->next;
+   const Box* k = this->constants.data();
+   Box* r = this->registers.data();
+   Heap& heap = this->heap;
+   const char* error = nullptr;
+
+   #ifdef VM_COMPUTED_GOTO
+   #define X(name, layout) &&op_##name,
+   static const void* labels[] = { OPCODES(X) };
+   #undef X
+   #endif
+
+   DISPATCH();
+
+   #ifndef VM_COMPUTED_GOTO
+dispatch:
+   switch (ip->op)
+   {
+   #endif
+   CASE(halt):
+      this->next = nullptr;
+      return this->chunk.statements.size();
+   CASE(move):
+      r[ip->a] = r[ip->b];
+      NEXT();
+   CASE(load):
+      r[ip->a] = k[ip->b];
+      NEXT();
+   CASE(load_int):
+      r[ip->a] = Box::from_int(static_cast<long long>(ip->b | std::uint64_t{ip->c} << 32), heap);
+      NEXT();
+   CASE(check):
+      if (r[ip->a].tag() == Box::null_tag)
+         FAIL(err::uninitialized_variable);
+      NEXT();
+   CASE(convert):
+   {
+      Value value = unbox(r[ip->a], heap);
+
+      if ((error = convert(value, ip->vtype)))
+         goto fail;
+      r[ip->a] = box(value, heap);
+      CHECK_MEMORY();
+      NEXT();
+   }
+   CASE(store_dynamic):
+   {
+      Value value = unbox(r[ip->b], heap);
+
+      if ((error = convert(value, type_of(unbox(r[ip->a], heap)))))
+         goto fail;
+      r[ip->a] = box(value, heap);
+      CHECK_MEMORY();
+      NEXT();
+   }
+   CASE(binary):
+   {
+      if (mixed_binary(ip->ttype, r[ip->b], r[ip->c], r[ip->a], error))
+      {
+         if (error)
+            goto fail;
+         NEXT();
+      }
+
+      Value result;
+
+      if ((error = binary_operation(ip->ttype, unbox(r[ip->b], heap), unbox(r[ip->c], heap), result)))
+         goto fail;
+      r[ip->a] = box(result, heap);
+      CHECK_MEMORY();
+      NEXT();
+   }
+   CASE(unary):
+   {
+      Value result;
+
+      if ((error = unary_operation(ip->ttype, unbox(r[ip->b], heap), result)))
+         goto fail;
+      r[ip->a] = box(result, heap);
+      CHECK_MEMORY();
+      NEXT();
+   }
+   CASE(truthy):
+   {
+      bool value = false;
+
+      if ((error = test(r[ip->b], heap, value)))
+         goto fail;
+      r[ip->a] = Box::tagged(Box::int_tag, value);
+      NEXT();
+   }
+   CASE(jump):
+      ip = code + ip->a;
+      DISPATCH();
+   CASE(jump_false):
+   CASE(jump_true):
+   {
+      bool value = false;
+
+      if ((error = test(r[ip->a], heap, value)))
+         goto fail;
+      ip = (value == (ip->op == OpCode::jump_true) ? code + ip->b : ip + 1);
+      DISPATCH();
+   }
+   CASE(add_int):
+   {
+      Box x = r[ip->b], y = r[ip->c];
+      long long value = 0;
+
+      // Two inline ints cannot overflow 64 bits when added or subtracted.
+      if (Box::both_inline(x, y))
+         value = x.inline_int() + y.inline_int();
+      else if (__builtin_add_overflow(x.integer(heap), y.integer(heap), &value))
+         FAIL(err::integer_overflow);
+      r[ip->a] = Box::from_int(value, heap);
+      NEXT();
+   }
+   CASE(sub_int):
+   {
+      Box x = r[ip->b], y = r[ip->c];
+      long long value = 0;
+
+      if (Box::both_inline(x, y))
+         value = x.inline_int() - y.inline_int();
+      else if (__builtin_sub_overflow(x.integer(heap), y.integer(heap), &value))
+         FAIL(err::integer_overflow);
+      r[ip->a] = Box::from_int(value, heap);
+      NEXT();
+   }
+   CASE(mul_int):
+   {
+      Box x = r[ip->b], y = r[ip->c];
+      long long value = 0;
+      bool overflow = (Box::both_inline(x, y) ? __builtin_mul_overflow(x.inline_int(), y.inline_int(), &value) : __builtin_mul_overflow(x.integer(heap), y.integer(heap), &value));
+
+      if (overflow)
+         FAIL(err::integer_overflow);
+      r[ip->a] = Box::from_int(value, heap);
+      NEXT();
+   }
+   CASE(div_int):
+   CASE(mod_int):
+   {
+      Box x = r[ip->b], y = r[ip->c];
+      bool divide = (ip->op == OpCode::div_int);
+
+      // The smallest int is never inline, so only division by zero can fail here.
+      if (Box::both_inline(x, y))
+      {
+         if (y.inline_int() == 0)
+            FAIL(err::division_by_zero);
+         r[ip->a] = Box::tagged(Box::int_tag, static_cast<std::uint64_t>(divide ? x.inline_int() / y.inline_int() : x.inline_int() % y.inline_int()));
+         NEXT();
+      }
+
+      long long a = x.integer(heap);
+      long long b = y.integer(heap);
+
+      if (b == 0)
+         FAIL(err::division_by_zero);
+
+      if (a == std::numeric_limits<long long>::min() && b == -1)
+      {
+         if (divide)
+            FAIL(err::integer_overflow);
+         r[ip->a] = Box::tagged(Box::int_tag, 0);
+         NEXT();
+      }
+      r[ip->a] = Box::from_int(divide ? a / b : a % b, heap);
+      NEXT();
+   }
+   CASE(neg_int):
+   {
+      long long value = r[ip->b].integer(heap);
+
+      if (value == std::numeric_limits<long long>::min())
+         FAIL(err::integer_overflow);
+      r[ip->a] = Box::from_int(-value, heap);
+      NEXT();
+   }
+   INT_COMPARE(eq_int, ==)
+   INT_COMPARE(ne_int, !=)
+   INT_COMPARE(lt_int, <)
+   INT_COMPARE(le_int, <=)
+   INT_COMPARE(gt_int, >)
+   INT_COMPARE(ge_int, >=)
+   REAL_ARITHMETIC(add_real, +)
+   REAL_ARITHMETIC(sub_real, -)
+   REAL_ARITHMETIC(mul_real, *)
+   CASE(div_real):
+      if (r[ip->c].real() == 0.0)
+         FAIL(err::division_by_zero);
+      r[ip->a] = Box::from_real(r[ip->b].real() / r[ip->c].real());
+      NEXT();
+   CASE(neg_real):
+      r[ip->a] = Box::from_real(-r[ip->b].real());
+      NEXT();
+   REAL_COMPARE(eq_real, ==)
+   REAL_COMPARE(ne_real, !=)
+   REAL_COMPARE(lt_real, <)
+   REAL_COMPARE(le_real, <=)
+   REAL_COMPARE(gt_real, >)
+   REAL_COMPARE(ge_real, >=)
+   CASE(native):
+   {
+      bool fallback = false;
+
+      if ((error = this->jit->run(ip->a, r, heap, fallback)))
+         goto fail;
+      ip = (fallback ? ip + 1 : code + ip->b);
+      DISPATCH();
+   }
+   #ifndef VM_COMPUTED_GOTO
+   }
+   #endif
+
+fail:
+   return fail(error, ip);
+
+[[maybe_unused]] yield:
+   this->next = ip;
+   return 0;
+}
+
+#undef YIELD
+#undef DISPATCH
+#undef CASE
+#undef NEXT
+#undef FAIL
+#undef CHECK_MEMORY
+#undef INT_COMPARE
+#undef REAL_COMPARE
+#undef REAL_ARITHMETIC
@@ -0,0 +1,56 @@
+#include "script/green_scheduler.hpp"
+#include <algorithm>
+
+GreenScheduler::GreenScheduler(size_t quantum)
+   : quantum(std::max<size_t>(1, quantum)) {}
+
+void GreenScheduler::spawn(GreenTask task)
+{
+   // Errors are in the result, the task decides what to do with them.
+   auto run = std::make_unique<ScriptRun>(*task.script, task.inputs, [](const char*) {}, &this->pool);
+   size_t budget = this->quantum * std::max<size_t>(1, task.priority);
+
+   this->ready.push_back({std::move(task.script), std::move(run), std::move(task.done), budget});
+   ++this->counters.spawned;
+   this->counters.peak = std::max<std::uint64_t>(this->counters.peak, this->ready.size());
+}
+
+bool GreenScheduler::step()
+{
+   if (this->ready.empty())
+      return false;
+
+   Fiber fiber = std::move(this->ready.front());
+   this->ready.pop_front();
+
+   if (!fiber.run->resume(fiber.budget))
+   {
+      this->ready.push_back(std::move(fiber));
+      ++this->counters.switches;
+      return true;
+   }
+
+   auto& result = fiber.run->result();
+   ++this->counters.completed;
+   this->counters.failed += !result.success;
+
+   if (fiber.done)
+      fiber.done(result);
+   return true;
+}
+
+void GreenScheduler::run()
+{
+   while (!this->ready.empty())
+      step();
+}
+
+size_t GreenScheduler::active() const
+{
+   return this->ready.size();
+}
+
+const GreenScheduler::Stats& GreenScheduler::stats() const
+{
+   return this->counters;
+}
@@ -0,0 +1,268 @@
+#include "script/script.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "optimizer/pass_manager.hpp"
+#include "pipeline/back_end.hpp"
+#include "runtime/compiler.hpp"
+#include "runtime/evaluator.hpp"
+#include "runtime/vm.hpp"
+#include "errors/errors.hpp"
+#include <algorithm>
+
+namespace
+{
+   // The precision is per thread, scripts set theirs for as long as they compile or run
+   // and give the thread back the one it had.
+   class PrecisionScope
+   {
+   public:
+      PrecisionScope(Precision precision)
+         : previous(real_precision)
+      {
+         real_precision = precision;
+      }
+
+      ~PrecisionScope()
+      {
+         real_precision = this->previous;
+      }
+
+   private:
+      Precision previous;
+   };
+} // namespace
+
+CompiledScript::CompiledScript(const ScriptOptions& options)
+   : script_options(options) {}
+
+std::shared_ptr<const CompiledScript> CompiledScript::compile(std::string source, const ScriptOptions& options, const ScriptSinks& sinks)
+{
+   PrecisionScope precision (options.precision);
+   Catcher catcher;
+
+   if (sinks.diagnostics)
+      catcher.specify_error_sink(sinks.diagnostics);
+
+   if (options.precision == Precision::long_real && !long_reals_stored)
+   {
+      catcher.insert(err::long_real_unavailable);
+      catcher.display();
+      return nullptr;
+   }
+
+   Lexer lexer (catcher, source);
+   auto& tokens = lexer.tokenize();
+
+   if (catcher.display())
+      return nullptr;
+
+   Preprocessor preprocessor (catcher, tokens, options.file, !options.predefined_macros);
+
+   if (options.max_macro_depth)
+      preprocessor.specify_max_macro_depth(options.max_macro_depth);
+   if (sinks.output)
+      preprocessor.specify_log_sink(sinks.output);
+   preprocessor.process();
+
+   if (catcher.display())
+      return nullptr;
+
+   Parser parser (catcher, tokens);
+   auto& program = parser.parse();
+
+   if (catcher.display())
+      return nullptr;
+
+   PassManager passes (catcher, program);
+   passes.specify_level(options.optimization);
+
+   BackEnd back_end (catcher, program, passes);
+   for (const auto& input : options.inputs)
+      back_end.define(input.name, input.type);
+   auto flat = back_end.compile();
+
+   if (!flat)
+      return nullptr;
+
+   std::shared_ptr<CompiledScript> script (new CompiledScript(options));
+   script->log_output = preprocessor.get_log();
+   script->flat = std::move(*flat);
+
+   if (options.engine != Engine::evaluator)
+   {
+      if (options.engine == Engine::jit)
+         script->jit.emplace(script->flat.view());
+
+      Compiler compiler (script->flat.view(), script->jit ? &*script->jit : nullptr);
+      for (std::uint32_t i = 0; i < options.inputs.size(); ++i)
+         compiler.define(i, options.inputs[i].type);
+      script->chunk = compiler.compile();
+   }
+   return script;
+}
+
+ScriptResult CompiledScript::run(const std::vector<Value>& inputs, const ErrorSink& diagnostics, std::pmr::memory_resource* memory) const
+{
+   ScriptRun run (*this, inputs, diagnostics, memory);
+   run.resume();
+   return std::move(run.result());
+}
+
+const ScriptOptions& CompiledScript::options() const
+{
+   return this->script_options;
+}
+
+const std::string& CompiledScript::log() const
+{
+   return this->log_output;
+}
+
+ScriptRun::ScriptRun(const CompiledScript& script, const std::vector<Value>& inputs, ErrorSink diagnostics, std::pmr::memory_resource* memory)
+   : script(script), diagnostics(std::move(diagnostics))
+{
+   PrecisionScope precision (script.script_options.precision);
+
+   this->catcher.specify_error_sink([this](const char* error)
+   {
+      if (!this->run_result.error)
+         this->run_result.error = error;
+
+      // Without a sink it is printed like everywhere else.
+      if (this->diagnostics)
+         this->diagnostics(error);
+      else
+         Catcher().error(error);
+   });
+
+   // Inputs are converted like values stored into a variable of their type.
+   std::pmr::vector<Value> values (inputs.begin(), inputs.end(), memory);
+   bool valid = (values.size() == script.script_options.inputs.size());
+
+   for (size_t i = 0; valid && i < values.size(); ++i)
+   {
+      auto type = script.script_options.inputs[i].type;
+
+      if (type_of(values[i]) == VType::null)
+         valid = false;
+      else if (auto error = convert(values[i], type))
+      {
+         this->catcher.error(error);
+         this->done = true;
+         return;
+      }
+   }
+
+   if (!valid)
+   {
+      this->catcher.error(err::invalid_script_inputs);
+      this->done = true;
+      return;
+   }
+
+   auto memory_limit = script.script_options.limits.memory;
+
+   if (script.script_options.engine == Engine::evaluator)
+   {
+      this->evaluator.emplace(this->catcher, script.flat.view(), memory);
+      for (std::uint32_t i = 0; i < values.size(); ++i)
+         this->evaluator->define(i, std::move(values[i]));
+
+      if (memory_limit)
+         this->evaluator->specify_memory_limit(memory_limit);
+   }
+   else
+   {
+      this->vm.emplace(this->catcher, script.chunk, script.jit ? &*script.jit : nullptr, memory);
+      for (std::uint32_t i = 0; i < values.size(); ++i)
+         this->vm->define(i, values[i]);
+
+      if (memory_limit)
+         this->vm->specify_memory_limit(memory_limit);
+   }
+}
+
+bool ScriptRun::resume(size_t budget)
+{
+   if (this->done)
+      return true;
+
+   PrecisionScope precision (this->script.script_options.precision);
+   const auto& limits = this->script.script_options.limits;
+
+   if (!limits.operations && !limits.time.count())
+   {
+      if (auto evaluated = execute(budget))
+         finish(*evaluated);
+      return this->done;
+   }
+
+   auto last = std::chrono::steady_clock::now();
+
+   while (true)
+   {
+      size_t slice = std::min(budget, check_interval);
+      if (limits.operations)
+         slice = static_cast<size_t>(std::min<std::uint64_t>(slice, limits.operations - this->steps));
+
+      auto evaluated = execute(slice);
+      auto now = std::chrono::steady_clock::now();
+      this->elapsed += now - last;
+      last = now;
+
+      if (evaluated)
+      {
+         finish(*evaluated);
+         break;
+      }
+
+      this->steps += slice;
+      budget -= slice;
+      const char* error = nullptr;
+
+      if (limits.operations && this->steps >= limits.operations)
+         error = err::operation_budget_exceeded;
+      else if (limits.time.count() && this->elapsed >= limits.time)
+         error = err::time_budget_exceeded;
+
+      if (error)
+      {
+         finish(this->evaluator ? this->evaluator->interrupt(error) : this->vm->interrupt(error));
+         break;
+      }
+
+      if (budget == 0)
+         break;
+   }
+   return this->done;
+}
+
+bool ScriptRun::finished() const
+{
+   return this->done;
+}
+
+ScriptResult& ScriptRun::result()
+{
+   return this->run_result;
+}
+
+// Running to the end takes the path that does not count instructions.
+std::optional<size_t> ScriptRun::execute(size_t budget)
+{
+   if (this->evaluator)
+      return (budget == unlimited ? this->evaluator->evaluate() : this->evaluator->resume(budget));
+   return (budget == unlimited ? this->vm->run() : this->vm->resume(budget));
+}
+
+void ScriptRun::finish(size_t evaluated)
+{
+   this->done = true;
+   this->run_result.evaluated = evaluated;
+
+   if (this->catcher.display())
+      return;
+
+   this->run_result.variables = (this->evaluator ? this->evaluator->variables() : this->vm->variables());
+   this->run_result.success = true;
+}
@@ -0,0 +1,247 @@
+#include "script/script_service.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+   // The service and the index of the worker running on this thread, submitting from a
+   // worker pushes onto its own deque.
+   thread_local const ScriptService* current_service = nullptr;
+   thread_local size_t current_worker = 0;
+} // namespace
+
+void LatencyHistogram::record(std::uint64_t nanoseconds)
+{
+   ++this->buckets[bucket(nanoseconds)];
+   ++this->total;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+   for (size_t i = 0; i < bucket_count; ++i)
+      this->buckets[i] += other.buckets[i];
+   this->total += other.total;
+}
+
+std::uint64_t LatencyHistogram::count() const
+{
+   return this->total;
+}
+
+std::uint64_t LatencyHistogram::percentile(double quantile) const
+{
+   if (!this->total)
+      return 0;
+
+   auto target = std::max<std::uint64_t>(1, std::ceil(quantile * this->total));
+   std::uint64_t seen = 0;
+
+   for (size_t i = 0; i < bucket_count; ++i)
+   {
+      seen += this->buckets[i];
+
+      if (seen >= target)
+         return upper_end(i);
+   }
+   return upper_end(bucket_count - 1);
+}
+
+// Values below sub_buckets get a bucket each, every power of two above is split into
+// sub_buckets buckets of the same width.
+size_t LatencyHistogram::bucket(std::uint64_t nanoseconds)
+{
+   if (nanoseconds < sub_buckets)
+      return nanoseconds;
+
+   size_t exponent = std::bit_width(nanoseconds) - 1;
+   size_t sub = (nanoseconds >> (exponent - 3)) & (sub_buckets - 1);
+   return (exponent - 2) * sub_buckets + sub;
+}
+
+std::uint64_t LatencyHistogram::upper_end(size_t bucket)
+{
+   if (bucket < sub_buckets)
+      return bucket;
+
+   size_t exponent = bucket / sub_buckets + 2;
+   std::uint64_t width = std::uint64_t{1} << (exponent - 3);
+   return (sub_buckets + bucket % sub_buckets) * width + width - 1;
+}
+
+ScriptService::ScriptService(size_t workers)
+   : started(Clock::now())
+{
+   if (workers == 0)
+      workers = std::max(1u, std::thread::hardware_concurrency());
+
+   for (size_t i = 0; i < workers; ++i)
+      this->workers.push_back(std::make_unique<Worker>());
+
+   // Every deque exists before any worker looks for something to steal.
+   for (size_t i = 0; i < workers; ++i)
+      this->workers[i]->thread = std::thread(&ScriptService::work, this, i);
+}
+
+ScriptService::~ScriptService()
+{
+   wait();
+
+   {
+      std::lock_guard lock (this->idle_mutex);
+      this->stopping = true;
+   }
+   this->idle.notify_all();
+
+   for (auto& worker : this->workers)
+      worker->thread.join();
+}
+
+void ScriptService::submit(RunRequest request)
+{
+   size_t index = (current_service == this ? current_worker : this->next_worker++ % this->workers.size());
+   auto& worker = *this->workers[index];
+
+   ++this->submitted;
+   ++this->unfinished;
+
+   {
+      std::lock_guard lock (worker.mutex);
+      worker.tasks.push_back({std::move(request), Clock::now()});
+   }
+
+   // A worker going to sleep counts itself before it checks the queue, so either it
+   // sees this request or it is counted here.
+   ++this->queued;
+
+   if (this->sleeping > 0)
+   {
+      std::lock_guard lock (this->idle_mutex);
+      this->idle.notify_one();
+   }
+}
+
+void ScriptService::wait()
+{
+   std::unique_lock lock (this->done_mutex);
+   this->all_done.wait(lock, [this]() { return this->unfinished == 0; });
+}
+
+size_t ScriptService::worker_count() const
+{
+   return this->workers.size();
+}
+
+std::uint64_t ScriptService::queue_depth() const
+{
+   return this->queued;
+}
+
+ScriptService::Stats ScriptService::stats() const
+{
+   Stats stats;
+   stats.submitted = this->submitted;
+   stats.queued = this->queued;
+
+   for (const auto& worker : this->workers)
+   {
+      std::lock_guard lock (worker->stats_mutex);
+      stats.latency.merge(worker->latency);
+      stats.completed += worker->completed;
+      stats.failed += worker->failed;
+      stats.stolen += worker->stolen;
+   }
+
+   std::chrono::duration<double> elapsed = Clock::now() - this->started;
+   stats.throughput = (elapsed.count() > 0.0 ? stats.completed / elapsed.count() : 0.0);
+   return stats;
+}
+
+void ScriptService::work(size_t index)
+{
+   current_service = this;
+   current_worker = index;
+
+   auto& worker = *this->workers[index];
+   ErrorSink ignore = [](const char*) {};
+   Task task;
+   bool stolen = false;
+
+   while (true)
+   {
+      if (take(index, task, stolen))
+      {
+         bool success = false;
+
+         {
+            auto result = task.request.script->run(task.request.inputs, ignore, &worker.arena);
+            success = result.success;
+
+            if (task.request.done)
+               task.request.done(result);
+         }
+
+         auto latency = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - task.submitted).count();
+         task = Task();
+         worker.arena.reset();
+
+         {
+            std::lock_guard lock (worker.stats_mutex);
+            worker.latency.record(latency);
+            ++worker.completed;
+            worker.failed += !success;
+            worker.stolen += stolen;
+         }
+
+         if (--this->unfinished == 0)
+         {
+            std::lock_guard lock (this->done_mutex);
+            this->all_done.notify_all();
+         }
+         continue;
+      }
+
+      std::unique_lock lock (this->idle_mutex);
+      ++this->sleeping;
+      this->idle.wait(lock, [this]() { return this->stopping || this->queued > 0; });
+      --this->sleeping;
+
+      if (this->stopping && this->queued == 0)
+         return;
+   }
+}
+
+bool ScriptService::take(size_t index, Task& task, bool& stolen)
+{
+   auto& own = *this->workers[index];
+
+   {
+      std::lock_guard lock (own.mutex);
+
+      if (!own.tasks.empty())
+      {
+         task = std::move(own.tasks.front());
+         own.tasks.pop_front();
+         --this->queued;
+         stolen = false;
+         return true;
+      }
+   }
+
+   // Victims that are busy with their deque are skipped, not waited for.
+   for (size_t i = 1; i < this->workers.size(); ++i)
+   {
+      auto& other = *this->workers[(index + i) % this->workers.size()];
+      std::unique_lock lock (other.mutex, std::try_to_lock);
+
+      if (lock.owns_lock() && !other.tasks.empty())
+      {
+         task = std::move(other.tasks.back());
+         other.tasks.pop_back();
+         --this->queued;
+         stolen = true;
+         return true;
+      }
+   }
+   return false;
+}
@@ -0,0 +1,151 @@
+#include "script/session.hpp"
+#include "lexer/lexer.hpp"
+#include "parser/parser.hpp"
+#include "parser/flat_ast.hpp"
+#include "resolver/resolver.hpp"
+#include "resolver/type_checker.hpp"
+#include "runtime/evaluator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+   using Clock = std::chrono::high_resolution_clock;
+
+   long nanoseconds(Clock::time_point start, Clock::time_point end)
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+   }
+} // namespace
+
+long Session::LineTimes::total() const
+{
+   return this->lex + this->preprocess + this->parse + this->resolve + this->check + this->evaluate;
+}
+
+Session::Session(Catcher& catcher)
+   : catcher(catcher), preprocessor(catcher, this->tokens, "", false) {}
+
+bool Session::run(std::string line)
+{
+   this->line_times = LineTimes();
+   auto& times = this->line_times;
+
+   auto start = Clock::now();
+   Lexer lexer (this->catcher, line);
+   this->tokens = std::move(lexer.tokenize());
+   auto end = Clock::now();
+   times.lex = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   start = Clock::now();
+   this->preprocessor.refill();
+   this->preprocessor.process();
+   end = Clock::now();
+   times.preprocess = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   start = Clock::now();
+   Parser parser (this->catcher, this->tokens);
+   auto& program = parser.parse();
+   end = Clock::now();
+   times.parse = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   // The variables of earlier lines that this one names get the first slots.
+   std::vector<std::pair<std::string_view, Variable*>> used;
+
+   for (const auto& token : this->tokens)
+   {
+      if (token.type != TType::identifier)
+         continue;
+
+      auto it = this->variables.find(token.lexeme);
+      if (it != this->variables.end() && std::none_of(used.begin(), used.end(), [&](const auto& bound) { return bound.second == &it->second; }))
+         used.emplace_back(it->first, &it->second);
+   }
+
+   start = Clock::now();
+   Resolver resolver (this->catcher, program);
+   for (const auto& [name, variable] : used)
+      resolver.define(name, variable->con, variable->mut);
+   resolver.resolve();
+   end = Clock::now();
+   times.resolve = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   start = Clock::now();
+   TypeChecker checker (this->catcher, program);
+   for (std::uint32_t i = 0; i < used.size(); ++i)
+      checker.define(i, used[i].second->type);
+   checker.check();
+   end = Clock::now();
+   times.check = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   start = Clock::now();
+   auto flat = flatten(program);
+   Evaluator evaluator (this->catcher, flat.view());
+   for (std::uint32_t i = 0; i < used.size(); ++i)
+      evaluator.define(i, used[i].second->value, used[i].second->type);
+   evaluator.evaluate();
+   end = Clock::now();
+   times.evaluate = nanoseconds(start, end);
+
+   if (this->catcher.display())
+      return false;
+
+   // The line succeeded, earlier variables take their new values and its declarations
+   // replace the variables they shadow.
+   for (std::uint32_t i = 0; i < used.size(); ++i)
+   {
+      if (auto value = evaluator.value(i))
+         used[i].second->value = *value;
+   }
+
+   for (auto stmt : program.statements)
+   {
+      if (stmt->type() != StmtType::var_decl)
+         continue;
+
+      auto* decl = static_cast<VarDeclaration*>(stmt);
+      auto* type = static_cast<TypeExpr*>(decl->ttype);
+      auto name = intern(decl->identifier);
+      Value value = *evaluator.value(decl->slot);
+
+      // 'let' keeps the type of its initial value.
+      auto vtype = (type->automatic ? type_of(value) : type_from_name(type->ttype));
+
+      this->variables.insert_or_assign(name, Variable {vtype, type->con, type->mut, std::move(value)});
+   }
+
+   for (const auto& [name, value] : evaluator.variables())
+      std::cout << "[" << name << "] = " << to_string(value) << "\n";
+   return true;
+}
+
+const Session::LineTimes& Session::times() const
+{
+   return this->line_times;
+}
+
+size_t Session::variable_count() const
+{
+   return this->variables.size();
+}
+
+std::string_view Session::intern(std::string_view name)
+{
+   return *this->symbols.emplace(name).first;
+}